@@ -1,6 +1,7 @@
 UNAME=$(shell uname)
 DEBUG=1
 COVERAGE=0
+DEBUG_AGGREGATES=0
 INSTALL=install
 FLEX=flex
 BISON=bison
@@ -57,6 +58,12 @@ I3_CPPFLAGS += -DMINOR_VERSION=${MINOR_VERSION}
 I3_CPPFLAGS += -DPATCH_VERSION=${PATCH_VERSION}
 I3_CPPFLAGS += -DSYSCONFDIR=\"${SYSCONFDIR}\"
 I3_CPPFLAGS += -DI3__FILE__=__FILE__
+ifeq ($(DEBUG_AGGREGATES),1)
+# Cross-check the incrementally maintained per-container aggregates before
+# every render (walks the whole tree, so only for hunting down bugs) and log
+# child counts or sizes which do not add up while rendering
+I3_CPPFLAGS += -DDEBUG_AGGREGATES
+endif
 
 
 ## Libraries flags
@@ -4,7 +4,8 @@
  * i3 - an improved dynamic tiling window manager
  * © 2009-2012 Michael Stapelberg and contributors (see also: LICENSE)
  *
- * i3-dump-log/main.c: Dumps the i3 SHM log to stdout.
+ * i3-dump-log/main.c: Dumps the i3 SHM log to stdout (or exports it as a
+ *                     binary file).
  *
  */
 #include <stdio.h>
@@ -23,6 +24,9 @@
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <locale.h>
 
 #include "libi3.h"
 #include "shmlog.h"
@@ -35,6 +39,113 @@ static i3_shmlog_header *header;
 static char *logbuffer,
             *walk;
 
+/* Only lines whose location (the "file:function" of DLOG messages) starts
+ * with this prefix are printed (--match). */
+static char *match_prefix;
+static size_t match_prefix_len;
+
+/* How often the log is copied before giving up on getting a consistent
+ * snapshot because i3 logs all the time. */
+#define MAX_TRIES 10
+
+/* Below this many bytes, --since scans line by line instead of bisecting. */
+#define SEEK_LINEAR_THRESHOLD 8192
+
+/* Output is collected in an iovec array and written with one writev() call
+ * per batch, directly from the log buffer. */
+#if defined(IOV_MAX)
+#define OUTPUT_IOVECS IOV_MAX
+#else
+#define OUTPUT_IOVECS 16
+#endif
+static struct iovec output[OUTPUT_IOVECS];
+static int output_count;
+
+/* A range of complete lines in the log buffer. */
+struct range {
+    char *start;
+    char *end;
+};
+
+static void flush_output(void) {
+    struct iovec *iov = output;
+    int count = output_count;
+    while (count > 0) {
+        ssize_t n = writev(STDOUT_FILENO, iov, count);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            err(EXIT_FAILURE, "writev()");
+        }
+        /* Skip everything which was written, possibly in the middle of an
+         * iovec. */
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    output_count = 0;
+}
+
+static void queue_output(char *start, char *end) {
+    if (start == end)
+        return;
+
+    /* Adjacent lines are written as one block. */
+    if (output_count > 0) {
+        struct iovec *last = &output[output_count - 1];
+        if ((char*)last->iov_base + last->iov_len == start) {
+            last->iov_len += (end - start);
+            return;
+        }
+    }
+
+    if (output_count == OUTPUT_IOVECS)
+        flush_output();
+    output[output_count].iov_base = start;
+    output[output_count].iov_len = (end - start);
+    output_count++;
+}
+
+/*
+ * Returns true if the line (which ends at end, excluding the newline) is a
+ * DLOG message from a location which starts with match_prefix.
+ *
+ */
+static bool line_matches(const char *line, const char *end) {
+    /* Skip the timestamp ("%x %X - "). */
+    const char *location = memmem(line, end - line, " - ", strlen(" - "));
+    if (location == NULL)
+        return false;
+    location += strlen(" - ");
+    return ((size_t)(end - location) >= match_prefix_len &&
+            strncmp(location, match_prefix, match_prefix_len) == 0);
+}
+
+/*
+ * Queues the lines between start and end for output, applying --match.
+ *
+ */
+static void print_lines(char *start, char *end) {
+    if (match_prefix == NULL) {
+        queue_output(start, end);
+        return;
+    }
+
+    while (start < end) {
+        char *eol = memchr(start, '\n', end - start);
+        char *next = (eol == NULL ? end : eol + 1);
+        if (line_matches(start, (eol == NULL ? end : eol)))
+            queue_output(start, next);
+        start = next;
+    }
+}
+
 static int check_for_wrap(void) {
     if (wrap_count == header->wrap_count)
         return 0;
@@ -42,38 +153,282 @@ static int check_for_wrap(void) {
     /* The log wrapped. Print the remaining content and reset walk to the top
      * of the log. */
     wrap_count = header->wrap_count;
-    const int len = (logbuffer + header->offset_last_wrap) - walk;
-    if (write(STDOUT_FILENO, walk, len) != len)
-        err(EXIT_FAILURE, "write()");
+    print_lines(walk, logbuffer + header->offset_last_wrap);
     walk = logbuffer + sizeof(i3_shmlog_header);
     return 1;
 }
 
 static void print_till_end(void) {
     check_for_wrap();
-    const int len = (logbuffer + header->offset_next_write) - walk;
-    const int n = write(STDOUT_FILENO, walk, len);
-    if (len != n)
-        err(EXIT_FAILURE, "write()");
-    if (n > 0) {
-        walk += n;
+    char *end = logbuffer + header->offset_next_write;
+    print_lines(walk, end);
+    flush_output();
+    walk = end;
+}
+
+/*
+ * Returns true if the header describes a ring buffer which fits into size
+ * bytes (guards against truncated or garbage --file input).
+ *
+ */
+static bool header_valid(const i3_shmlog_header *log, size_t size) {
+    return (log->size >= sizeof(i3_shmlog_header) &&
+            log->size <= size &&
+            log->offset_next_write >= sizeof(i3_shmlog_header) &&
+            log->offset_next_write <= log->size &&
+            log->offset_last_wrap >= sizeof(i3_shmlog_header) &&
+            log->offset_last_wrap <= log->size);
+}
+
+/*
+ * Copies the whole segment (header and ring buffer) in one go. The copy is
+ * retried when i3 logged something in the meantime, so that the header
+ * matches the copied lines.
+ *
+ */
+static char *copy_snapshot(size_t size) {
+    char *snapshot = smalloc(size);
+    for (int tries = 0; tries < MAX_TRIES; tries++) {
+        const uint32_t next_write = header->offset_next_write,
+                       wraps = header->wrap_count;
+        __sync_synchronize();
+        memcpy(snapshot, logbuffer, size);
+        __sync_synchronize();
+        if (header->offset_next_write == next_write && header->wrap_count == wraps)
+            break;
+    }
+
+    /* The condvar is meaningless outside of i3’s segment. */
+    memset(&(((i3_shmlog_header*)snapshot)->condvar), 0, sizeof(pthread_cond_t));
+    return snapshot;
+}
+
+/*
+ * Returns the ranges of (complete) lines in the given log, oldest first.
+ *
+ */
+static int get_ranges(char *log, struct range ranges[2]) {
+    i3_shmlog_header *log_header = (i3_shmlog_header*)log;
+    int num_ranges = 0;
+
+    /* We first need the old content in case there was at least one wrapping
+     * already. */
+    if (log_header->wrap_count != 0) {
+        char *start = log + log_header->offset_next_write,
+             *end = log + log_header->offset_last_wrap;
+        /* Skip the first old line, it very likely is mangled. Not a problem,
+         * though, the log is chatty enough to have plenty lines left. */
+        if (start < end && *start != '\0') {
+            char *eol = memchr(start, '\n', end - start);
+            start = (eol == NULL ? end : eol + 1);
+        }
+        if (start < end)
+            ranges[num_ranges++] = (struct range){start, end};
+    }
+
+    /* Then the newer lines from the beginning. */
+    ranges[num_ranges++] = (struct range){
+        log + sizeof(i3_shmlog_header),
+        log + log_header->offset_next_write};
+    return num_ranges;
+}
+
+/*
+ * Parses the timestamp which vlog() prefixes to every line.
+ *
+ */
+static bool line_timestamp(const char *line, const char *end, time_t *result) {
+    /* strptime() needs a NUL-terminated string. */
+    char buffer[128];
+    size_t len = (end - line);
+    if (len > sizeof(buffer) - 1)
+        len = sizeof(buffer) - 1;
+    memcpy(buffer, line, len);
+    buffer[len] = '\0';
+
+    struct tm tm;
+    memset(&tm, 0, sizeof(struct tm));
+    const char *rest = strptime(buffer, "%x %X - ", &tm);
+    if (rest == NULL)
+        return false;
+    tm.tm_isdst = -1;
+    *result = mktime(&tm);
+    return true;
+}
+
+static char *next_line(char *line, char *end) {
+    char *eol = memchr(line, '\n', end - line);
+    return (eol == NULL ? end : eol + 1);
+}
+
+/*
+ * Returns the first line between start and end (both line starts) whose
+ * timestamp is not before since, or end if there is none. Since lines are
+ * stored in chronological order, this bisects instead of parsing every line.
+ * Lines without timestamp (continuations of multi-line messages) are never
+ * returned.
+ *
+ */
+static char *seek_since(char *start, char *end, time_t since) {
+    /* Invariant: lo is start or a line older than since, hi is end or a line
+     * which is not older than since. */
+    char *lo = start,
+         *hi = end;
+    while (hi - lo > SEEK_LINEAR_THRESHOLD) {
+        char *candidate = next_line(lo + (hi - lo) / 2, hi);
+        char *line = candidate;
+        time_t timestamp;
+        while (line < hi && !line_timestamp(line, hi, &timestamp))
+            line = next_line(line, hi);
+        if (line == hi)
+            hi = candidate;
+        else if (timestamp < since)
+            lo = line;
+        else
+            hi = line;
+    }
+
+    for (char *line = lo; line < hi; line = next_line(line, hi)) {
+        time_t timestamp;
+        if (line_timestamp(line, hi, &timestamp) && timestamp >= since)
+            return line;
+    }
+    return hi;
+}
+
+/*
+ * Parses the argument of --since: either a full timestamp in the format of the
+ * log ("%x %X", depends on the locale) or a time of today.
+ *
+ */
+static time_t parse_since(const char *arg) {
+    static const char *formats[] = {"%x %X", "%X", "%H:%M:%S", "%H:%M"};
+    const time_t now = time(NULL);
+    for (size_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        struct tm tm;
+        localtime_r(&now, &tm);
+        tm.tm_sec = 0;
+        const char *rest = strptime(arg, formats[i], &tm);
+        if (rest == NULL || *rest != '\0')
+            continue;
+        tm.tm_isdst = -1;
+        return mktime(&tm);
+    }
+    errx(EXIT_FAILURE, "Cannot parse --since \"%s\", expected e.g. \"%s\" or \"HH:MM[:SS]\"",
+         arg, "%x %X");
+}
+
+/*
+ * Writes len bytes to fd. When fd is a pipe, the pages are spliced into it
+ * instead of being copied (the buffer must not be modified afterwards).
+ *
+ */
+static void write_all(int fd, const char *buf, size_t len) {
+#if defined(__linux__)
+    while (len > 0) {
+        struct iovec iov = {(void*)buf, len};
+        ssize_t n = vmsplice(fd, &iov, 1, 0);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            /* Not a pipe, fall back to write(). */
+            break;
+        }
+        buf += n;
+        len -= n;
+    }
+#endif
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            err(EXIT_FAILURE, "write()");
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+/*
+ * Writes the snapshot (header and ring buffer) to the given file, or to
+ * stdout if path is "-". Files are written under a temporary name and then
+ * renamed, so that they are either complete or not there at all.
+ *
+ */
+static void export_snapshot(const char *path, const char *snapshot, size_t size) {
+    if (strcmp(path, "-") == 0) {
+        write_all(STDOUT_FILENO, snapshot, size);
+        return;
     }
+
+    char *tmppath;
+    sasprintf(&tmppath, "%s.XXXXXX", path);
+    int fd = mkstemp(tmppath);
+    if (fd == -1)
+        err(EXIT_FAILURE, "mkstemp(%s)", tmppath);
+    write_all(fd, snapshot, size);
+    if (fsync(fd) != 0 || close(fd) != 0) {
+        unlink(tmppath);
+        err(EXIT_FAILURE, "Could not write %s", tmppath);
+    }
+    if (rename(tmppath, path) != 0) {
+        unlink(tmppath);
+        err(EXIT_FAILURE, "rename(%s, %s)", tmppath, path);
+    }
+    free(tmppath);
+}
+
+/*
+ * Maps a file which was written with --export.
+ *
+ */
+static char *map_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        err(EXIT_FAILURE, "open(%s)", path);
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) != 0)
+        err(EXIT_FAILURE, "stat(%s)", path);
+    if ((size_t)statbuf.st_size < sizeof(i3_shmlog_header))
+        errx(EXIT_FAILURE, "%s is not an i3-dump-log export (too small)", path);
+
+    char *mapping = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+        err(EXIT_FAILURE, "Could not mmap %s", path);
+    close(fd);
+
+    if (!header_valid((i3_shmlog_header*)mapping, statbuf.st_size))
+        errx(EXIT_FAILURE, "%s is not an i3-dump-log export (invalid header)", path);
+    *size = statbuf.st_size;
+    return mapping;
 }
 
 int main(int argc, char *argv[]) {
     int o, option_index = 0;
     bool verbose = false,
          follow = false;
+    char *export_path = NULL,
+         *file_path = NULL;
+    bool use_since = false;
+    time_t since = 0;
 
     static struct option long_options[] = {
         {"version", no_argument, 0, 'v'},
         {"verbose", no_argument, 0, 'V'},
         {"follow", no_argument, 0, 'f'},
+        {"export", required_argument, 0, 'e'},
+        {"file", required_argument, 0, 'F'},
+        {"since", required_argument, 0, 't'},
+        {"match", required_argument, 0, 'm'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
-    char *options_string = "s:vfVh";
+    char *options_string = "s:vfVe:F:t:m:h";
+
+    setlocale(LC_ALL, "");
 
     while ((o = getopt_long(argc, argv, options_string, long_options, &option_index)) != -1) {
         if (o == 'v') {
@@ -83,91 +438,126 @@ int main(int argc, char *argv[]) {
             verbose = true;
         } else if (o == 'f') {
             follow = true;
+        } else if (o == 'e') {
+            export_path = optarg;
+        } else if (o == 'F') {
+            file_path = optarg;
+        } else if (o == 't') {
+            use_since = true;
+            since = parse_since(optarg);
+        } else if (o == 'm') {
+            match_prefix = optarg;
+            match_prefix_len = strlen(optarg);
         } else if (o == 'h') {
             printf("i3-dump-log " I3_VERSION "\n");
-            printf("i3-dump-log [-f] [-s <socket>]\n");
+            printf("i3-dump-log [-f] [-s <socket>] [-F <file>] [-t <time>] [-m <prefix>]\n");
+            printf("i3-dump-log [-F <file>] -e <file>|-\n");
             return 0;
         }
     }
 
-    char *shmname = root_atom_contents("I3_SHMLOG_PATH");
-    if (shmname == NULL) {
-        /* Something failed. Let’s invest a little effort to find out what it
-         * is. This is hugely helpful for users who want to debug i3 but are
-         * not used to the procedure yet. */
-        xcb_connection_t *conn;
-        int screen;
-        if ((conn = xcb_connect(NULL, &screen)) == NULL ||
-            xcb_connection_has_error(conn)) {
-            fprintf(stderr, "i3-dump-log: ERROR: Cannot connect to X11.\n\n");
-            if (getenv("DISPLAY") == NULL) {
-                fprintf(stderr, "Your DISPLAY environment variable is not set.\n");
-                fprintf(stderr, "Are you running i3-dump-log via SSH or on a virtual console?\n");
-                fprintf(stderr, "Try DISPLAY=:0 i3-dump-log\n");
+    if (follow && (file_path != NULL || export_path != NULL))
+        errx(EXIT_FAILURE, "--follow cannot be combined with --file or --export");
+
+    size_t size;
+    if (file_path != NULL) {
+        logbuffer = map_file(file_path, &size);
+    } else {
+        char *shmname = root_atom_contents("I3_SHMLOG_PATH");
+        if (shmname == NULL) {
+            /* Something failed. Let’s invest a little effort to find out what it
+             * is. This is hugely helpful for users who want to debug i3 but are
+             * not used to the procedure yet. */
+            xcb_connection_t *conn;
+            int screen;
+            if ((conn = xcb_connect(NULL, &screen)) == NULL ||
+                xcb_connection_has_error(conn)) {
+                fprintf(stderr, "i3-dump-log: ERROR: Cannot connect to X11.\n\n");
+                if (getenv("DISPLAY") == NULL) {
+                    fprintf(stderr, "Your DISPLAY environment variable is not set.\n");
+                    fprintf(stderr, "Are you running i3-dump-log via SSH or on a virtual console?\n");
+                    fprintf(stderr, "Try DISPLAY=:0 i3-dump-log\n");
+                    exit(1);
+                }
+                fprintf(stderr, "FYI: The DISPLAY environment variable is set to \"%s\".\n", getenv("DISPLAY"));
                 exit(1);
             }
-            fprintf(stderr, "FYI: The DISPLAY environment variable is set to \"%s\".\n", getenv("DISPLAY"));
-            exit(1);
-        }
-        if (root_atom_contents("I3_CONFIG_PATH") != NULL) {
-            fprintf(stderr, "i3-dump-log: ERROR: i3 is running, but SHM logging is not enabled.\n\n");
-            if (!is_debug_build()) {
-                fprintf(stderr, "You seem to be using a release version of i3:\n  %s\n\n", I3_VERSION);
-                fprintf(stderr, "Release versions do not use SHM logging by default,\ntherefore i3-dump-log does not work.\n\n");
-                fprintf(stderr, "Please follow this guide instead:\nhttp://i3wm.org/docs/debugging-release-version.html\n");
-                exit(1);
+            if (root_atom_contents("I3_CONFIG_PATH") != NULL) {
+                fprintf(stderr, "i3-dump-log: ERROR: i3 is running, but SHM logging is not enabled.\n\n");
+                if (!is_debug_build()) {
+                    fprintf(stderr, "You seem to be using a release version of i3:\n  %s\n\n", I3_VERSION);
+                    fprintf(stderr, "Release versions do not use SHM logging by default,\ntherefore i3-dump-log does not work.\n\n");
+                    fprintf(stderr, "Please follow this guide instead:\nhttp://i3wm.org/docs/debugging-release-version.html\n");
+                    exit(1);
+                }
             }
+            errx(EXIT_FAILURE, "Cannot get I3_SHMLOG_PATH atom contents. Is i3 running on this display?");
         }
-        errx(EXIT_FAILURE, "Cannot get I3_SHMLOG_PATH atom contents. Is i3 running on this display?");
-    }
 
-    if (*shmname == '\0')
-        errx(EXIT_FAILURE, "Cannot dump log: SHM logging is disabled in i3.");
+        if (*shmname == '\0')
+            errx(EXIT_FAILURE, "Cannot dump log: SHM logging is disabled in i3.");
 
-    struct stat statbuf;
+        struct stat statbuf;
 
-    /* NB: While we must never write, we need O_RDWR for the pthread condvar. */
-    int logbuffer_shm = shm_open(shmname, O_RDWR, 0);
-    if (logbuffer_shm == -1)
-        err(EXIT_FAILURE, "Could not shm_open SHM segment for the i3 log (%s)", shmname);
+        /* NB: While we must never write, we need O_RDWR for the pthread condvar. */
+        int logbuffer_shm = shm_open(shmname, O_RDWR, 0);
+        if (logbuffer_shm == -1)
+            err(EXIT_FAILURE, "Could not shm_open SHM segment for the i3 log (%s)", shmname);
 
-    if (fstat(logbuffer_shm, &statbuf) != 0)
-        err(EXIT_FAILURE, "stat(%s)", shmname);
+        if (fstat(logbuffer_shm, &statbuf) != 0)
+            err(EXIT_FAILURE, "stat(%s)", shmname);
 
-    /* NB: While we must never write, we need PROT_WRITE for the pthread condvar. */
-    logbuffer = mmap(NULL, statbuf.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, logbuffer_shm, 0);
-    if (logbuffer == MAP_FAILED)
-        err(EXIT_FAILURE, "Could not mmap SHM segment for the i3 log");
+        /* NB: While we must never write, we need PROT_WRITE for the pthread condvar. */
+        logbuffer = mmap(NULL, statbuf.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, logbuffer_shm, 0);
+        if (logbuffer == MAP_FAILED)
+            err(EXIT_FAILURE, "Could not mmap SHM segment for the i3 log");
+        size = statbuf.st_size;
+
+        if (verbose)
+            fprintf(stderr, "shmname = %s\n", shmname);
+    }
 
     header = (i3_shmlog_header*)logbuffer;
 
-    if (verbose)
-        printf("next_write = %d, last_wrap = %d, logbuffer_size = %d, shmname = %s\n",
-               header->offset_next_write, header->offset_last_wrap, header->size, shmname);
-    walk = logbuffer + header->offset_next_write;
+    /* i3 keeps logging while we are dumping. Instead of following the ring
+     * buffer line by line, the whole segment is copied in one go and all
+     * further processing happens on that consistent snapshot. An export file
+     * is never modified, so it can be used directly. */
+    char *snapshot = (file_path != NULL ? logbuffer : copy_snapshot(size));
+    i3_shmlog_header *snapshot_header = (i3_shmlog_header*)snapshot;
+    if (!header_valid(snapshot_header, size))
+        errx(EXIT_FAILURE, "The SHM log header is invalid");
 
-    /* We first need to print old content in case there was at least one
-     * wrapping already. */
+    if (verbose)
+        fprintf(stderr, "next_write = %d, last_wrap = %d, logbuffer_size = %d, wrap_count = %d\n",
+                snapshot_header->offset_next_write, snapshot_header->offset_last_wrap,
+                snapshot_header->size, snapshot_header->wrap_count);
 
-    if (*walk != '\0') {
-        /* In case there was a write to the buffer already, skip the first
-         * old line, it very likely is mangled. Not a problem, though, the log
-         * is chatty enough to have plenty lines left. */
-        while (*walk != '\n')
-            walk++;
-        walk++;
+    if (export_path != NULL) {
+        export_snapshot(export_path, snapshot, size);
+        return 0;
     }
 
-    /* In case there was no wrapping, this is a no-op, otherwise it prints the
-     * old lines. */
-    wrap_count = 0;
-    check_for_wrap();
-
-    /* Then start from the beginning and print the newer lines */
-    walk = logbuffer + sizeof(i3_shmlog_header);
-    print_till_end();
+    struct range ranges[2];
+    const int num_ranges = get_ranges(snapshot, ranges);
+    bool found = !use_since;
+    for (int i = 0; i < num_ranges; i++) {
+        char *start = ranges[i].start;
+        if (!found) {
+            start = seek_since(start, ranges[i].end, since);
+            found = (start != ranges[i].end);
+        }
+        print_lines(start, ranges[i].end);
+    }
+    flush_output();
 
     if (follow) {
+        /* Continue with the live log where the snapshot ended. */
+        offset_next_write = snapshot_header->offset_next_write;
+        wrap_count = snapshot_header->wrap_count;
+        walk = logbuffer + offset_next_write;
+        print_till_end();
+
         /* Since pthread_cond_wait() expects a mutex, we need to provide one.
          * To not lock i3 (that’s bad, mhkay?) we just define one outside of
          * the shared memory. */
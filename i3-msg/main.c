@@ -27,6 +27,8 @@
 #include <stdint.h>
 #include <getopt.h>
 #include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
 
 #include <yajl/yajl_parse.h>
 #include <yajl/yajl_version.h>
@@ -35,6 +37,7 @@
 #include <xcb/xcb_aux.h>
 
 #include "libi3.h"
+#include "shmtree.h"
 #include <i3/ipc.h>
 
 static char *socket_path;
@@ -132,23 +135,328 @@ yajl_callbacks reply_callbacks = {
     NULL
 };
 
+#define y(x, ...) json_writer_ ## x (&gen, ##__VA_ARGS__)
+#define ystr(str) json_writer_string(&gen, str)
+#define ykey(key) json_writer_key(&gen, key)
+
+/*
+ * Prints the tree snapshot which i3 publishes in shared memory as JSON: a flat
+ * array of all containers in pre-order, with the parent/focus relations given
+ * as container IDs. This does not talk to i3 at all.
+ *
+ */
+static int dump_snapshot(void) {
+    char *shmname = root_atom_contents("I3_SHMTREE_PATH");
+    if (shmname == NULL || *shmname == '\0')
+        errx(EXIT_FAILURE, "Cannot get I3_SHMTREE_PATH atom contents. Is i3 running on this display?");
+
+    shmtree_reader reader;
+    if (!shmtree_open(&reader, shmname))
+        err(EXIT_FAILURE, "Could not open the tree snapshot \"%s\"", shmname);
+
+    const i3_shmtree_header *snapshot = shmtree_read(&reader);
+    if (snapshot == NULL)
+        errx(EXIT_FAILURE, "No (compatible) tree snapshot in \"%s\"", shmname);
+
+    const i3_shmtree_node *nodes = I3_SHMTREE_NODES(snapshot);
+    json_writer gen = { 0 };
+    y(map_open);
+    ykey("sequence");
+    y(integer, snapshot->sequence);
+    ykey("focused");
+    if (snapshot->focused == I3_SHMTREE_NONE)
+        y(null);
+    else y(integer, nodes[snapshot->focused].id);
+
+    ykey("nodes");
+    y(array_open);
+    for (uint32_t c = 0; c < snapshot->num_nodes; c++) {
+        const i3_shmtree_node *node = &nodes[c];
+        y(map_open);
+        ykey("id");
+        y(integer, node->id);
+        ykey("parent");
+        if (node->parent == I3_SHMTREE_NONE)
+            y(null);
+        else y(integer, nodes[node->parent].id);
+        ykey("focus");
+        if (node->focus_child == I3_SHMTREE_NONE)
+            y(null);
+        else y(integer, nodes[node->focus_child].id);
+        ykey("type");
+        y(integer, node->type);
+        ykey("layout");
+        y(integer, node->layout);
+        if (node->num != -1) {
+            ykey("num");
+            y(integer, node->num);
+        }
+        ykey("window");
+        if (node->window == 0)
+            y(null);
+        else y(integer, node->window);
+        ykey("name");
+        json_writer_string_len(&gen, I3_SHMTREE_NAME(snapshot, node), node->name_length);
+        ykey("urgent");
+        y(bool, (node->flags & I3_SHMTREE_URGENT));
+        ykey("focused");
+        y(bool, (node->flags & I3_SHMTREE_FOCUSED));
+        ykey("floating");
+        y(bool, (node->flags & I3_SHMTREE_FLOATING));
+        ykey("fullscreen");
+        y(bool, (node->flags & I3_SHMTREE_FULLSCREEN));
+        ykey("rect");
+        y(map_open);
+        ykey("x");
+        y(integer, node->rect.x);
+        ykey("y");
+        y(integer, node->rect.y);
+        ykey("width");
+        y(integer, node->rect.width);
+        ykey("height");
+        y(integer, node->rect.height);
+        y(map_close);
+        y(map_close);
+    }
+    y(array_close);
+    y(map_close);
+
+    const unsigned char *payload;
+    size_t length;
+    y(get_buf, &payload, &length);
+    printf("%.*s\n", (int)length, payload);
+
+    json_writer_free(&gen);
+    shmtree_close(&reader);
+    free(shmname);
+    return 0;
+}
+
+#undef y
+#undef ystr
+#undef ykey
+
+/*
+ * Prints the given reply. For the reply of commands, have a look if that
+ * command was successful. If not, nicely format the error message.
+ *
+ */
+static void print_reply(uint32_t reply_type, const uint8_t *reply, uint32_t reply_length) {
+    if (reply_type == I3_IPC_MESSAGE_TYPE_COMMAND) {
+        yajl_handle handle;
+#if YAJL_MAJOR < 2
+        yajl_parser_config parse_conf = { 0, 0 };
+
+        handle = yajl_alloc(&reply_callbacks, &parse_conf, NULL, NULL);
+#else
+        handle = yajl_alloc(&reply_callbacks, NULL, NULL);
+#endif
+        yajl_status state = yajl_parse(handle, (const unsigned char*)reply, reply_length);
+        switch (state) {
+            case yajl_status_ok:
+                break;
+            case yajl_status_client_canceled:
+#if YAJL_MAJOR < 2
+            case yajl_status_insufficient_data:
+#endif
+            case yajl_status_error:
+                errx(EXIT_FAILURE, "IPC: Could not parse JSON reply.");
+        }
+        yajl_free(handle);
+
+        /* NB: We still fall-through and print the reply, because even if one
+         * command failed, that doesn’t mean that all commands failed. */
+    }
+    printf("%.*s\n", reply_length, reply);
+}
+
+/* A growing byte buffer, used for the pipelined mode. */
+struct buffer {
+    char *data;
+    size_t used;
+    size_t size;
+};
+
+static void buffer_append(struct buffer *buffer, const void *data, size_t length) {
+    if (buffer->used + length > buffer->size) {
+        while (buffer->used + length > buffer->size)
+            buffer->size = (buffer->size == 0 ? 4096 : buffer->size * 2);
+        buffer->data = srealloc(buffer->data, buffer->size);
+    }
+    memcpy(buffer->data + buffer->used, data, length);
+    buffer->used += length;
+}
+
+static void buffer_consume(struct buffer *buffer, size_t length) {
+    buffer->used -= length;
+    memmove(buffer->data, buffer->data + length, buffer->used);
+}
+
+static void queue_message(struct buffer *out, uint32_t type, const char *payload, uint32_t length) {
+    i3_ipc_header_t header;
+    memcpy(header.magic, I3_IPC_MAGIC, strlen(I3_IPC_MAGIC));
+    header.size = length;
+    header.type = type;
+    buffer_append(out, &header, sizeof(i3_ipc_header_t));
+    buffer_append(out, payload, length);
+}
+
+/*
+ * Queues one message for every complete (non-empty) line in the given
+ * buffer. If flush is true, the rest of the buffer is treated as a line, too.
+ * Returns the number of queued messages.
+ *
+ */
+static uint32_t queue_lines(struct buffer *lines, struct buffer *out, uint32_t type, bool flush) {
+    uint32_t queued = 0;
+    size_t start = 0;
+    for (size_t c = 0; c < lines->used; c++) {
+        if (lines->data[c] != '\n')
+            continue;
+        if (c > start) {
+            queue_message(out, type, lines->data + start, c - start);
+            queued++;
+        }
+        start = c + 1;
+    }
+    if (flush && start < lines->used) {
+        queue_message(out, type, lines->data + start, lines->used - start);
+        queued++;
+        start = lines->used;
+    }
+    buffer_consume(lines, start);
+    return queued;
+}
+
+/*
+ * The --stdin and --subscribe mode: keeps the connection open and sends every
+ * line read from stdin as a message as soon as it is complete, without
+ * waiting for the replies of the previous messages. i3 handles the messages
+ * of a client in order, so the replies are printed in the order of the input
+ * lines. With --subscribe, events are printed (one per line) until i3 closes
+ * the connection.
+ *
+ */
+static int run_pipelined(int sockfd, uint32_t message_type, bool read_stdin,
+                         const char *subscribe, bool quiet) {
+    struct buffer in = { 0 }, out = { 0 }, lines = { 0 };
+    uint32_t outstanding = 0;
+    bool stdin_open = read_stdin;
+
+    if (fcntl(sockfd, F_SETFL, O_NONBLOCK) == -1)
+        err(EXIT_FAILURE, "Could not set O_NONBLOCK");
+
+    if (subscribe != NULL) {
+        queue_message(&out, I3_IPC_MESSAGE_TYPE_SUBSCRIBE, subscribe, strlen(subscribe));
+        outstanding++;
+    }
+
+    while (stdin_open || out.used > 0 || outstanding > 0 || subscribe != NULL) {
+        struct pollfd fds[2];
+        nfds_t nfds = 1;
+        fds[0].fd = sockfd;
+        fds[0].events = POLLIN | (out.used > 0 ? POLLOUT : 0);
+        if (stdin_open) {
+            fds[1].fd = STDIN_FILENO;
+            fds[1].events = POLLIN;
+            nfds++;
+        }
+
+        if (poll(fds, nfds, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            err(EXIT_FAILURE, "poll()");
+        }
+
+        if (fds[0].revents & POLLOUT) {
+            ssize_t n = write(sockfd, out.data, out.used);
+            if (n == -1 && errno != EAGAIN && errno != EINTR)
+                err(EXIT_FAILURE, "IPC: write()");
+            if (n > 0)
+                buffer_consume(&out, n);
+        }
+
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            char chunk[4096];
+            ssize_t n = read(sockfd, chunk, sizeof(chunk));
+            if (n == -1 && errno != EAGAIN && errno != EINTR)
+                err(EXIT_FAILURE, "IPC: read()");
+            if (n == 0) {
+                if (outstanding > 0)
+                    errx(EXIT_FAILURE, "IPC: i3 closed the connection, %d replies are missing", outstanding);
+                break;
+            }
+            if (n > 0)
+                buffer_append(&in, chunk, n);
+
+            /* Handle all complete messages */
+            while (in.used >= sizeof(i3_ipc_header_t)) {
+                i3_ipc_header_t header;
+                memcpy(&header, in.data, sizeof(i3_ipc_header_t));
+                if (strncmp(header.magic, I3_IPC_MAGIC, strlen(I3_IPC_MAGIC)) != 0)
+                    errx(EXIT_FAILURE, "IPC: invalid magic in reply");
+                if (in.used - sizeof(i3_ipc_header_t) < header.size)
+                    break;
+
+                const uint8_t *payload = (uint8_t*)in.data + sizeof(i3_ipc_header_t);
+                if (header.type & (1 << 31)) {
+                    /* An event. i3 sends events only after SUBSCRIBE. */
+                    printf("%.*s\n", header.size, payload);
+                } else {
+                    if (outstanding == 0)
+                        errx(EXIT_FAILURE, "IPC: Received an unexpected reply of type %d", header.type);
+                    outstanding--;
+                    if (header.type != message_type && header.type != I3_IPC_MESSAGE_TYPE_SUBSCRIBE)
+                        errx(EXIT_FAILURE, "IPC: Received reply of type %d but expected %d", header.type, message_type);
+                    if (!quiet)
+                        print_reply(header.type, payload, header.size);
+                }
+                buffer_consume(&in, sizeof(i3_ipc_header_t) + header.size);
+            }
+            fflush(stdout);
+        }
+
+        if (stdin_open && (fds[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+            char chunk[4096];
+            ssize_t n = read(STDIN_FILENO, chunk, sizeof(chunk));
+            if (n == -1 && errno != EAGAIN && errno != EINTR)
+                err(EXIT_FAILURE, "read() from stdin");
+            if (n > 0)
+                buffer_append(&lines, chunk, n);
+            if (n == 0)
+                stdin_open = false;
+            outstanding += queue_lines(&lines, &out, message_type, !stdin_open);
+        }
+    }
+
+    free(in.data);
+    free(out.data);
+    free(lines.data);
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     socket_path = getenv("I3SOCK");
     int o, option_index = 0;
     int message_type = I3_IPC_MESSAGE_TYPE_COMMAND;
     char *payload = NULL;
     bool quiet = false;
+    bool read_stdin = false;
+    bool subscribe = false;
 
     static struct option long_options[] = {
         {"socket", required_argument, 0, 's'},
         {"type", required_argument, 0, 't'},
         {"version", no_argument, 0, 'v'},
         {"quiet", no_argument, 0, 'q'},
+        {"snapshot", no_argument, 0, 'S'},
+        {"stdin", no_argument, 0, 'i'},
+        {"subscribe", no_argument, 0, 'm'},
         {"help", no_argument, 0, 'h'},
         {0, 0, 0, 0}
     };
 
-    char *options_string = "s:t:vhq";
+    char *options_string = "s:t:vhqSim";
 
     while ((o = getopt_long(argc, argv, options_string, long_options, &option_index)) != -1) {
         if (o == 's') {
@@ -170,19 +478,32 @@ int main(int argc, char *argv[]) {
                 message_type = I3_IPC_MESSAGE_TYPE_GET_BAR_CONFIG;
             else if (strcasecmp(optarg, "get_version") == 0)
                 message_type = I3_IPC_MESSAGE_TYPE_GET_VERSION;
+            else if (strcasecmp(optarg, "get_stats") == 0)
+                message_type = I3_IPC_MESSAGE_TYPE_GET_STATS;
+            else if (strcasecmp(optarg, "command_batch") == 0)
+                message_type = I3_IPC_MESSAGE_TYPE_COMMAND_BATCH;
             else {
                 printf("Unknown message type\n");
-                printf("Known types: command, get_workspaces, get_outputs, get_tree, get_marks, get_bar_config, get_version\n");
+                printf("Known types: command, get_workspaces, get_outputs, get_tree, get_marks, get_bar_config, get_version, get_stats, command_batch\n");
                 exit(EXIT_FAILURE);
             }
         } else if (o == 'q') {
             quiet = true;
+        } else if (o == 'S') {
+            return dump_snapshot();
+        } else if (o == 'i') {
+            read_stdin = true;
+        } else if (o == 'm') {
+            subscribe = true;
         } else if (o == 'v') {
             printf("i3-msg " I3_VERSION "\n");
             return 0;
         } else if (o == 'h') {
             printf("i3-msg " I3_VERSION "\n");
             printf("i3-msg [-s <socket>] [-t <type>] <message>\n");
+            printf("i3-msg [-s <socket>] [-t <type>] --stdin\n");
+            printf("i3-msg [-s <socket>] [--stdin] --subscribe <events>\n");
+            printf("i3-msg --snapshot\n");
             return 0;
         }
     }
@@ -213,6 +534,9 @@ int main(int argc, char *argv[]) {
     if (!payload)
         payload = "";
 
+    if (subscribe && *payload == '\0')
+        errx(EXIT_FAILURE, "--subscribe needs the events as JSON list, e.g. '[ \"window\" ]'");
+
     int sockfd = socket(AF_LOCAL, SOCK_STREAM, 0);
     if (sockfd == -1)
         err(EXIT_FAILURE, "Could not create socket");
@@ -224,6 +548,9 @@ int main(int argc, char *argv[]) {
     if (connect(sockfd, (const struct sockaddr*)&addr, sizeof(struct sockaddr_un)) < 0)
         err(EXIT_FAILURE, "Could not connect to i3 on socket \"%s\"", socket_path);
 
+    if (read_stdin || subscribe)
+        return run_pipelined(sockfd, message_type, read_stdin, (subscribe ? payload : NULL), quiet);
+
     if (ipc_send_message(sockfd, strlen(payload), message_type, (uint8_t*)payload) == -1)
         err(EXIT_FAILURE, "IPC: write()");
 
@@ -241,33 +568,7 @@ int main(int argc, char *argv[]) {
     }
     if (reply_type != message_type)
         errx(EXIT_FAILURE, "IPC: Received reply of type %d but expected %d", reply_type, message_type);
-    /* For the reply of commands, have a look if that command was successful.
-     * If not, nicely format the error message. */
-    if (reply_type == I3_IPC_MESSAGE_TYPE_COMMAND) {
-        yajl_handle handle;
-#if YAJL_MAJOR < 2
-        yajl_parser_config parse_conf = { 0, 0 };
-
-        handle = yajl_alloc(&reply_callbacks, &parse_conf, NULL, NULL);
-#else
-        handle = yajl_alloc(&reply_callbacks, NULL, NULL);
-#endif
-        yajl_status state = yajl_parse(handle, (const unsigned char*)reply, reply_length);
-        switch (state) {
-            case yajl_status_ok:
-                break;
-            case yajl_status_client_canceled:
-#if YAJL_MAJOR < 2
-            case yajl_status_insufficient_data:
-#endif
-            case yajl_status_error:
-                errx(EXIT_FAILURE, "IPC: Could not parse JSON reply.");
-        }
-
-        /* NB: We still fall-through and print the reply, because even if one
-         * command failed, that doesn’t mean that all commands failed. */
-    }
-    printf("%.*s\n", reply_length, reply);
+    print_reply(reply_type, reply, reply_length);
     free(reply);
 
     close(sockfd);
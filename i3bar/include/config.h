@@ -27,6 +27,7 @@ typedef struct config_t {
     int          disable_ws;
     char         *bar_id;
     char         *command;
+    int          status_interval;
     char         *fontname;
     char         *tray_output;
     int          num_outputs;
@@ -46,8 +46,15 @@ struct i3_output {
 
     xcb_window_t   bar;           /* The id of the bar of the output */
     xcb_pixmap_t   buffer;        /* An extra pixmap for double-buffering */
+    uint32_t       buffer_width;  /* The size of the buffer (it is only */
+    uint32_t       buffer_height; /* re-created when the size changes) */
     xcb_gcontext_t bargc;         /* The graphical context of the bar */
 
+    bool           buttons_valid; /* If the workspace buttons in the buffer */
+                                  /* are up to date */
+    uint32_t       buttons_width; /* The width of the workspace buttons (the */
+                                  /* statusline is drawn right of them) */
+
     struct ws_head *workspaces;   /* The workspaces on this output */
     struct tc_head *trayclients;  /* The tray clients on this output */
 
@@ -18,6 +18,7 @@ struct trayclient {
     xcb_window_t       win;         /* The window ID of the tray client */
     bool               mapped;      /* Whether this window is mapped */
     int                xe_version;  /* The XEMBED version supported by the client */
+    int                x;           /* The x coordinate the window was configured to */
 
     TAILQ_ENTRY(trayclient) tailq;  /* Pointer for the TAILQ-Macro */
 };
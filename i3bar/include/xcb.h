@@ -117,11 +117,27 @@ void realloc_sl_buffer(void);
 void reconfig_windows(void);
 
 /*
- * Render the bars, with buttons and statusline
+ * Marks the workspace buttons of all outputs as outdated, so that the next
+ * draw_bars() renders them again. Has to be called whenever the workspaces or
+ * the binding mode changed.
+ *
+ */
+void invalidate_workspace_buttons(void);
+
+/*
+ * Render the bars, with buttons and statusline. The workspace buttons are only
+ * rendered if they were invalidated, otherwise only the statusline is updated.
  *
  */
 void draw_bars(bool force_unhide);
 
+/*
+ * Prints the latency histogram of draw_bars() (in the same format as the
+ * latency statistics of i3’s GET_STATS reply) to stderr.
+ *
+ */
+void print_draw_stats(void);
+
 /*
  * Redraw the bars, i.e. simply copy the buffer to the barwindow
  *
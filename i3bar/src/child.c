@@ -32,6 +32,12 @@ i3bar_child child = { 0 };
 ev_io    *stdin_io;
 ev_child *child_sig;
 
+/* Timer which draws the latest statusline when config.status_interval is set
+ * and the previous one was drawn too recently. */
+ev_timer *statusline_timer;
+/* When the statusline was drawn last (see draw_statusline()) */
+static ev_tstamp last_statusline_draw;
+
 /* JSON parser for stdin */
 yajl_callbacks callbacks;
 yajl_handle parser;
@@ -40,9 +46,22 @@ yajl_handle parser;
 yajl_gen gen;
 
 typedef struct parser_ctx {
-    /* True if one of the parsed blocks was urgent */
+    /* True if one of the blocks of the statusline which is currently being
+     * parsed is urgent */
     bool has_urgent;
 
+    /* True if a complete statusline was parsed (and moved to
+     * statusline_head) since the last read_json_input() */
+    bool complete;
+    /* True if that statusline contained urgent blocks */
+    bool complete_urgent;
+
+    /* The blocks of the statusline which is currently being parsed. They
+     * replace statusline_head once the array is complete, so that a
+     * statusline which is split across multiple reads is never drawn
+     * half-way. */
+    struct statusline_head blocks;
+
     /* A copy of the last JSON map key. */
     char *last_map_key;
 
@@ -72,6 +91,11 @@ void cleanup(void) {
         statusline = NULL;
     }
 
+    if (statusline_timer != NULL) {
+        ev_timer_stop(main_loop, statusline_timer);
+        FREE(statusline_timer);
+    }
+
     if (child_sig != NULL) {
         ev_child_stop(main_loop, child_sig);
         FREE(child_sig);
@@ -81,21 +105,31 @@ void cleanup(void) {
 }
 
 /*
- * The start of a new array is the start of a new status line, so we clear all
- * previous entries.
+ * Frees all blocks of the given list.
  *
  */
-static int stdin_start_array(void *context) {
+static void free_blocks(struct statusline_head *head) {
     struct status_block *first;
-    while (!TAILQ_EMPTY(&statusline_head)) {
-        first = TAILQ_FIRST(&statusline_head);
+    while (!TAILQ_EMPTY(head)) {
+        first = TAILQ_FIRST(head);
         I3STRING_FREE(first->full_text);
         FREE(first->color);
         FREE(first->name);
         FREE(first->instance);
-        TAILQ_REMOVE(&statusline_head, first, blocks);
+        TAILQ_REMOVE(head, first, blocks);
         free(first);
     }
+}
+
+/*
+ * The start of a new array is the start of a new status line, so we clear all
+ * previous entries of the statusline which was being parsed.
+ *
+ */
+static int stdin_start_array(void *context) {
+    parser_ctx *ctx = context;
+    free_blocks(&(ctx->blocks));
+    ctx->has_urgent = false;
     return 1;
 }
 
@@ -200,11 +234,28 @@ static int stdin_end_map(void *context) {
         new_block->full_text = i3string_from_utf8("SPEC VIOLATION (null)");
     if (new_block->urgent)
         ctx->has_urgent = true;
-    TAILQ_INSERT_TAIL(&statusline_head, new_block, blocks);
+    TAILQ_INSERT_TAIL(&(ctx->blocks), new_block, blocks);
     return 1;
 }
 
+/*
+ * The end of an array is the end of a status line: its blocks replace the
+ * ones which are currently displayed.
+ *
+ */
 static int stdin_end_array(void *context) {
+    parser_ctx *ctx = context;
+    free_blocks(&statusline_head);
+    struct status_block *first;
+    while (!TAILQ_EMPTY(&(ctx->blocks))) {
+        first = TAILQ_FIRST(&(ctx->blocks));
+        TAILQ_REMOVE(&(ctx->blocks), first, blocks);
+        TAILQ_INSERT_TAIL(&statusline_head, first, blocks);
+    }
+    ctx->complete = true;
+    ctx->complete_urgent = ctx->has_urgent;
+    ctx->has_urgent = false;
+
     DLOG("dumping statusline:\n");
     struct status_block *current;
     TAILQ_FOREACH(current, &statusline_head, blocks) {
@@ -271,9 +322,14 @@ static void read_flat_input(char *buffer, int length) {
     first->full_text = i3string_from_utf8(buffer);
 }
 
-static bool read_json_input(unsigned char *input, int length) {
+/*
+ * Parses the given JSON input. Returns true if (at least) one complete
+ * statusline was parsed, has_urgent is set if the latest one contains urgent
+ * blocks.
+ *
+ */
+static bool read_json_input(unsigned char *input, int length, bool *has_urgent) {
     yajl_status status = yajl_parse(parser, input, length);
-    bool has_urgent = false;
 #if YAJL_MAJOR >= 2
     if (status != yajl_status_ok) {
 #else
@@ -281,10 +337,66 @@ static bool read_json_input(unsigned char *input, int length) {
 #endif
         fprintf(stderr, "[i3bar] Could not parse JSON input (code %d): %.*s\n",
                 status, length, input);
-    } else if (parser_context.has_urgent) {
-        has_urgent = true;
     }
-    return has_urgent;
+    const bool complete = parser_context.complete;
+    *has_urgent = parser_context.complete_urgent;
+    parser_context.complete = false;
+    parser_context.complete_urgent = false;
+    return complete;
+}
+
+/*
+ * Draws the bars with the current statusline.
+ *
+ */
+static void draw_statusline(bool has_urgent) {
+    last_statusline_draw = ev_now(main_loop);
+    draw_bars(has_urgent);
+}
+
+/*
+ * Callback for the statusline timer: draws the latest statusline once the
+ * configured interval has passed.
+ *
+ */
+static void statusline_timer_cb(struct ev_loop *loop, ev_timer *watcher, int revents) {
+    DLOG("Drawing the delayed statusline\n");
+    draw_statusline(false);
+}
+
+/*
+ * Draws the bars after the statusline changed. If config.status_interval is
+ * set and the last statusline was drawn less than that ago, the statusline
+ * is drawn by a timer instead, so that all updates until then only cause a
+ * single redraw. Urgent statuslines are always drawn right away.
+ *
+ */
+static void statusline_updated(bool has_urgent) {
+    if (config.status_interval <= 0 || has_urgent) {
+        if (statusline_timer != NULL)
+            ev_timer_stop(main_loop, statusline_timer);
+        draw_statusline(has_urgent);
+        return;
+    }
+
+    if (statusline_timer == NULL) {
+        statusline_timer = smalloc(sizeof(ev_timer));
+        ev_timer_init(statusline_timer, &statusline_timer_cb, 0., 0.);
+    }
+
+    /* A redraw is already scheduled, it will draw this statusline. */
+    if (ev_is_active(statusline_timer))
+        return;
+
+    const ev_tstamp interval = config.status_interval / 1000.0;
+    const ev_tstamp elapsed = ev_now(main_loop) - last_statusline_draw;
+    if (elapsed >= interval) {
+        draw_statusline(false);
+        return;
+    }
+
+    ev_timer_set(statusline_timer, interval - elapsed, 0.);
+    ev_timer_start(main_loop, statusline_timer);
 }
 
 /*
@@ -299,12 +411,16 @@ void stdin_io_cb(struct ev_loop *loop, ev_io *watcher, int revents) {
         return;
     bool has_urgent = false;
     if (child.version > 0) {
-        has_urgent = read_json_input(buffer, rec);
+        /* Nothing to draw until a statusline is complete */
+        if (!read_json_input(buffer, rec, &has_urgent)) {
+            free(buffer);
+            return;
+        }
     } else {
         read_flat_input((char*)buffer, rec);
     }
     free(buffer);
-    draw_bars(has_urgent);
+    statusline_updated(has_urgent);
 }
 
 /*
@@ -329,7 +445,8 @@ void stdin_io_first_line_cb(struct ev_loop *loop, ev_io *watcher, int revents) {
         if (config.hide_on_modifier) {
             stop_child();
         }
-        read_json_input(buffer + consumed, rec - consumed);
+        bool has_urgent;
+        read_json_input(buffer + consumed, rec - consumed, &has_urgent);
     } else {
         /* In case of plaintext, we just add a single block and change its
          * full_text pointer later. */
@@ -388,6 +505,7 @@ void start_child(char *command) {
     callbacks.yajl_end_array = stdin_end_array;
     callbacks.yajl_start_map = stdin_start_map;
     callbacks.yajl_end_map = stdin_end_map;
+    TAILQ_INIT(&(parser_context.blocks));
 #if YAJL_MAJOR < 2
     yajl_parser_config parse_conf = { 0, 0 };
 
@@ -200,11 +200,32 @@ static int config_boolean_cb(void *params_, int val) {
     return 0;
 }
 
+/*
+ * Parse an integer value
+ *
+ */
+#if YAJL_MAJOR >= 2
+static int config_integer_cb(void *params_, long long val) {
+#else
+static int config_integer_cb(void *params_, long val) {
+#endif
+    if (!strcmp(cur_key, "status_interval")) {
+        DLOG("status_interval = %d\n", (int)val);
+        config.status_interval = val;
+        return 1;
+    }
+
+    /* Integer values we do not know (e.g. added by a newer i3) are ignored
+     * instead of aborting the whole parse. */
+    DLOG("ignoring unknown integer key %s = %lld\n", cur_key, (long long)val);
+    return 1;
+}
+
 /* A datastructure to pass all these callbacks to yajl */
 static yajl_callbacks outputs_callbacks = {
     &config_null_cb,
     &config_boolean_cb,
-    NULL,
+    &config_integer_cb,
     NULL,
     NULL,
     &config_string_cb,
@@ -22,10 +22,39 @@
 
 ev_io      *i3_connection;
 
+/* Data received from i3 which was not handled yet. Messages are handled as
+ * soon as they are complete, an incomplete message stays in the buffer until
+ * the rest arrives. */
+static char     *read_buffer;
+static uint32_t  read_buffer_size;
+static uint32_t  read_buffer_used;
+
+/* GET_WORKSPACES requests are deduplicated: while one is in flight, further
+ * workspace events only mark the reply as outdated, and a single new request
+ * is sent once the reply arrived. */
+static bool      workspaces_requested;
+static bool      workspaces_outdated;
+
 const char *sock_path;
 
 typedef void(*handler_t)(char*);
 
+/*
+ * Requests the workspaces from i3, unless a request is already in flight.
+ *
+ */
+static void request_workspaces(void) {
+    if (workspaces_requested) {
+        DLOG("GET_WORKSPACES already in flight, not sending another one\n");
+        workspaces_outdated = true;
+        return;
+    }
+
+    i3_send_msg(I3_IPC_MESSAGE_TYPE_GET_WORKSPACES, NULL);
+    workspaces_requested = true;
+    workspaces_outdated = false;
+}
+
 /*
  * Called, when we get a reply to a command from i3.
  * Since i3 does not give us much feedback on commands, we do not much
@@ -41,7 +70,14 @@ void got_command_reply(char *reply) {
  */
 void got_workspace_reply(char *reply) {
     DLOG("Got Workspace-Data!\n");
+    /* The workspaces changed while the request was in flight, so this reply
+     * might already be outdated. */
+    workspaces_requested = false;
+    if (workspaces_outdated)
+        request_workspaces();
+
     parse_workspaces_json(reply);
+    invalidate_workspace_buttons();
     draw_bars(false);
 }
 
@@ -92,7 +128,7 @@ void got_bar_config(char *reply) {
      * events and request the workspaces if necessary. */
     subscribe_events();
     if (!config.disable_ws)
-        i3_send_msg(I3_IPC_MESSAGE_TYPE_GET_WORKSPACES, NULL);
+        request_workspaces();
 
     /* Initialize the rest of XCB */
     init_xcb_late(config.fontname);
@@ -124,7 +160,7 @@ handler_t reply_handlers[] = {
  */
 void got_workspace_event(char *event) {
     DLOG("Got Workspace Event!\n");
-    i3_send_msg(I3_IPC_MESSAGE_TYPE_GET_WORKSPACES, NULL);
+    request_workspaces();
 }
 
 /*
@@ -135,7 +171,7 @@ void got_output_event(char *event) {
     DLOG("Got Output Event!\n");
     i3_send_msg(I3_IPC_MESSAGE_TYPE_GET_OUTPUTS, NULL);
     if (!config.disable_ws) {
-        i3_send_msg(I3_IPC_MESSAGE_TYPE_GET_WORKSPACES, NULL);
+        request_workspaces();
     }
 }
 
@@ -158,23 +194,46 @@ handler_t event_handlers[] = {
 };
 
 /*
- * Called, when we get a message from i3
+ * Calls the handler for the given message.
+ *
+ */
+static void handle_message(uint32_t type, char *payload) {
+    if (type & (1 << 31)) {
+        type ^= 1 << 31;
+        if (type < sizeof(event_handlers) / sizeof(handler_t))
+            event_handlers[type](payload);
+        else ELOG("Unknown event type %d\n", type);
+    } else {
+        if (type < sizeof(reply_handlers) / sizeof(handler_t) && reply_handlers[type])
+            reply_handlers[type](payload);
+    }
+}
+
+/*
+ * Called, when we get data from i3. Reads everything that is available
+ * (without blocking) and handles all complete messages. An incomplete message
+ * is kept in the buffer until the next call.
  *
  */
 void got_data(struct ev_loop *loop, ev_io *watcher, int events) {
     DLOG("Got data!\n");
     int fd = watcher->fd;
+    const uint32_t header_len = strlen(I3_IPC_MAGIC) + sizeof(uint32_t)*2;
 
-    /* First we only read the header, because we know its length */
-    uint32_t header_len = strlen(I3_IPC_MAGIC) + sizeof(uint32_t)*2;
-    char *header = smalloc(header_len);
+    while (true) {
+        /* Always leave space for the NUL byte which terminates the payload */
+        if (read_buffer_size - read_buffer_used < 4096) {
+            read_buffer_size = (read_buffer_size == 0 ? 8192 : read_buffer_size * 2);
+            read_buffer = srealloc(read_buffer, read_buffer_size);
+        }
 
-    /* We first parse the fixed-length IPC-header, to know, how much data
-     * we have to expect */
-    uint32_t rec = 0;
-    while (rec < header_len) {
-        int n = read(fd, header + rec, header_len - rec);
+        ssize_t n = recv(fd, read_buffer + read_buffer_used,
+                         read_buffer_size - read_buffer_used - 1, MSG_DONTWAIT);
         if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
             ELOG("read() failed: %s\n", strerror(errno));
             exit(EXIT_FAILURE);
         }
@@ -185,54 +244,55 @@ void got_data(struct ev_loop *loop, ev_io *watcher, int events) {
             clean_xcb();
             exit(EXIT_SUCCESS);
         }
-        rec += n;
+        read_buffer_used += n;
     }
 
-    if (strncmp(header, I3_IPC_MAGIC, strlen(I3_IPC_MAGIC))) {
-        ELOG("Wrong magic code: %.*s\n Expected: %s\n",
-             (int) strlen(I3_IPC_MAGIC),
-             header,
-             I3_IPC_MAGIC);
-        exit(EXIT_FAILURE);
-    }
-
-    char *walk = header + strlen(I3_IPC_MAGIC);
-    uint32_t size;
-    memcpy(&size, (uint32_t*)walk, sizeof(uint32_t));
-    walk += sizeof(uint32_t);
-    uint32_t type;
-    memcpy(&type, (uint32_t*)walk, sizeof(uint32_t));
-
-    /* Now that we know, what to expect, we can start read()ing the rest
-     * of the message */
-    char *buffer = smalloc(size + 1);
-    rec = 0;
-
-    while (rec < size) {
-        int n = read(fd, buffer + rec, size - rec);
-        if (n == -1) {
-            ELOG("read() failed: %s\n", strerror(errno));
+    uint32_t handled = 0;
+    while (read_buffer_used - handled >= header_len) {
+        char *header = read_buffer + handled;
+        if (strncmp(header, I3_IPC_MAGIC, strlen(I3_IPC_MAGIC))) {
+            ELOG("Wrong magic code: %.*s\n Expected: %s\n",
+                 (int) strlen(I3_IPC_MAGIC),
+                 header,
+                 I3_IPC_MAGIC);
             exit(EXIT_FAILURE);
         }
-        if (n == 0) {
-            ELOG("Nothing to read!\n");
-            exit(EXIT_FAILURE);
+
+        char *walk = header + strlen(I3_IPC_MAGIC);
+        uint32_t size;
+        memcpy(&size, (uint32_t*)walk, sizeof(uint32_t));
+        walk += sizeof(uint32_t);
+        uint32_t type;
+        memcpy(&type, (uint32_t*)walk, sizeof(uint32_t));
+        walk += sizeof(uint32_t);
+
+        if (read_buffer_used - handled - header_len < size) {
+            /* Incomplete message: make sure the buffer can hold all of it
+             * (plus the NUL byte) once the rest arrives. */
+            const uint32_t needed = header_len + size + 1;
+            if (needed > read_buffer_size) {
+                read_buffer_size = needed;
+                read_buffer = srealloc(read_buffer, read_buffer_size);
+            }
+            break;
         }
-        rec += n;
-    }
-    buffer[size] = '\0';
 
-    /* And call the callback (indexed by the type) */
-    if (type & (1 << 31)) {
-        type ^= 1 << 31;
-        event_handlers[type](buffer);
-    } else {
-        if (reply_handlers[type])
-            reply_handlers[type](buffer);
+        /* The handlers expect a NUL-terminated string. The byte after the
+         * payload belongs to the next message (if any), so we restore it
+         * afterwards. */
+        char *payload = walk;
+        char saved = payload[size];
+        payload[size] = '\0';
+        handle_message(type, payload);
+        payload[size] = saved;
+
+        handled += header_len + size;
     }
 
-    FREE(header);
-    FREE(buffer);
+    if (handled > 0) {
+        read_buffer_used -= handled;
+        memmove(read_buffer, read_buffer + handled, read_buffer_used);
+    }
 }
 
 /*
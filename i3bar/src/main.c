@@ -86,6 +86,14 @@ void sig_cb(struct ev_loop *loop, ev_signal *watcher, int revents) {
     ev_unloop(main_loop, EVUNLOOP_ALL);
 }
 
+/*
+ * On SIGUSR1, we print how long drawing the bars takes.
+ *
+ */
+static void stats_cb(struct ev_loop *loop, ev_signal *watcher, int revents) {
+    print_draw_stats();
+}
+
 int main(int argc, char **argv) {
     int opt;
     int option_index = 0;
@@ -154,14 +162,17 @@ int main(int argc, char **argv) {
     ev_signal *sig_term = smalloc(sizeof(ev_signal));
     ev_signal *sig_int = smalloc(sizeof(ev_signal));
     ev_signal *sig_hup = smalloc(sizeof(ev_signal));
+    ev_signal *sig_usr1 = smalloc(sizeof(ev_signal));
 
     ev_signal_init(sig_term, &sig_cb, SIGTERM);
     ev_signal_init(sig_int, &sig_cb, SIGINT);
     ev_signal_init(sig_hup, &sig_cb, SIGHUP);
+    ev_signal_init(sig_usr1, &stats_cb, SIGUSR1);
 
     ev_signal_start(main_loop, sig_term);
     ev_signal_start(main_loop, sig_int);
     ev_signal_start(main_loop, sig_hup);
+    ev_signal_start(main_loop, sig_usr1);
 
     /* From here on everything should run smooth for itself, just start listening for
      * events. We stop simply stop the event-loop, when we are finished */
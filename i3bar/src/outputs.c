@@ -160,6 +160,11 @@ static int outputs_start_map_cb(void *params_) {
         new_output->ws = 0,
         memset(&new_output->rect, 0, sizeof(rect));
         new_output->bar = XCB_NONE;
+        new_output->buffer = XCB_NONE;
+        new_output->buffer_width = 0;
+        new_output->buffer_height = 0;
+        new_output->buttons_valid = false;
+        new_output->buttons_width = 0;
 
         new_output->workspaces = smalloc(sizeof(struct ws_head));
         TAILQ_INIT(new_output->workspaces);
@@ -9,6 +9,7 @@
  */
 #include <xcb/xcb.h>
 #include <xcb/xproto.h>
+#include <xcb/xcbext.h>
 #include <xcb/xcb_aux.h>
 
 #ifdef XCB_COMPAT
@@ -53,6 +54,23 @@ xcb_window_t     xcb_root;
 static xcb_window_t selwin = XCB_NONE;
 static xcb_intern_atom_reply_t *tray_reply = NULL;
 
+/* The output on which tray icons are docked. Resolved whenever the outputs
+ * change (see resolve_tray_output()) instead of on every dock request. */
+static i3_output *tray_output = NULL;
+
+/* Dock requests are handled asynchronously: the _XEMBED_INFO property is
+ * requested and the client is docked once the reply arrived (see
+ * handle_pending_docks()), so that many clients docking at the same time do
+ * not cause one round trip each. */
+struct pending_dock {
+    xcb_window_t client;
+    xcb_get_property_cookie_t cookie;
+
+    TAILQ_ENTRY(pending_dock) pending_docks;
+};
+static TAILQ_HEAD(pending_docks_head, pending_dock) pending_docks =
+    TAILQ_HEAD_INITIALIZER(pending_docks);
+
 /* This is needed for integration with libi3 */
 xcb_connection_t *conn;
 
@@ -68,9 +86,17 @@ int              mod_pressed = 0;
  * global buffer to render it on */
 xcb_gcontext_t   statusline_ctx;
 xcb_gcontext_t   statusline_clear;
-xcb_pixmap_t     statusline_pm;
+xcb_pixmap_t     statusline_pm = XCB_NONE;
 uint32_t         statusline_width;
 
+/* The size of statusline_pm. Its height is the height of the text, its width
+ * is doubled whenever the statusline does not fit anymore. */
+static uint32_t  statusline_pm_width;
+static uint32_t  statusline_pm_height;
+
+/* The initial width of statusline_pm */
+#define STATUSLINE_PM_MIN_WIDTH 1024
+
 /* Event-Watchers, to interact with the user */
 ev_prepare *xcb_prep;
 ev_check   *xcb_chk;
@@ -83,6 +109,9 @@ static mode binding;
 /* Indicates whether a new binding mode was recently activated */
 bool activated_mode = false;
 
+/* How long draw_bars() takes, printed on SIGUSR1 */
+static latency_histogram draw_latency = { .name = "draw_bars" };
+
 /* The parsed colors */
 struct xcb_colors_t {
     uint32_t bar_fg;
@@ -158,14 +187,13 @@ void refresh_statusline(void) {
         statusline_width += block->width + block->x_offset + block->x_append;
     }
 
-    /* If the statusline is bigger than our screen we need to make sure that
-     * the pixmap provides enough space, so re-allocate if the width grew */
-    if (statusline_width > root_screen->width_in_pixels &&
-        statusline_width > old_statusline_width)
+    /* Make sure that the pixmap provides enough space, so re-allocate if the
+     * width grew beyond it */
+    if (statusline_pm == XCB_NONE || statusline_width > old_statusline_width)
         realloc_sl_buffer();
 
     /* Clear the statusline pixmap. */
-    xcb_rectangle_t rect = { 0, 0, root_screen->width_in_pixels, font.height + 2 };
+    xcb_rectangle_t rect = { 0, 0, statusline_pm_width, statusline_pm_height };
     xcb_poly_fill_rectangle(xcb_connection, statusline_pm, statusline_clear, 1, &rect);
 
     /* Draw the text of each block. */
@@ -430,31 +458,207 @@ void handle_button(xcb_button_press_event_t *event) {
 }
 
 /*
- * Configures the x coordinate of all trayclients. To be called after adding a
- * new tray client or removing an old one.
+ * Configures the x coordinate of the trayclients of the given output. To be
+ * called after adding a new tray client or removing an old one. Only the
+ * clients whose position actually changed are re-configured.
  *
  */
-static void configure_trayclients(void) {
+static void configure_trayclients(i3_output *output) {
     trayclient *trayclient;
-    i3_output *output;
-    SLIST_FOREACH(output, outputs, slist) {
-        if (!output->active)
+    int clients = 0;
+    TAILQ_FOREACH_REVERSE(trayclient, output->trayclients, tc_head, tailq) {
+        if (!trayclient->mapped)
             continue;
+        clients++;
 
-        int clients = 0;
-        TAILQ_FOREACH_REVERSE(trayclient, output->trayclients, tc_head, tailq) {
-            if (!trayclient->mapped)
+        uint32_t x = output->rect.w - (clients * (font.height + 2));
+        if (trayclient->x == (int)x)
+            continue;
+
+        DLOG("Configuring tray window %08x to x=%d\n", trayclient->win, x);
+        xcb_configure_window(xcb_connection,
+                             trayclient->win,
+                             XCB_CONFIG_WINDOW_X,
+                             &x);
+        trayclient->x = x;
+    }
+}
+
+/*
+ * Determines the output on which tray icons are docked (config.tray_output, or
+ * the first active output). Called whenever the outputs changed.
+ *
+ */
+static void resolve_tray_output(void) {
+    i3_output *walk;
+    tray_output = NULL;
+    SLIST_FOREACH(walk, outputs, slist) {
+        if (!walk->active)
+            continue;
+        if (config.tray_output) {
+            if ((strcasecmp(walk->name, config.tray_output) != 0) &&
+                (!walk->primary || strcasecmp("primary", config.tray_output) != 0))
+                continue;
+        }
+
+        DLOG("using output %s for the tray\n", walk->name);
+        tray_output = walk;
+        return;
+    }
+    /* In case of tray_output == primary and there is no primary output
+     * configured, we fall back to the first available output. */
+    if (config.tray_output && strcasecmp("primary", config.tray_output) == 0) {
+        SLIST_FOREACH(walk, outputs, slist) {
+            if (!walk->active)
                 continue;
-            clients++;
-
-            DLOG("Configuring tray window %08x to x=%d\n",
-                 trayclient->win, output->rect.w - (clients * (font.height + 2)));
-            uint32_t x = output->rect.w - (clients * (font.height + 2));
-            xcb_configure_window(xcb_connection,
-                                 trayclient->win,
-                                 XCB_CONFIG_WINDOW_X,
-                                 &x);
+            DLOG("Falling back to output %s because no primary output is configured\n", walk->name);
+            tray_output = walk;
+            return;
+        }
+    }
+}
+
+/*
+ * Docks the given client into the bar of the tray output, using the
+ * _XEMBED_INFO property (may be NULL). Returns true if the client was
+ * docked.
+ *
+ */
+static bool dock_client(xcb_window_t client, xcb_get_property_reply_t *xembedr) {
+    /* The XEMBED specification (which is referred by the tray specification)
+     * says _XEMBED_INFO *has* to be set, but VLC does not set it… */
+    bool map_it = true;
+    int xe_version = 1;
+    uint32_t mask;
+    uint32_t values[2];
+    if (xembedr != NULL && xembedr->length != 0) {
+        DLOG("xembed format = %d, len = %d\n", xembedr->format, xembedr->length);
+        uint32_t *xembed = xcb_get_property_value(xembedr);
+        DLOG("xembed version = %d\n", xembed[0]);
+        DLOG("xembed flags = %d\n", xembed[1]);
+        map_it = ((xembed[1] & XEMBED_MAPPED) == XEMBED_MAPPED);
+        xe_version = xembed[0];
+        if (xe_version > 1)
+            xe_version = 1;
+    } else {
+        ELOG("Window %08x violates the XEMBED protocol, _XEMBED_INFO not set\n", client);
+    }
+
+    DLOG("X window %08x requested docking\n", client);
+    i3_output *output = tray_output;
+    if (output == NULL || !output->active || output->bar == XCB_NONE) {
+        ELOG("No output found\n");
+        return false;
+    }
+    xcb_reparent_window(xcb_connection,
+                        client,
+                        output->bar,
+                        output->rect.w - font.height - 2,
+                        2);
+    /* We reconfigure the window to use a reasonable size. The systray
+     * specification explicitly says:
+     *   Tray icons may be assigned any size by the system tray, and
+     *   should do their best to cope with any size effectively
+     */
+    mask = XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
+    values[0] = font.height;
+    values[1] = font.height;
+    xcb_configure_window(xcb_connection,
+                         client,
+                         mask,
+                         values);
+
+    /* send the XEMBED_EMBEDDED_NOTIFY message */
+    void *event = scalloc(32);
+    xcb_client_message_event_t *ev = event;
+    ev->response_type = XCB_CLIENT_MESSAGE;
+    ev->window = client;
+    ev->type = atoms[_XEMBED];
+    ev->format = 32;
+    ev->data.data32[0] = XCB_CURRENT_TIME;
+    ev->data.data32[1] = atoms[XEMBED_EMBEDDED_NOTIFY];
+    ev->data.data32[2] = output->bar;
+    ev->data.data32[3] = xe_version;
+    xcb_send_event(xcb_connection,
+                   0,
+                   client,
+                   XCB_EVENT_MASK_NO_EVENT,
+                   (char*)ev);
+    free(event);
+
+    /* Put the client inside the save set. Upon termination (whether
+     * killed or normal exit does not matter) of i3bar, these clients
+     * will be correctly reparented to their most closest living
+     * ancestor. Without this, tray icons might die when i3bar
+     * exits/crashes. */
+    xcb_change_save_set(xcb_connection, XCB_SET_MODE_INSERT, client);
+
+    if (map_it) {
+        DLOG("Mapping dock client\n");
+        xcb_map_window(xcb_connection, client);
+    } else {
+        DLOG("Not mapping dock client yet\n");
+    }
+    /* New clients are added on the left, so that the icons which are already
+     * docked keep their position. */
+    trayclient *tc = smalloc(sizeof(trayclient));
+    tc->win = client;
+    tc->mapped = map_it;
+    tc->xe_version = xe_version;
+    tc->x = output->rect.w - font.height - 2;
+    TAILQ_INSERT_HEAD(output->trayclients, tc, tailq);
+
+    configure_trayclients(output);
+    return true;
+}
+
+/*
+ * Docks all clients whose _XEMBED_INFO reply arrived. The replies arrive in
+ * the order of the requests, so we stop at the first one which is missing.
+ *
+ */
+static void handle_pending_docks(void) {
+    bool docked = false;
+    struct pending_dock *dock;
+    while ((dock = TAILQ_FIRST(&pending_docks)) != NULL) {
+        xcb_get_property_reply_t *xembedr = NULL;
+        xcb_generic_error_t *error = NULL;
+        if (!xcb_poll_for_reply(xcb_connection, dock->cookie.sequence, (void**)&xembedr, &error))
+            break;
+
+        TAILQ_REMOVE(&pending_docks, dock, pending_docks);
+        if (error != NULL) {
+            ELOG("Error getting _XEMBED_INFO property: error_code %d\n",
+                 error->error_code);
+            free(error);
+        } else if (dock_client(dock->client, xembedr)) {
+            docked = true;
         }
+        free(xembedr);
+        free(dock);
+    }
+
+    /* Trigger an update to copy the statusline text to the appropriate
+     * position (once for all clients which docked) */
+    if (docked)
+        draw_bars(false);
+}
+
+/*
+ * Forgets about pending dock requests of the given window (which was
+ * destroyed before its request was handled).
+ *
+ */
+static void cancel_pending_docks(xcb_window_t window) {
+    struct pending_dock *dock, *next;
+    for (dock = TAILQ_FIRST(&pending_docks); dock != NULL; dock = next) {
+        next = TAILQ_NEXT(dock, pending_docks);
+        if (dock->client != window)
+            continue;
+        DLOG("Window %08x was destroyed before it could be docked\n", window);
+        xcb_discard_reply(xcb_connection, dock->cookie.sequence);
+        TAILQ_REMOVE(&pending_docks, dock, pending_docks);
+        free(dock);
     }
 }
 
@@ -486,133 +690,19 @@ static void handle_client_message(xcb_client_message_event_t* event) {
                                          mask,
                                          values);
 
-            /* Request the _XEMBED_INFO property. The XEMBED specification
-             * (which is referred by the tray specification) says this *has* to
-             * be set, but VLC does not set it… */
-            bool map_it = true;
-            int xe_version = 1;
-            xcb_get_property_cookie_t xembedc;
-            xcb_generic_error_t *error;
-            xembedc = xcb_get_property(xcb_connection,
-                                       0,
-                                       client,
-                                       atoms[_XEMBED_INFO],
-                                       XCB_GET_PROPERTY_TYPE_ANY,
-                                       0,
-                                       2 * 32);
-
-            xcb_get_property_reply_t *xembedr = xcb_get_property_reply(xcb_connection,
-                                                                       xembedc,
-                                                                       &error);
-            if (error != NULL) {
-                ELOG("Error getting _XEMBED_INFO property: error_code %d\n",
-                     error->error_code);
-                free(error);
-                return;
-            }
-            if (xembedr != NULL && xembedr->length != 0) {
-                DLOG("xembed format = %d, len = %d\n", xembedr->format, xembedr->length);
-                uint32_t *xembed = xcb_get_property_value(xembedr);
-                DLOG("xembed version = %d\n", xembed[0]);
-                DLOG("xembed flags = %d\n", xembed[1]);
-                map_it = ((xembed[1] & XEMBED_MAPPED) == XEMBED_MAPPED);
-                xe_version = xembed[0];
-                if (xe_version > 1)
-                    xe_version = 1;
-                free(xembedr);
-            } else {
-                ELOG("Window %08x violates the XEMBED protocol, _XEMBED_INFO not set\n", client);
-            }
-
-            DLOG("X window %08x requested docking\n", client);
-            i3_output *walk, *output = NULL;
-            SLIST_FOREACH(walk, outputs, slist) {
-                if (!walk->active)
-                    continue;
-                if (config.tray_output) {
-                    if ((strcasecmp(walk->name, config.tray_output) != 0) &&
-                        (!walk->primary || strcasecmp("primary", config.tray_output) != 0))
-                        continue;
-                }
-
-                DLOG("using output %s\n", walk->name);
-                output = walk;
-                break;
-            }
-            /* In case of tray_output == primary and there is no primary output
-             * configured, we fall back to the first available output. */
-            if (output == NULL && strcasecmp("primary", config.tray_output) == 0) {
-                SLIST_FOREACH(walk, outputs, slist) {
-                    if (!walk->active)
-                        continue;
-                    DLOG("Falling back to output %s because no primary output is configured\n", walk->name);
-                    output = walk;
-                    break;
-                }
-            }
-            if (output == NULL) {
-                ELOG("No output found\n");
-                return;
-            }
-            xcb_reparent_window(xcb_connection,
-                                client,
-                                output->bar,
-                                output->rect.w - font.height - 2,
-                                2);
-            /* We reconfigure the window to use a reasonable size. The systray
-             * specification explicitly says:
-             *   Tray icons may be assigned any size by the system tray, and
-             *   should do their best to cope with any size effectively
-             */
-            mask = XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT;
-            values[0] = font.height;
-            values[1] = font.height;
-            xcb_configure_window(xcb_connection,
-                                 client,
-                                 mask,
-                                 values);
-
-            /* send the XEMBED_EMBEDDED_NOTIFY message */
-            void *event = scalloc(32);
-            xcb_client_message_event_t *ev = event;
-            ev->response_type = XCB_CLIENT_MESSAGE;
-            ev->window = client;
-            ev->type = atoms[_XEMBED];
-            ev->format = 32;
-            ev->data.data32[0] = XCB_CURRENT_TIME;
-            ev->data.data32[1] = atoms[XEMBED_EMBEDDED_NOTIFY];
-            ev->data.data32[2] = output->bar;
-            ev->data.data32[3] = xe_version;
-            xcb_send_event(xcb_connection,
-                           0,
-                           client,
-                           XCB_EVENT_MASK_NO_EVENT,
-                           (char*)ev);
-            free(event);
-
-            /* Put the client inside the save set. Upon termination (whether
-             * killed or normal exit does not matter) of i3bar, these clients
-             * will be correctly reparented to their most closest living
-             * ancestor. Without this, tray icons might die when i3bar
-             * exits/crashes. */
-            xcb_change_save_set(xcb_connection, XCB_SET_MODE_INSERT, client);
-
-            if (map_it) {
-                DLOG("Mapping dock client\n");
-                xcb_map_window(xcb_connection, client);
-            } else {
-                DLOG("Not mapping dock client yet\n");
-            }
-            trayclient *tc = smalloc(sizeof(trayclient));
-            tc->win = client;
-            tc->mapped = map_it;
-            tc->xe_version = xe_version;
-            TAILQ_INSERT_TAIL(output->trayclients, tc, tailq);
-
-            /* Trigger an update to copy the statusline text to the appropriate
-             * position */
-            configure_trayclients();
-            draw_bars(false);
+            /* Request the _XEMBED_INFO property. The client is docked when the
+             * reply arrives (see handle_pending_docks()). */
+            struct pending_dock *dock = smalloc(sizeof(struct pending_dock));
+            dock->client = client;
+            dock->cookie = xcb_get_property(xcb_connection,
+                                            0,
+                                            client,
+                                            atoms[_XEMBED_INFO],
+                                            XCB_GET_PROPERTY_TYPE_ANY,
+                                            0,
+                                            2 * 32);
+            TAILQ_INSERT_TAIL(&pending_docks, dock, pending_docks);
+            DLOG("Requested _XEMBED_INFO of window %08x\n", client);
         }
     }
 }
@@ -625,6 +715,9 @@ static void handle_client_message(xcb_client_message_event_t* event) {
 static void handle_unmap_notify(xcb_unmap_notify_event_t* event) {
     DLOG("UnmapNotify for window = %08x, event = %08x\n", event->window, event->event);
 
+    if ((event->response_type & ~0x80) == XCB_DESTROY_NOTIFY)
+        cancel_pending_docks(event->window);
+
     i3_output *walk;
     SLIST_FOREACH(walk, outputs, slist) {
         if (!walk->active)
@@ -637,9 +730,10 @@ static void handle_unmap_notify(xcb_unmap_notify_event_t* event) {
 
             DLOG("Removing tray client with window ID %08x\n", event->window);
             TAILQ_REMOVE(walk->trayclients, trayclient, tailq);
+            free(trayclient);
 
             /* Trigger an update, we now have more space for the statusline */
-            configure_trayclients();
+            configure_trayclients(walk);
             draw_bars(false);
             return;
         }
@@ -704,13 +798,13 @@ static void handle_property_notify(xcb_property_notify_event_t *event) {
             /* need to unmap the window */
             xcb_unmap_window(xcb_connection, trayclient->win);
             trayclient->mapped = map_it;
-            configure_trayclients();
+            configure_trayclients(o_walk);
             draw_bars(false);
         } else if (!trayclient->mapped && map_it) {
             /* need to map the window */
             xcb_map_window(xcb_connection, trayclient->win);
             trayclient->mapped = map_it;
-            configure_trayclients();
+            configure_trayclients(o_walk);
             draw_bars(false);
         }
         free(xembedr);
@@ -731,17 +825,15 @@ static void handle_configure_request(xcb_configure_request_event_t *event) {
         if (!output->active)
             continue;
 
-        int clients = 0;
-        TAILQ_FOREACH_REVERSE(trayclient, output->trayclients, tc_head, tailq) {
+        TAILQ_FOREACH(trayclient, output->trayclients, tailq) {
             if (!trayclient->mapped)
                 continue;
-            clients++;
 
             if (trayclient->win != event->window)
                 continue;
 
             xcb_rectangle_t rect;
-            rect.x = output->rect.w - (clients * (font.height + 2));
+            rect.x = trayclient->x;
             rect.y = 2;
             rect.width = font.height;
             rect.height = font.height;
@@ -809,6 +901,11 @@ void xcb_chk_cb(struct ev_loop *loop, ev_check *watcher, int revents) {
         }
         free(event);
     }
+
+    /* Replies to our _XEMBED_INFO requests might have been read while
+     * polling for events. */
+    if (!TAILQ_EMPTY(&pending_docks))
+        handle_pending_docks();
 }
 
 /*
@@ -930,13 +1027,8 @@ char *init_xcb_early() {
                                                             0,
                                                             NULL);
 
-    statusline_pm = xcb_generate_id(xcb_connection);
-    xcb_void_cookie_t sl_pm_cookie = xcb_create_pixmap_checked(xcb_connection,
-                                                               root_screen->root_depth,
-                                                               statusline_pm,
-                                                               xcb_root,
-                                                               root_screen->width_in_pixels,
-                                                               root_screen->height_in_pixels);
+    /* The statusline pixmap is created by realloc_sl_buffer() as soon as we
+     * know the font (and therefore the height of the bar). */
 
 
     /* The various Watchers to communicate with xcb */
@@ -976,8 +1068,7 @@ char *init_xcb_early() {
     }
 
 
-    if (xcb_request_failed(sl_pm_cookie, "Could not allocate statusline-buffer") ||
-        xcb_request_failed(clear_ctx_cookie, "Could not allocate statusline-buffer-clearcontext") ||
+    if (xcb_request_failed(clear_ctx_cookie, "Could not allocate statusline-buffer-clearcontext") ||
         xcb_request_failed(sl_ctx_cookie, "Could not allocate statusline-buffer-context")) {
         exit(EXIT_FAILURE);
     }
@@ -1262,6 +1353,7 @@ void kick_tray_clients(i3_output *output) {
         /* We remove the trayclient right here. We might receive an UnmapNotify
          * event afterwards, but better safe than sorry. */
         TAILQ_REMOVE(output->trayclients, trayclient, tailq);
+        free(trayclient);
     }
 
     /* Fake a DestroyNotify so that Qt re-adds tray icons.
@@ -1294,50 +1386,136 @@ void destroy_window(i3_output *output) {
     kick_tray_clients(output);
     xcb_destroy_window(xcb_connection, output->bar);
     output->bar = XCB_NONE;
+
+    if (output->buffer != XCB_NONE) {
+        xcb_free_pixmap(xcb_connection, output->buffer);
+        output->buffer = XCB_NONE;
+        output->buffer_width = 0;
+        output->buffer_height = 0;
+    }
+    xcb_free_gc(xcb_connection, output->bargc);
 }
 
 /*
- * Reallocate the statusline-buffer
+ * Returns the number of bytes the X server uses per pixel of our pixmaps
+ * (pixmaps with depth 24 are stored with 32 bits per pixel).
  *
  */
-void realloc_sl_buffer(void) {
-    DLOG("Re-allocating statusline-buffer, statusline_width = %d, root_screen->width_in_pixels = %d\n",
-         statusline_width, root_screen->width_in_pixels);
-    xcb_free_pixmap(xcb_connection, statusline_pm);
-    statusline_pm = xcb_generate_id(xcb_connection);
-    xcb_void_cookie_t sl_pm_cookie = xcb_create_pixmap_checked(xcb_connection,
-                                                               root_screen->root_depth,
-                                                               statusline_pm,
-                                                               xcb_root,
-                                                               MAX(root_screen->width_in_pixels, statusline_width),
-                                                               root_screen->height_in_pixels);
+static uint32_t bytes_per_pixel(void) {
+    if (root_screen->root_depth > 16)
+        return 4;
+    return (root_screen->root_depth > 8 ? 2 : 1);
+}
+
+/*
+ * Logs how much memory our pixmaps take up in the X server (in verbose mode).
+ *
+ */
+static void log_pixmap_memory(void) {
+    if (!config.verbose)
+        return;
+
+    uint64_t total = (uint64_t)statusline_pm_width * statusline_pm_height * bytes_per_pixel();
+    DLOG("Pixmap memory: statusline %dx%d (%llu bytes)\n",
+         statusline_pm_width, statusline_pm_height, (unsigned long long)total);
+
+    i3_output *walk;
+    SLIST_FOREACH(walk, outputs, slist) {
+        if (walk->buffer == XCB_NONE)
+            continue;
+        uint64_t bytes = (uint64_t)walk->buffer_width * walk->buffer_height * bytes_per_pixel();
+        DLOG("Pixmap memory: buffer for output %s %dx%d (%llu bytes)\n",
+             walk->name, walk->buffer_width, walk->buffer_height, (unsigned long long)bytes);
+        total += bytes;
+    }
+
+    DLOG("Pixmap memory: %llu bytes in total\n", (unsigned long long)total);
+}
+
+/*
+ * (Re-)Creates the double-buffer of the given output, unless it already has
+ * the right size (the width of the output and the height of the bar).
+ *
+ * Returns the cookie of the request, or a cookie with sequence 0 if the
+ * buffer was re-used.
+ *
+ */
+static xcb_void_cookie_t realloc_output_buffer(i3_output *output) {
+    const uint32_t width = output->rect.w;
+    const uint32_t height = font.height + 6;
+
+    if (output->buffer != XCB_NONE &&
+        output->buffer_width == width &&
+        output->buffer_height == height) {
+        DLOG("Re-using buffer for output %s\n", output->name);
+        return (xcb_void_cookie_t){ 0 };
+    }
+
+    if (output->buffer != XCB_NONE) {
+        DLOG("Destroying buffer for output %s\n", output->name);
+        xcb_free_pixmap(xcb_connection, output->buffer);
+    }
+
+    DLOG("Creating buffer of %dx%d for output %s\n", width, height, output->name);
+    output->buffer = xcb_generate_id(xcb_connection);
+    output->buttons_valid = false;
+    output->buffer_width = width;
+    output->buffer_height = height;
+    return xcb_create_pixmap_checked(xcb_connection,
+                                     root_screen->root_depth,
+                                     output->buffer,
+                                     output->bar,
+                                     width,
+                                     height);
+}
 
+/*
+ * Reallocate the statusline-buffer if the statusline does not fit into it (or
+ * the height of the bar changed). The pixmap is only as high as the text and
+ * its width grows geometrically, so that a growing statusline does not cause
+ * a re-allocation on every update.
+ *
+ */
+void realloc_sl_buffer(void) {
+    /* The colors might have changed (they are only known after the
+     * configuration arrived). */
     uint32_t mask = XCB_GC_FOREGROUND;
     uint32_t vals[2] = { colors.bar_bg, colors.bar_bg };
-    xcb_free_gc(xcb_connection, statusline_clear);
-    statusline_clear = xcb_generate_id(xcb_connection);
-    xcb_void_cookie_t clear_ctx_cookie = xcb_create_gc_checked(xcb_connection,
-                                                               statusline_clear,
-                                                               xcb_root,
-                                                               mask,
-                                                               vals);
+    xcb_change_gc(xcb_connection, statusline_clear, mask, vals);
 
     mask |= XCB_GC_BACKGROUND;
     vals[0] = colors.bar_fg;
-    statusline_ctx = xcb_generate_id(xcb_connection);
-    xcb_free_gc(xcb_connection, statusline_ctx);
-    xcb_void_cookie_t sl_ctx_cookie = xcb_create_gc_checked(xcb_connection,
-                                                            statusline_ctx,
-                                                            xcb_root,
-                                                            mask,
-                                                            vals);
+    xcb_change_gc(xcb_connection, statusline_ctx, mask, vals);
 
-    if (xcb_request_failed(sl_pm_cookie, "Could not allocate statusline-buffer") ||
-        xcb_request_failed(clear_ctx_cookie, "Could not allocate statusline-buffer-clearcontext") ||
-        xcb_request_failed(sl_ctx_cookie, "Could not allocate statusline-buffer-context")) {
+    const uint32_t height = font.height + 2;
+    if (statusline_pm != XCB_NONE &&
+        statusline_width <= statusline_pm_width &&
+        height == statusline_pm_height)
+        return;
+
+    uint32_t width = MAX(statusline_pm_width, STATUSLINE_PM_MIN_WIDTH);
+    while (width < statusline_width)
+        width *= 2;
+
+    DLOG("Re-allocating statusline-buffer, statusline_width = %d, new size = %dx%d\n",
+         statusline_width, width, height);
+    if (statusline_pm != XCB_NONE)
+        xcb_free_pixmap(xcb_connection, statusline_pm);
+    statusline_pm = xcb_generate_id(xcb_connection);
+    xcb_void_cookie_t sl_pm_cookie = xcb_create_pixmap_checked(xcb_connection,
+                                                               root_screen->root_depth,
+                                                               statusline_pm,
+                                                               xcb_root,
+                                                               width,
+                                                               height);
+    statusline_pm_width = width;
+    statusline_pm_height = height;
+
+    if (xcb_request_failed(sl_pm_cookie, "Could not allocate statusline-buffer")) {
         exit(EXIT_FAILURE);
     }
 
+    log_pixmap_memory();
 }
 
 /*
@@ -1362,7 +1540,6 @@ void reconfig_windows(void) {
             DLOG("Creating Window for output %s\n", walk->name);
 
             walk->bar = xcb_generate_id(xcb_connection);
-            walk->buffer = xcb_generate_id(xcb_connection);
             mask = XCB_CW_BACK_PIXEL | XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK;
             /* Black background */
             values[0] = colors.bar_bg;
@@ -1392,12 +1569,7 @@ void reconfig_windows(void) {
                                                                      values);
 
             /* The double-buffer we use to render stuff off-screen */
-            xcb_void_cookie_t pm_cookie = xcb_create_pixmap_checked(xcb_connection,
-                                                                    root_screen->root_depth,
-                                                                    walk->buffer,
-                                                                    walk->bar,
-                                                                    walk->rect.w,
-                                                                    walk->rect.h);
+            xcb_void_cookie_t pm_cookie = realloc_output_buffer(walk);
 
             /* Set the WM_CLASS and WM_NAME (we don't need UTF-8) atoms */
             xcb_void_cookie_t class_cookie;
@@ -1522,40 +1694,102 @@ void reconfig_windows(void) {
             values[3] = font.height + 6;
             values[4] = XCB_STACK_MODE_ABOVE;
 
-            DLOG("Destroying buffer for output %s\n", walk->name);
-            xcb_free_pixmap(xcb_connection, walk->buffer);
-
             DLOG("Reconfiguring Window for output %s to %d,%d\n", walk->name, values[0], values[1]);
             xcb_void_cookie_t cfg_cookie = xcb_configure_window_checked(xcb_connection,
                                                                         walk->bar,
                                                                         mask,
                                                                         values);
 
-            DLOG("Recreating buffer for output %s\n", walk->name);
-            xcb_void_cookie_t pm_cookie = xcb_create_pixmap_checked(xcb_connection,
-                                                                    root_screen->root_depth,
-                                                                    walk->buffer,
-                                                                    walk->bar,
-                                                                    walk->rect.w,
-                                                                    walk->rect.h);
+            /* The buffer only needs to be re-created when the size of the
+             * bar changed */
+            xcb_void_cookie_t pm_cookie = realloc_output_buffer(walk);
 
             if (xcb_request_failed(cfg_cookie, "Could not reconfigure window")) {
                 exit(EXIT_FAILURE);
             }
-            if (xcb_request_failed(pm_cookie,  "Could not create pixmap")) {
+            if (pm_cookie.sequence != 0 &&
+                xcb_request_failed(pm_cookie,  "Could not create pixmap")) {
                 exit(EXIT_FAILURE);
             }
         }
     }
+
+    resolve_tray_output();
+    log_pixmap_memory();
+}
+
+/*
+ * Marks the workspace buttons of all outputs as outdated, so that the next
+ * draw_bars() renders them again. Has to be called whenever the workspaces or
+ * the binding mode changed.
+ *
+ */
+void invalidate_workspace_buttons(void) {
+    i3_output *walk;
+    SLIST_FOREACH(walk, outputs, slist) {
+        walk->buttons_valid = false;
+    }
+}
+
+/*
+ * Draws one button (a workspace or the binding mode indicator) into the buffer
+ * of the given output, starting at x. Returns the x coordinate right of the
+ * button.
+ *
+ */
+static int draw_button(i3_output *output, int x, i3String *text, int text_width,
+                       uint32_t fg_color, uint32_t bg_color, uint32_t border_color) {
+    uint32_t mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND;
+    uint32_t vals_border[] = { border_color, border_color };
+    xcb_change_gc(xcb_connection,
+                  output->bargc,
+                  mask,
+                  vals_border);
+    xcb_rectangle_t rect_border = { x, 1, text_width + 10, font.height + 4 };
+    xcb_poly_fill_rectangle(xcb_connection,
+                            output->buffer,
+                            output->bargc,
+                            1,
+                            &rect_border);
+    uint32_t vals[] = { bg_color, bg_color };
+    xcb_change_gc(xcb_connection,
+                  output->bargc,
+                  mask,
+                  vals);
+    xcb_rectangle_t rect = { x + 1, 2, text_width + 8, font.height + 2 };
+    xcb_poly_fill_rectangle(xcb_connection,
+                            output->buffer,
+                            output->bargc,
+                            1,
+                            &rect);
+    set_font_colors(output->bargc, fg_color, bg_color);
+    draw_text(text, output->buffer, output->bargc, x + 5, 3, text_width);
+    return x + 10 + text_width + 1;
+}
+
+/*
+ * Copies the given part of the buffer of the output to its bar window.
+ *
+ */
+static void copy_to_bar(i3_output *output, int x, int width) {
+    xcb_copy_area(xcb_connection,
+                  output->buffer,
+                  output->bar,
+                  output->bargc,
+                  x, 0,
+                  x, 0,
+                  width,
+                  output->buffer_height);
 }
 
 /*
- * Render the bars, with buttons and statusline
+ * Render the bars, with buttons and statusline. The workspace buttons are only
+ * rendered if they were invalidated, otherwise only the statusline is updated.
  *
  */
 void draw_bars(bool unhide) {
     DLOG("Drawing Bars...\n");
-    int i = 1;
+    const uint64_t start = latency_now();
 
     refresh_statusline();
 
@@ -1572,148 +1806,132 @@ void draw_bars(bool unhide) {
             /* Oh shit, an active output without an own bar. Create it now! */
             reconfig_windows();
         }
-        /* First things first: clear the backbuffer */
-        uint32_t color = colors.bar_bg;
-        xcb_change_gc(xcb_connection,
-                      outputs_walk->bargc,
-                      XCB_GC_FOREGROUND,
-                      &color);
-        xcb_rectangle_t rect = { 0, 0, outputs_walk->rect.w, font.height + 6 };
-        xcb_poly_fill_rectangle(xcb_connection,
-                                outputs_walk->buffer,
-                                outputs_walk->bargc,
-                                1,
-                                &rect);
-
-        if (!TAILQ_EMPTY(&statusline_head)) {
-            DLOG("Printing statusline!\n");
 
-            /* Luckily we already prepared a seperate pixmap containing the rendered
-             * statusline, we just have to copy the relevant parts to the relevant
-             * position */
-            trayclient *trayclient;
-            int traypx = 0;
-            TAILQ_FOREACH(trayclient, outputs_walk->trayclients, tailq) {
-                if (!trayclient->mapped)
-                    continue;
-                /* We assume the tray icons are quadratic (we use the font
-                 * *height* as *width* of the icons) because we configured them
-                 * like this. */
-                traypx += font.height + 2;
-            }
-            /* Add 2px of padding if there are any tray icons */
-            if (traypx > 0)
-                traypx += 2;
-            xcb_copy_area(xcb_connection,
-                          statusline_pm,
-                          outputs_walk->buffer,
-                          outputs_walk->bargc,
-                          MAX(0, (int16_t)(statusline_width - outputs_walk->rect.w + 4)), 0,
-                          MAX(0, (int16_t)(outputs_walk->rect.w - statusline_width - traypx - 4)), 3,
-                          MIN(outputs_walk->rect.w - traypx - 4, statusline_width), font.height + 2);
-        }
-
-        if (config.disable_ws) {
-            continue;
-        }
-
-        i3_ws *ws_walk;
-
-        TAILQ_FOREACH(ws_walk, outputs_walk->workspaces, tailq) {
-            DLOG("Drawing Button for WS %s at x = %d, len = %d\n", i3string_as_utf8(ws_walk->name), i, ws_walk->name_width);
-            uint32_t fg_color = colors.inactive_ws_fg;
-            uint32_t bg_color = colors.inactive_ws_bg;
-            uint32_t border_color = colors.inactive_ws_border;
-            if (ws_walk->visible) {
-                if (!ws_walk->focused) {
-                    fg_color = colors.active_ws_fg;
-                    bg_color = colors.active_ws_bg;
-                    border_color = colors.active_ws_border;
-                } else {
-                    fg_color = colors.focus_ws_fg;
-                    bg_color = colors.focus_ws_bg;
-                    border_color = colors.focus_ws_border;
-                    if (last_urgent_ws && strcmp(i3string_as_utf8(ws_walk->name), last_urgent_ws) == 0)
-                        walks_away = false;
-                }
-            }
-            if (ws_walk->urgent) {
-                DLOG("WS %s is urgent!\n", i3string_as_utf8(ws_walk->name));
-                fg_color = colors.urgent_ws_fg;
-                bg_color = colors.urgent_ws_bg;
-                border_color = colors.urgent_ws_border;
-                unhide = true;
-                if (!ws_walk->focused) {
-                    FREE(last_urgent_ws);
-                    last_urgent_ws = sstrdup(i3string_as_utf8(ws_walk->name));
-                }
-            }
-            uint32_t mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND;
-            uint32_t vals_border[] = { border_color, border_color };
-            xcb_change_gc(xcb_connection,
-                          outputs_walk->bargc,
-                          mask,
-                          vals_border);
-            xcb_rectangle_t rect_border = { i, 1, ws_walk->name_width + 10, font.height + 4 };
-            xcb_poly_fill_rectangle(xcb_connection,
-                                    outputs_walk->buffer,
-                                    outputs_walk->bargc,
-                                    1,
-                                    &rect_border);
-            uint32_t vals[] = { bg_color, bg_color };
+        /* The workspace buttons are only rendered when they changed. Status
+         * updates (which are far more frequent) only touch the part of the
+         * buffer right of them. */
+        const bool draw_buttons = !outputs_walk->buttons_valid;
+        uint32_t color = colors.bar_bg;
+        if (draw_buttons) {
+            DLOG("Drawing workspace buttons for output %s\n", outputs_walk->name);
+            /* First things first: clear the backbuffer */
             xcb_change_gc(xcb_connection,
                           outputs_walk->bargc,
-                          mask,
-                          vals);
-            xcb_rectangle_t rect = { i + 1, 2, ws_walk->name_width + 8, font.height + 2 };
+                          XCB_GC_FOREGROUND,
+                          &color);
+            xcb_rectangle_t rect = { 0, 0, outputs_walk->rect.w, font.height + 6 };
             xcb_poly_fill_rectangle(xcb_connection,
                                     outputs_walk->buffer,
                                     outputs_walk->bargc,
                                     1,
                                     &rect);
-            set_font_colors(outputs_walk->bargc, fg_color, bg_color);
-            draw_text(ws_walk->name, outputs_walk->buffer, outputs_walk->bargc, i + 5, 3, ws_walk->name_width);
-            i += 10 + ws_walk->name_width + 1;
-
         }
 
-        if (binding.name) {
+        int i = 1;
+        i3_ws *ws_walk;
+        if (!config.disable_ws) {
+            TAILQ_FOREACH(ws_walk, outputs_walk->workspaces, tailq) {
+                uint32_t fg_color = colors.inactive_ws_fg;
+                uint32_t bg_color = colors.inactive_ws_bg;
+                uint32_t border_color = colors.inactive_ws_border;
+                if (ws_walk->visible) {
+                    if (!ws_walk->focused) {
+                        fg_color = colors.active_ws_fg;
+                        bg_color = colors.active_ws_bg;
+                        border_color = colors.active_ws_border;
+                    } else {
+                        fg_color = colors.focus_ws_fg;
+                        bg_color = colors.focus_ws_bg;
+                        border_color = colors.focus_ws_border;
+                        if (last_urgent_ws && strcmp(i3string_as_utf8(ws_walk->name), last_urgent_ws) == 0)
+                            walks_away = false;
+                    }
+                }
+                if (ws_walk->urgent) {
+                    DLOG("WS %s is urgent!\n", i3string_as_utf8(ws_walk->name));
+                    fg_color = colors.urgent_ws_fg;
+                    bg_color = colors.urgent_ws_bg;
+                    border_color = colors.urgent_ws_border;
+                    unhide = true;
+                    if (!ws_walk->focused) {
+                        FREE(last_urgent_ws);
+                        last_urgent_ws = sstrdup(i3string_as_utf8(ws_walk->name));
+                    }
+                }
+                if (draw_buttons) {
+                    DLOG("Drawing Button for WS %s at x = %d, len = %d\n", i3string_as_utf8(ws_walk->name), i, ws_walk->name_width);
+                    draw_button(outputs_walk, i, ws_walk->name, ws_walk->name_width,
+                                fg_color, bg_color, border_color);
+                }
+                i += 10 + ws_walk->name_width + 1;
+            }
 
-            uint32_t fg_color = colors.urgent_ws_fg;
-            uint32_t bg_color = colors.urgent_ws_bg;
-            uint32_t mask = XCB_GC_FOREGROUND | XCB_GC_BACKGROUND;
+            if (binding.name) {
+                if (draw_buttons)
+                    draw_button(outputs_walk, i, binding.name, binding.width,
+                                colors.urgent_ws_fg, colors.urgent_ws_bg, colors.urgent_ws_border);
+                i += 10 + binding.width + 1;
+                unhide = true;
+            }
+        }
 
-            uint32_t vals_border[] = { colors.urgent_ws_border, colors.urgent_ws_border };
-            xcb_change_gc(xcb_connection,
-                          outputs_walk->bargc,
-                          mask,
-                          vals_border);
-            xcb_rectangle_t rect_border = { i, 1, binding.width + 10, font.height + 4 };
-            xcb_poly_fill_rectangle(xcb_connection,
-                                    outputs_walk->buffer,
-                                    outputs_walk->bargc,
-                                    1,
-                                    &rect_border);
+        /* Everything right of the buttons belongs to the statusline, so this
+         * is the only part which changes between workspace updates. */
+        const int sl_start = (i > 1 ? i : 0);
+        outputs_walk->buttons_width = sl_start;
+        outputs_walk->buttons_valid = true;
 
-            uint32_t vals[] = { bg_color, bg_color };
+        if (!draw_buttons) {
             xcb_change_gc(xcb_connection,
                           outputs_walk->bargc,
-                          mask,
-                          vals);
-            xcb_rectangle_t rect = { i + 1, 2, binding.width + 8, font.height + 2 };
+                          XCB_GC_FOREGROUND,
+                          &color);
+            xcb_rectangle_t rect = { sl_start, 0, MAX(0, (int)outputs_walk->rect.w - sl_start), font.height + 6 };
             xcb_poly_fill_rectangle(xcb_connection,
                                     outputs_walk->buffer,
                                     outputs_walk->bargc,
                                     1,
                                     &rect);
+        }
 
-            set_font_colors(outputs_walk->bargc, fg_color, bg_color);
-            draw_text(binding.name, outputs_walk->buffer, outputs_walk->bargc, i + 5, 3, binding.width);
+        if (!TAILQ_EMPTY(&statusline_head)) {
+            DLOG("Printing statusline!\n");
 
-            unhide = true;
+            /* Luckily we already prepared a seperate pixmap containing the rendered
+             * statusline, we just have to copy the relevant parts to the relevant
+             * position */
+            trayclient *trayclient;
+            int traypx = 0;
+            TAILQ_FOREACH(trayclient, outputs_walk->trayclients, tailq) {
+                if (!trayclient->mapped)
+                    continue;
+                /* We assume the tray icons are quadratic (we use the font
+                 * *height* as *width* of the icons) because we configured them
+                 * like this. */
+                traypx += font.height + 2;
+            }
+            /* Add 2px of padding if there are any tray icons */
+            if (traypx > 0)
+                traypx += 2;
+
+            /* The statusline is right-aligned. If it does not fit, its left
+             * part is cut off, the workspace buttons stay visible. */
+            const int sl_end = (int)outputs_walk->rect.w - traypx - 4;
+            const int dst_x = MAX(sl_start, sl_end - (int)statusline_width);
+            const int width = sl_end - dst_x;
+            if (width > 0)
+                xcb_copy_area(xcb_connection,
+                              statusline_pm,
+                              outputs_walk->buffer,
+                              outputs_walk->bargc,
+                              statusline_width - width, 0,
+                              dst_x, 3,
+                              width, font.height + 2);
         }
 
-        i = 0;
+        if (draw_buttons)
+            copy_to_bar(outputs_walk, 0, outputs_walk->rect.w);
+        else copy_to_bar(outputs_walk, sl_start, MAX(0, (int)outputs_walk->rect.w - sl_start));
     }
 
     if (!mod_pressed) {
@@ -1726,7 +1944,25 @@ void draw_bars(bool unhide) {
         }
     }
 
-    redraw_bars();
+    xcb_flush(xcb_connection);
+    latency_record(&draw_latency, start);
+}
+
+/*
+ * Prints the latency histogram of draw_bars() (in the same format as the
+ * latency statistics of i3’s GET_STATS reply) to stderr.
+ *
+ */
+void print_draw_stats(void) {
+    json_writer writer;
+    memset(&writer, 0, sizeof(json_writer));
+    latency_dump(&writer, &draw_latency, NULL);
+
+    const unsigned char *buf;
+    size_t len;
+    json_writer_get_buf(&writer, &buf, &len);
+    fprintf(stderr, "%s\n", buf);
+    json_writer_free(&writer);
 }
 
 /*
@@ -1745,8 +1981,8 @@ void redraw_bars(void) {
                       outputs_walk->bargc,
                       0, 0,
                       0, 0,
-                      outputs_walk->rect.w,
-                      outputs_walk->rect.h);
+                      outputs_walk->buffer_width,
+                      outputs_walk->buffer_height);
         xcb_flush(xcb_connection);
     }
 }
@@ -1759,5 +1995,6 @@ void set_current_mode(struct mode *current) {
     I3STRING_FREE(binding.name);
     binding = *current;
     activated_mode = binding.name != NULL;
+    invalidate_workspace_buttons();
     return;
 }
@@ -83,5 +83,10 @@
 #include "config_parser.h"
 #include "fake_outputs.h"
 #include "display_version.h"
+#include "restart_snapshot.h"
+#include "pool.h"
+#include "tree_snapshot.h"
+#include "latency.h"
+#include "x_stats.h"
 
 #endif
@@ -10,7 +10,7 @@
 #ifndef I3_COMMANDS_PARSER_H
 #define I3_COMMANDS_PARSER_H
 
-#include <yajl/yajl_gen.h>
+#include "libi3.h"
 
 /*
  * Holds the result of a call to any command. When calling
@@ -22,8 +22,8 @@
  *
  */
 struct CommandResult {
-    /* The JSON generator to append a reply to. */
-    yajl_gen json_gen;
+    /* The JSON writer to append a reply to. */
+    json_writer *json_gen;
 
     /* Whether the command requires calling tree_render. */
     bool needs_tree_render;
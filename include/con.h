@@ -80,9 +80,20 @@ Con *con_parent_with_orientation(Con *con, orientation_t orientation);
 /**
  * Returns the first fullscreen node below this node.
  *
+ * The result is cached for workspaces (with CF_OUTPUT) and the root container
+ * (with CF_GLOBAL), which is what rendering asks for.
+ *
  */
 Con *con_get_fullscreen_con(Con *con, int fullscreen_mode);
 
+/**
+ * Invalidates the cached fullscreen containers of the workspace and the root
+ * container above the given container. Needs to be called whenever a
+ * fullscreen container could have been added below them.
+ *
+ */
+void con_invalidate_fullscreen_con(Con *con);
+
 /**
  * Returns true if the container is internal, such as __i3_scratch
  *
@@ -322,6 +333,46 @@ bool con_fullscreen_permits_focusing(Con *con);
  */
 bool con_has_urgent_child(Con *con);
 
+/**
+ * Sets the urgent flag of the given container and keeps the urgent_windows
+ * counts of the container and its ancestors up to date. The urgent flags of
+ * the parents are not touched, see con_update_parents_urgency().
+ *
+ */
+void con_set_urgent_flag(Con *con, bool urgent);
+
+/**
+ * Sets the window of the given container (or takes it away when window is
+ * NULL), keeping the urgent_windows counts up to date.
+ *
+ */
+void con_set_window(Con *con, i3Window *window);
+
+/**
+ * Adds the aggregates (see num_children and urgent_windows in struct Con) of
+ * the given container to its parent and all further ancestors. Called by
+ * con_attach() and needs to be called by all code which links a container
+ * into its parent’s nodes_head or floating_head by hand.
+ *
+ */
+void con_aggregates_attach(Con *con);
+
+/**
+ * Removes the aggregates of the given container from its ancestors. Called by
+ * con_detach(), needs to be called before unlinking a container by hand.
+ *
+ */
+void con_aggregates_detach(Con *con);
+
+#ifdef DEBUG_AGGREGATES
+/**
+ * Recomputes the aggregates of every container below (and including) the
+ * given one and aborts on the first mismatch.
+ *
+ */
+void con_verify_aggregates(Con *con);
+#endif
+
 /**
  * Make all parent containers urgent if con is urgent or clear the urgent flag
  * of all parent containers if there are no more urgent children left.
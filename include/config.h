@@ -95,6 +95,11 @@ struct Config {
     char *ipc_socket_path;
     const char *restart_state_path;
 
+    /** Whether to store the layout as a binary snapshot instead of JSON for
+     * in-place restarts. Faster to write and load, but only understood by
+     * the same version of i3. */
+    bool restart_state_binary;
+
     int default_layout;
     int container_stack_limit;
     int container_stack_limit_value;
@@ -253,6 +258,10 @@ struct Barconfig {
      * Will be passed to the shell. */
     char *status_command;
 
+    /** Minimum time (in milliseconds) between two redraws caused by the
+     * statusline. 0 (the default) means every update is drawn. */
+    int status_interval;
+
     /** Font specification for all text rendered on the bar. */
     char *font;
 
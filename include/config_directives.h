@@ -49,6 +49,7 @@ CFGFUN(hide_edge_borders, const char *borders);
 CFGFUN(assign, const char *workspace);
 CFGFUN(ipc_socket, const char *path);
 CFGFUN(restart_state, const char *path);
+CFGFUN(restart_state_format, const char *format);
 CFGFUN(popup_during_fullscreen, const char *value);
 CFGFUN(color, const char *colorclass, const char *border, const char *background, const char *text, const char *indicator);
 CFGFUN(color_single, const char *colorclass, const char *color);
@@ -72,6 +73,7 @@ CFGFUN(bar_socket_path, const char *socket_path);
 CFGFUN(bar_tray_output, const char *output);
 CFGFUN(bar_color_single, const char *colorclass, const char *color);
 CFGFUN(bar_status_command, const char *command);
+CFGFUN(bar_status_interval, const long interval_ms);
 CFGFUN(bar_workspace_buttons, const char *value);
 CFGFUN(bar_finish);
 
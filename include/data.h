@@ -175,6 +175,10 @@ struct Startup_Sequence {
     TAILQ_ENTRY(Startup_Sequence) sequences;
 };
 
+/** Number of recently matched inputs remembered per regular expression (see
+ * struct regex). */
+#define REGEX_MEMO_SIZE 8
+
 /**
  * Regular expression wrapper. It contains the pattern itself as a string (like
  * ^foo[0-9]$) as well as a pointer to the compiled PCRE expression and the
@@ -188,6 +192,30 @@ struct regex {
     char *pattern;
     pcre *regex;
     pcre_extra *extra;
+
+    /** If the pattern does not use any regular expression syntax (apart from
+     * ^ and $ anchors), it is matched with plain string comparisons against
+     * this literal instead of calling into PCRE. */
+    enum {
+        RL_NONE = 0,
+        RL_SUBSTRING,
+        RL_PREFIX,
+        RL_SUFFIX,
+        RL_EXACT
+    } literal_type;
+    char *literal;
+    size_t literal_len;
+
+    /** Remembers the outcome for the most recently tested input strings, so
+     * that evaluating the same criteria on the same window class over and
+     * over (e.g. for_window on every title change) does not hit PCRE. The
+     * inputs are interned, so interned inputs (like i3Window’s class_class)
+     * are found by pointer comparison. */
+    struct regex_memo {
+        const char *input;
+        uint32_t hash;
+        bool matches;
+    } memo[REGEX_MEMO_SIZE];
 };
 
 /******************************************************************************
@@ -303,16 +331,19 @@ struct Window {
     xcb_window_t leader;
     xcb_window_t transient_for;
 
-    char *class_class;
-    char *class_instance;
+    /** WM_CLASS of this window. Both strings are interned (see
+     * intern_string()), so they are shared between all windows of the same
+     * class and can be compared by pointer. */
+    const char *class_class;
+    const char *class_instance;
 
     /** The name of the window. */
     i3String *name;
 
     /** The WM_WINDOW_ROLE of this window (for example, the pidgin buddy window
      * sets "buddy list"). Useful to match specific windows in assignments or
-     * for_window. */
-    char *role;
+     * for_window. Interned, just like the WM_CLASS strings. */
+    const char *role;
 
     /** Flag to force re-rendering the decoration upon changes */
     bool name_x_changed;
@@ -459,6 +490,11 @@ struct Con {
 
     char *name;
 
+    /** For workspaces: the interned, case-folded name, so that workspaces
+     * can be looked up by name using pointer comparisons (see
+     * workspace_name_key()). NULL for all other containers. */
+    const char *name_key;
+
     /** the workspace number, if this Con is of type CT_WORKSPACE and the
      * workspace is not a named workspace (for named workspaces, num == -1) */
     int num;
@@ -496,6 +532,15 @@ struct Con {
      * inside this container (if any) sets the urgency hint, for example. */
     bool urgent;
 
+    /** Incrementally maintained aggregates, kept up to date by con_attach()
+     * and con_detach() (see con_aggregates_attach()) and by
+     * con_set_urgent_flag(): the number of tiling children (see
+     * con_num_children()) and the number of containers with an urgent
+     * window in the subtree rooted at this container (including floating
+     * containers and the container itself). */
+    int num_children;
+    int urgent_windows;
+
     /* timer used for disabling urgency */
     struct ev_timer *urgency_timer;
 
@@ -517,6 +562,12 @@ struct Con {
     TAILQ_HEAD(swallow_head, Match) swallow_head;
 
     enum { CF_NONE = 0, CF_OUTPUT = 1, CF_GLOBAL = 2 } fullscreen_mode;
+    /** For workspaces (CF_OUTPUT) and the root container (CF_GLOBAL): the
+     * cached result of con_get_fullscreen_con(), which render_con() needs
+     * for every container. Only used when fullscreen_con_valid is true, see
+     * con_invalidate_fullscreen_con(). */
+    Con *fullscreen_con;
+    bool fullscreen_con_valid;
     /* layout is the layout of this container: one of split[v|h], stacked or
      * tabbed. Special containers in the tree (above workspaces) have special
      * layouts like dockarea or output.
@@ -566,6 +617,11 @@ struct Con {
     TAILQ_ENTRY(Con) all_cons;
     TAILQ_ENTRY(Con) floating_windows;
 
+    /** Chains of the workspace index by name and by number (only used for
+     * workspaces, see workspace_index_add()) */
+    SLIST_ENTRY(Con) ws_by_name;
+    SLIST_ENTRY(Con) ws_by_num;
+
     /** callbacks */
     void(*on_remove_child)(Con *);
 
@@ -52,6 +52,12 @@ typedef struct i3_ipc_header {
 /** Request the i3 version */
 #define I3_IPC_MESSAGE_TYPE_GET_VERSION         7
 
+/** Request internal statistics (allocators) of i3 */
+#define I3_IPC_MESSAGE_TYPE_GET_STATS           8
+
+/** Execute a list of commands as one transaction (rendering only once) */
+#define I3_IPC_MESSAGE_TYPE_COMMAND_BATCH       9
+
 /*
  * Messages from i3 to clients
  *
@@ -81,6 +87,12 @@ typedef struct i3_ipc_header {
 /** i3 version reply type */
 #define I3_IPC_REPLY_TYPE_VERSION               7
 
+/** Statistics reply type */
+#define I3_IPC_REPLY_TYPE_STATS                 8
+
+/** Command batch reply type */
+#define I3_IPC_REPLY_TYPE_COMMAND_BATCH         9
+
 /*
  * Events from i3 to clients. Events have the first bit set high.
  *
@@ -12,7 +12,6 @@
 
 #include <ev.h>
 #include <stdbool.h>
-#include <yajl/yajl_gen.h>
 #include <yajl/yajl_parse.h>
 
 #include "data.h"
@@ -73,6 +72,14 @@ int ipc_create_socket(const char *filename);
  */
 void ipc_send_event(const char *event, uint32_t message_type, const char *payload);
 
+/**
+ * Returns true if at least one of the connected IPC clients subscribed to the
+ * given event. Event producers check this before generating the payload, so
+ * that no time is spent on events nobody receives.
+ *
+ */
+bool ipc_has_subscribers(const char *event);
+
 /**
  * Calls shutdown() on each socket and closes it. This function to be called
  * when exiting or restarting only!
@@ -80,6 +87,13 @@ void ipc_send_event(const char *event, uint32_t message_type, const char *payloa
  */
 void ipc_shutdown(void);
 
-void dump_node(yajl_gen gen, Con *con, bool inplace_restart);
+void dump_node(json_writer *gen, Con *con, bool inplace_restart);
+
+/**
+ * Dumps the given container without its children, for the "container" of
+ * events like the window event.
+ *
+ */
+void dump_event_node(json_writer *gen, Con *con);
 
 #endif
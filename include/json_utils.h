@@ -0,0 +1,20 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * json_utils.h
+ *
+ */
+#ifndef I3_JSON_UTILS_H
+#define I3_JSON_UTILS_H
+
+/* Shorter names for all those json_writer_* functions. The writer is expected
+ * to be called 'gen'. */
+#define y(x, ...) json_writer_ ## x (gen, ##__VA_ARGS__)
+#define ystr(str) json_writer_string(gen, str)
+/* For string literals which are used as map keys. */
+#define ykey(key) json_writer_key(gen, key)
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * latency.c: Latency histograms of the main pipeline stages (rendering, event
+ *            handling, IPC), reported by GET_STATS.
+ *
+ */
+#ifndef I3_LATENCY_H
+#define I3_LATENCY_H
+
+/** The stages which are measured (apart from events and IPC messages, which
+ * have one histogram per type). */
+typedef enum {
+    LATENCY_PARSE_COMMAND = 0,
+    LATENCY_RENDER_CON,
+    LATENCY_X_PUSH_CHANGES,
+    LATENCY_X_DECO_RECURSE,
+    LATENCY_MANAGE_WINDOW,
+    LATENCY_STAGES
+} latency_stage;
+
+extern latency_histogram latency_stages[LATENCY_STAGES];
+
+/**
+ * Records the time since start (a return value of latency_now()) for the given
+ * stage.
+ *
+ */
+#define LATENCY_RECORD(stage, start) latency_record(&latency_stages[stage], start)
+
+/**
+ * Records how long handle_event() took for an X11 event of the given type.
+ *
+ */
+void latency_record_event(int type, uint64_t start);
+
+/**
+ * Records how long the IPC handler for the given message type took.
+ *
+ */
+void latency_record_ipc(uint32_t message_type, uint64_t start);
+
+/**
+ * Returns the name of the given X11 event type (without the "generated" bit),
+ * like "MapRequest". Unknown (extension) events are formatted into buffer.
+ *
+ */
+const char *event_type_name(int type, char *buffer, size_t size);
+
+/**
+ * Generates the latency statistics as a JSON map with the keys "stages",
+ * "events" and "ipc".
+ *
+ */
+void latency_dump_stats(json_writer *gen);
+
+/**
+ * Empties all histograms.
+ *
+ */
+void latency_reset_stats(void);
+
+#endif
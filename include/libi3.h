@@ -190,6 +190,274 @@ size_t i3string_get_num_bytes(i3String *str);
  */
 size_t i3string_get_num_glyphs(i3String *str);
 
+/**
+ * Returns the interned copy of the first len bytes of the given string (which
+ * does not need to be NUL-terminated). The returned string is NUL-terminated.
+ * Equal strings always yield the same pointer, so interned strings can be
+ * compared and hashed by pointer.
+ *
+ * Every call takes a reference, which has to be given back with
+ * release_interned_string().
+ *
+ */
+const char *intern_string_with_length(const char *str, size_t len);
+
+/**
+ * Returns the interned copy of the given string, see
+ * intern_string_with_length().
+ *
+ */
+const char *intern_string(const char *str);
+
+/**
+ * Returns the interned copy of the given string without taking a reference,
+ * or NULL if the string is not interned. Useful for lookups: if a string is
+ * not interned, no interned string can be equal to it.
+ *
+ */
+const char *lookup_interned_string(const char *str);
+
+/**
+ * Takes an additional reference to an already interned string and returns it.
+ *
+ */
+const char *ref_interned_string(const char *interned);
+
+/**
+ * Gives back a reference to an interned string. When the last reference is
+ * gone, the string is freed. Passing NULL is a no-op.
+ *
+ */
+void release_interned_string(const char *interned);
+
+/**
+ * An append-only JSON writer, writing into a growable buffer which is kept
+ * between documents (see json_writer_reset()). Like with yajl_gen, commas and
+ * colons are inserted automatically: inside a map, strings alternate between
+ * keys and values. A zeroed struct is a valid, empty writer.
+ *
+ */
+typedef struct json_writer {
+    char *buf;
+    size_t len;
+    size_t size;
+
+    /* The state of every open map/array. */
+    unsigned char *stack;
+    int depth;
+    int stack_size;
+} json_writer;
+
+/**
+ * Empties the writer, so that a new document can be generated. The buffer is
+ * kept, so a writer which is re-used does not allocate once it has grown to
+ * the size of the biggest document.
+ *
+ */
+void json_writer_reset(json_writer *writer);
+
+/**
+ * Frees the buffers of the writer (but not the json_writer itself).
+ *
+ */
+void json_writer_free(json_writer *writer);
+
+/**
+ * Returns the generated JSON. The buffer is NUL-terminated (the terminating
+ * NUL byte is not included in len) and belongs to the writer.
+ *
+ */
+void json_writer_get_buf(json_writer *writer, const unsigned char **buf, size_t *len);
+
+void json_writer_map_open(json_writer *writer);
+void json_writer_map_close(json_writer *writer);
+void json_writer_array_open(json_writer *writer);
+void json_writer_array_close(json_writer *writer);
+
+/**
+ * Appends the first len bytes of str as a JSON string (a key or a value,
+ * depending on the position inside a map), escaping it as necessary. The
+ * string is expected to be UTF-8 and is not validated.
+ *
+ */
+void json_writer_string_len(json_writer *writer, const char *str, size_t len);
+void json_writer_string(json_writer *writer, const char *str);
+
+/**
+ * Appends a map key which is already quoted and escaped, see json_writer_key().
+ *
+ */
+void json_writer_key_literal(json_writer *writer, const char *quoted, size_t len);
+
+/**
+ * Appends a map key given as a string literal (which must not need any
+ * escaping). The quoted key and its length are computed at compile time.
+ *
+ */
+#define json_writer_key(writer, key) json_writer_key_literal((writer), "\"" key "\"", sizeof(key) + 1)
+
+/**
+ * Appends an already generated JSON value (e.g. the output of another
+ * json_writer) as the next value.
+ *
+ */
+void json_writer_raw(json_writer *writer, const char *json, size_t len);
+
+void json_writer_integer(json_writer *writer, long long number);
+
+/**
+ * Appends a floating point number. The output does not depend on the locale
+ * (unlike yajl_gen_double(), which needs LC_NUMERIC to be "C"). Numbers
+ * without a fractional part get a ".0", so that they are still parsed as
+ * floating point numbers. NaN and infinity cannot be represented in JSON,
+ * they are written as null.
+ *
+ */
+void json_writer_double(json_writer *writer, double number);
+void json_writer_bool(json_writer *writer, bool value);
+void json_writer_null(json_writer *writer);
+
+struct i3_shmtree_header;
+
+/**
+ * Reads the tree snapshots which i3 publishes in shared memory (see
+ * include/shmtree.h). A zeroed struct is a closed reader.
+ *
+ */
+typedef struct shmtree_reader {
+    int fd;
+    void *mapping;
+    size_t mapping_size;
+
+    /* The private copy of the last consistent snapshot. */
+    void *snapshot;
+    size_t snapshot_size;
+    uint32_t sequence;
+} shmtree_reader;
+
+/**
+ * Opens the SHM segment with the given name (the contents of the
+ * I3_SHMTREE_PATH atom) read-only. Returns false if it cannot be opened.
+ *
+ */
+bool shmtree_open(shmtree_reader *reader, const char *name);
+
+/**
+ * Returns true if i3 published a new snapshot since the last shmtree_read()
+ * (without copying anything).
+ *
+ */
+bool shmtree_changed(shmtree_reader *reader);
+
+/**
+ * Copies a consistent snapshot out of the segment and returns it (use
+ * I3_SHMTREE_NODES() and I3_SHMTREE_NAME() to access it). The snapshot
+ * belongs to the reader and is valid until the next call. Returns NULL if i3
+ * did not publish a (compatible) snapshot.
+ *
+ * No syscalls are made unless the segment grew, or i3 is writing a snapshot
+ * at the same time.
+ *
+ */
+const struct i3_shmtree_header *shmtree_read(shmtree_reader *reader);
+
+/**
+ * Unmaps the segment and frees the snapshot.
+ *
+ */
+void shmtree_close(shmtree_reader *reader);
+
+/**
+ * Number of buckets of a latency_histogram. Bucket 0 counts durations below
+ * 1 µs, bucket i durations of at least 2^(i-1) and below 2^i µs, the last
+ * bucket everything longer (about 4 seconds and up).
+ *
+ */
+#define LATENCY_BUCKETS 24
+
+/**
+ * A histogram of how long something took, with logarithmic buckets (so that
+ * recording is just a few instructions and the histogram has a fixed size).
+ * A zeroed struct (apart from the name) is an empty histogram.
+ *
+ */
+typedef struct latency_histogram {
+    const char *name;
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[LATENCY_BUCKETS];
+} latency_histogram;
+
+/**
+ * Returns the current time in nanoseconds (from a monotonic clock, only
+ * useful for latency_record()).
+ *
+ */
+uint64_t latency_now(void);
+
+/**
+ * Records the time since start (a return value of latency_now()).
+ *
+ */
+void latency_record(latency_histogram *histogram, uint64_t start);
+
+/**
+ * Empties the histogram.
+ *
+ */
+void latency_reset(latency_histogram *histogram);
+
+/**
+ * Generates a JSON map with the name, count, total_us, max_us and buckets of
+ * the histogram. If name is not NULL, it is used instead of histogram->name.
+ *
+ */
+void latency_dump(json_writer *writer, const latency_histogram *histogram, const char *name);
+
+/**
+ * Statistics of one place in the code which waits for a reply from the X11
+ * server (or checks a request), see X_WAIT().
+ *
+ */
+typedef struct x_call_site {
+    const char *file;
+    int line;
+    const char *function;
+
+    uint64_t count;
+    uint64_t wait_ns;
+    uint64_t max_wait_ns;
+
+    /** Whether the site is in the list of sites (it is added on first use). */
+    bool registered;
+    struct x_call_site *next;
+} x_call_site;
+
+/**
+ * Called after every X_WAIT() with the call site and the time the wait
+ * started (a return value of latency_now()). NULL (the default) disables
+ * the accounting, i3 sets it to account the waits in GET_STATS.
+ *
+ */
+extern void (*x_wait_hook)(x_call_site *site, uint64_t start);
+
+/**
+ * Calls the given (blocking) reply function, e.g.
+ * X_WAIT(xcb_get_property_reply, conn, cookie, NULL), and passes the time
+ * spent waiting to x_wait_hook (if set). Evaluates to the return value of
+ * the function.
+ *
+ */
+#define X_WAIT(call, ...) ({ \
+    static x_call_site x_site_ = { .file = I3__FILE__, .line = __LINE__, .function = #call }; \
+    const uint64_t x_start_ = (x_wait_hook != NULL ? latency_now() : 0); \
+    __typeof__(call(__VA_ARGS__)) x_result_ = call(__VA_ARGS__); \
+    if (x_wait_hook != NULL) \
+        x_wait_hook(&x_site_, x_start_); \
+    x_result_; \
+})
+
 /**
  * Connects to the i3 IPC socket and returns the file descriptor for the
  * socket. die()s if anything goes wrong.
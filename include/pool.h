@@ -0,0 +1,79 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * pool.c: Typed slab pools for the structures which are allocated and freed
+ *         all the time (containers, windows, X11 states, decoration caches).
+ *
+ */
+#ifndef I3_POOL_H
+#define I3_POOL_H
+
+/**
+ * A pool hands out objects of one fixed size. The memory is allocated in
+ * slabs of many objects at once, freed objects are kept on a free list and
+ * handed out again, so that window churn does not fragment the heap.
+ *
+ */
+struct pool {
+    /** Name of the pool, used in the allocator statistics. */
+    const char *name;
+    /** Size of one object (before rounding it up for alignment). */
+    size_t object_size;
+
+    /** Singly linked list of free objects, the link is stored in the first
+     * bytes of the free objects themselves. */
+    void *free_list;
+
+    /** Statistics */
+    uint32_t slabs;
+    uint32_t objects_per_slab;
+    uint32_t in_use;
+    uint32_t peak_in_use;
+    uint64_t allocations;
+
+    SLIST_ENTRY(pool) pools;
+};
+
+#define POOL_INITIALIZER(pool_name, type) { .name = pool_name, .object_size = sizeof(type) }
+
+/** Frees the object (if not NULL) back into the pool and sets the pointer to
+ * NULL, just like FREE() does for malloc()ed memory. */
+#define POOL_FREE(pool, pointer) do { \
+        if (pointer != NULL) { \
+                pool_free(pool, pointer); \
+                pointer = NULL; \
+        } \
+} \
+while (0)
+
+extern struct pool con_pool;
+extern struct pool window_pool;
+extern struct pool con_state_pool;
+extern struct pool deco_render_params_pool;
+
+/**
+ * Returns a zeroed object from the given pool. Like scalloc(), this exits i3
+ * when no memory can be allocated.
+ *
+ */
+void *pool_alloc(struct pool *pool);
+
+/**
+ * Gives an object which was returned by pool_alloc() back to its pool. The
+ * memory is not returned to the system, it will be re-used by the next
+ * pool_alloc() call.
+ *
+ */
+void pool_free(struct pool *pool, void *object);
+
+/**
+ * Generates the allocator statistics (one map per pool which was used so far)
+ * as a JSON array.
+ *
+ */
+void pool_dump_stats(json_writer *gen);
+
+#endif
@@ -14,7 +14,11 @@
  * Creates a new 'regex' struct containing the given pattern and a PCRE
  * compiled regular expression. Also, calls pcre_study because this regex will
  * most likely be used often (like for every new window and on every relevant
- * property change of existing windows).
+ * property change of existing windows). When PCRE supports it, the regular
+ * expression is JIT compiled.
+ *
+ * Patterns which turn out to be plain literals are not compiled at all, they
+ * are matched using string comparisons.
  *
  * Returns NULL if the pattern could not be compiled into a regular expression
  * (and ELOGs an appropriate error message).
@@ -30,8 +34,8 @@ void regex_free(struct regex *regex);
 
 /**
  * Checks if the given regular expression matches the given input and returns
- * true if it does. In either case, it logs the outcome using LOG(), so it will
- * be visible without debug logging.
+ * true if it does. The outcome is logged using DLOG(), only errors are
+ * visible without debug logging.
  *
  */
 bool regex_matches(struct regex *regex, const char *input);
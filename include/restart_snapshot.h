@@ -0,0 +1,40 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * restart_snapshot.c: A compact binary snapshot of the layout tree, which can
+ *                     be used instead of JSON for in-place restarts.
+ *
+ */
+#ifndef I3_RESTART_SNAPSHOT_H
+#define I3_RESTART_SNAPSHOT_H
+
+/**
+ * Writes a binary snapshot of the whole tree (like dump_node() with
+ * inplace_restart == true would) to the given file descriptor.
+ *
+ * Returns false if the snapshot could not be written.
+ *
+ */
+bool restart_snapshot_store(int fd);
+
+/**
+ * Returns true if the given file is a binary tree snapshot (as opposed to a
+ * JSON layout).
+ *
+ */
+bool restart_snapshot_detect(const char *filename);
+
+/**
+ * Loads the binary tree snapshot from the given file and appends it to the
+ * focused container, just like tree_append_json() does for JSON layouts.
+ *
+ * Returns false (and appends nothing) if the snapshot could not be read or is
+ * truncated.
+ *
+ */
+bool restart_snapshot_load(const char *filename);
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * The format of the tree snapshot which i3 publishes in a shared memory
+ * segment (see I3_SHMTREE_PATH), so that clients which only read the layout
+ * do not need to poll GET_TREE over IPC.
+ *
+ */
+#ifndef I3_I3_SHMTREE_H
+#define I3_I3_SHMTREE_H
+
+#include <stdint.h>
+
+/* "i3tr" */
+#define I3_SHMTREE_MAGIC 0x72743369
+/* Incremented whenever the layout of the structures below changes. */
+#define I3_SHMTREE_VERSION 1
+
+/* Used for node indices which do not refer to a node (the parent of the root
+ * node, the focused child of a container without children). */
+#define I3_SHMTREE_NONE UINT32_MAX
+
+/*
+ * Header of the shmtree segment. Used by i3/src/tree_snapshot.c and
+ * i3/libi3/shmtree_reader.c.
+ *
+ * The header is followed by data_size bytes of snapshot data: num_nodes
+ * i3_shmtree_node structs, followed by the (not NUL-terminated) names.
+ *
+ */
+typedef struct i3_shmtree_header {
+    uint32_t magic;
+    uint32_t version;
+
+    /* Sequence counter of the seqlock which protects everything after the
+     * header. It is odd while i3 is writing a new snapshot and incremented
+     * to an even number afterwards. Readers copy the snapshot and retry if the
+     * counter was odd or changed in the meantime. */
+    uint32_t sequence;
+
+    /* Size of the whole segment in bytes. The segment only ever grows, a
+     * reader whose mapping is smaller than this has to map it again. */
+    uint32_t size;
+
+    /* Number of bytes of snapshot data after the header. */
+    uint32_t data_size;
+
+    uint32_t num_nodes;
+
+    /* Index of the focused node. */
+    uint32_t focused;
+
+    uint32_t reserved;
+} i3_shmtree_header;
+
+typedef struct i3_shmtree_rect {
+    int32_t x;
+    int32_t y;
+    uint32_t width;
+    uint32_t height;
+} i3_shmtree_rect;
+
+/* Flags of an i3_shmtree_node */
+#define I3_SHMTREE_URGENT     (1 << 0)
+#define I3_SHMTREE_FOCUSED    (1 << 1)
+#define I3_SHMTREE_FLOATING   (1 << 2)
+#define I3_SHMTREE_FULLSCREEN (1 << 3)
+
+/*
+ * One container. The nodes are stored in pre-order (each container is
+ * followed by its tiling and then its floating children, recursively), so the
+ * subtree of node i consists of the nodes i to i + subtree_size - 1.
+ *
+ */
+typedef struct i3_shmtree_node {
+    /* The same ID as the "id" in a GET_TREE reply. */
+    uint64_t id;
+
+    /* Index of the parent node (I3_SHMTREE_NONE for the root). */
+    uint32_t parent;
+
+    /* Number of nodes in the subtree of this node, including the node. */
+    uint32_t subtree_size;
+
+    /* Index of the child which is on top of the focus stack
+     * (I3_SHMTREE_NONE if the container has no children). */
+    uint32_t focus_child;
+
+    /* The X11 window ID (0 if the container has no window). */
+    uint32_t window;
+
+    /* "type" and "num" are the same as in GET_TREE, "layout" is the numeric
+     * value of the layout (L_STACKED = 1 etc., see include/data.h). */
+    uint8_t type;
+    uint8_t layout;
+    uint8_t flags;
+    uint8_t reserved;
+    int32_t num;
+
+    i3_shmtree_rect rect;
+
+    /* The name (UTF-8, not NUL-terminated). The offset is relative to the
+     * end of the node array. */
+    uint32_t name_offset;
+    uint32_t name_length;
+} i3_shmtree_node;
+
+/* Returns the node array of a snapshot (a pointer to its header). */
+#define I3_SHMTREE_NODES(header) \
+    ((const i3_shmtree_node*)((const char*)(header) + sizeof(i3_shmtree_header)))
+
+/* Returns the (not NUL-terminated) name of the given node of a snapshot. */
+#define I3_SHMTREE_NAME(header, node) \
+    ((const char*)(I3_SHMTREE_NODES(header) + (header)->num_nodes) + (node)->name_offset)
+
+#endif
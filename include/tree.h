@@ -57,6 +57,14 @@ bool level_down(void);
  */
 void tree_render(void);
 
+/**
+ * While deferred is true, tree_render() only remembers that the tree needs to
+ * be rendered. Setting it back to false renders the tree once if
+ * tree_render() was called in the meantime.
+ *
+ */
+void tree_defer_render(bool deferred);
+
 /**
  * Closes the current container using tree_close().
  *
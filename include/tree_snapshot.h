@@ -0,0 +1,40 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * tree_snapshot.c: Publishes a compact binary snapshot of the tree in a shared
+ *                  memory segment after every x_push_changes(), so that
+ *                  clients which only read the layout (status bars, window
+ *                  switchers) do not need to poll GET_TREE.
+ *
+ */
+#ifndef I3_TREE_SNAPSHOT_H
+#define I3_TREE_SNAPSHOT_H
+
+/* The name of the SHM segment (empty if no snapshot is published). Stored in
+ * the I3_SHMTREE_PATH atom. */
+extern char *shmtreename;
+
+/**
+ * Creates the shared memory segment. Called once on startup, before the first
+ * tree_render().
+ *
+ */
+void tree_snapshot_init(void);
+
+/**
+ * Removes the shared memory segment. Called when i3 exits.
+ *
+ */
+void tree_snapshot_unlink(void);
+
+/**
+ * Publishes a snapshot of the current tree (if it changed since the last
+ * one). Called at the end of x_push_changes().
+ *
+ */
+void tree_snapshot_publish(void);
+
+#endif
@@ -59,6 +59,14 @@ int max(int a, int b);
 bool rect_contains(Rect rect, uint32_t x, uint32_t y);
 Rect rect_add(Rect a, Rect b);
 
+/**
+ * Shrinks either *width or *height, so that the result is the largest size
+ * with the aspect ratio ratio_width:ratio_height (rounded down to whole
+ * pixels) which fits into the original *width x *height.
+ *
+ */
+void fit_aspect_ratio(uint32_t *width, uint32_t *height, uint32_t ratio_width, uint32_t ratio_height);
+
 /**
  * Updates *destination with new_value and returns true if it was changed or false
  * if it was the same
@@ -15,6 +15,57 @@
 #include "tree.h"
 #include "randr.h"
 
+/**
+ * Returns the interned, case-folded version of the given workspace name.
+ * Workspace names are compared case-insensitively, so two names refer to the
+ * same workspace if and only if their keys are the same pointer.
+ *
+ * If create is true, a reference is taken which has to be given back with
+ * release_interned_string(). Otherwise, no reference is taken and NULL is
+ * returned if the key was never interned, in which case no workspace can have
+ * that name.
+ *
+ */
+const char *workspace_name_key(const char *name, bool create);
+
+/**
+ * Adds the given workspace to the index of workspaces by name and by number.
+ * Called by con_attach() for every workspace, after its name_key was set.
+ *
+ */
+void workspace_index_add(Con *ws);
+
+/**
+ * Removes the given workspace from the workspace index. Called by
+ * con_detach() for every workspace.
+ *
+ */
+void workspace_index_remove(Con *ws);
+
+/**
+ * Returns the existing workspace with the given name (compared
+ * case-insensitively) or NULL if there is no such workspace. Does not walk
+ * the tree.
+ *
+ */
+Con *workspace_by_name(const char *name);
+
+/**
+ * Returns the existing workspace with the given number or NULL if there is no
+ * such workspace. If several workspaces share the number, the first one in
+ * tree order is returned.
+ *
+ */
+Con *workspace_by_number(int num);
+
+/**
+ * Forgets the workspace names which were derived from the "workspace <name>"
+ * key bindings (see create_workspace_on_output()). Needs to be called
+ * whenever the bindings are freed, that is when reloading the configuration.
+ *
+ */
+void workspace_invalidate_binding_names(void);
+
 /**
  * Returns a pointer to the workspace with the given number (starting at 0),
  * creating the workspace if necessary (by allocating the necessary amount of
@@ -0,0 +1,65 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * x_stats.c: Accounting of X11 requests and blocking round-trips, per
+ *            tree_render(), per handled event and per call site.
+ *
+ */
+#ifndef I3_X_STATS_H
+#define I3_X_STATS_H
+
+/**
+ * Counters at the start of a span (a tree_render() or an event), see
+ * x_stats_begin().
+ *
+ */
+typedef struct x_stats_span {
+    uint64_t sent;
+    uint64_t round_trips;
+    uint64_t wait_ns;
+} x_stats_span;
+
+/**
+ * Accounts a wait which started at start (a return value of latency_now())
+ * to the given call site. Installed as x_wait_hook by main(), so that the
+ * X_WAIT() call sites in i3 and in libi3 are accounted.
+ *
+ */
+void x_stats_record_wait(x_call_site *site, uint64_t start);
+
+/**
+ * Starts a span: the requests and round-trips until x_stats_end_render() or
+ * x_stats_end_event() are accounted to it.
+ *
+ */
+void x_stats_begin(x_stats_span *span);
+
+/**
+ * Ends a span which covered a tree_render().
+ *
+ */
+void x_stats_end_render(x_stats_span *span);
+
+/**
+ * Ends a span which covered handling an event of the given type.
+ *
+ */
+void x_stats_end_event(x_stats_span *span, int type);
+
+/**
+ * Generates the X11 statistics as a JSON map with the keys "renders",
+ * "events" and "call_sites".
+ *
+ */
+void x_stats_dump(json_writer *gen);
+
+/**
+ * Resets all X11 statistics.
+ *
+ */
+void x_stats_reset(void);
+
+#endif
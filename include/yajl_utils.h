@@ -14,16 +14,10 @@
 #include <yajl/yajl_parse.h>
 #include <yajl/yajl_version.h>
 
-/* Shorter names for all those yajl_gen_* functions */
-#define y(x, ...) yajl_gen_ ## x (gen, ##__VA_ARGS__)
-#define ystr(str) yajl_gen_string(gen, (unsigned char*)str, strlen(str))
-
 #if YAJL_MAJOR >= 2
-#define ygenalloc() yajl_gen_alloc(NULL)
 #define yalloc(callbacks, client) yajl_alloc(callbacks, NULL, client)
 typedef size_t ylength;
 #else
-#define ygenalloc() yajl_gen_alloc(NULL, NULL);
 #define yalloc(callbacks, client) yajl_alloc(callbacks, NULL, NULL, client)
 typedef unsigned int ylength;
 #endif
@@ -165,7 +165,7 @@ i3Font load_font(const char *pattern, const bool fallback) {
 
     /* Check for errors. If errors, fall back to default font. */
     xcb_generic_error_t *error;
-    error = xcb_request_check(conn, font_cookie);
+    error = X_WAIT(xcb_request_check, conn, font_cookie);
 
     /* If we fail to open font, fall back to 'fixed' */
     if (fallback && error != NULL) {
@@ -177,7 +177,7 @@ i3Font load_font(const char *pattern, const bool fallback) {
         info_cookie = xcb_query_font(conn, font.specific.xcb.id);
 
         /* Check if we managed to open 'fixed' */
-        error = xcb_request_check(conn, font_cookie);
+        error = X_WAIT(xcb_request_check, conn, font_cookie);
 
         /* Fall back to '-misc-*' if opening 'fixed' fails. */
         if (error != NULL) {
@@ -187,7 +187,7 @@ i3Font load_font(const char *pattern, const bool fallback) {
                     strlen(pattern), pattern);
             info_cookie = xcb_query_font(conn, font.specific.xcb.id);
 
-            if ((error = xcb_request_check(conn, font_cookie)) != NULL)
+            if ((error = X_WAIT(xcb_request_check, conn, font_cookie)) != NULL)
                 errx(EXIT_FAILURE, "Could open neither requested font nor fallbacks "
                      "(fixed or -misc-*): X11 error %d", error->error_code);
         }
@@ -197,7 +197,7 @@ i3Font load_font(const char *pattern, const bool fallback) {
     LOG("Using X font %s\n", pattern);
 
     /* Get information (height/name) for this font */
-    if (!(font.specific.xcb.info = xcb_query_font_reply(conn, info_cookie, NULL)))
+    if (!(font.specific.xcb.info = X_WAIT(xcb_query_font_reply, conn, info_cookie, NULL)))
         errx(EXIT_FAILURE, "Could not load font \"%s\"", pattern);
 
     /* Get the font table, if possible */
@@ -398,8 +398,8 @@ static int xcb_query_text_width(const xcb_char2b_t *text, size_t text_len) {
     xcb_generic_error_t *error;
     xcb_query_text_extents_cookie_t cookie = xcb_query_text_extents(conn,
             savedFont->specific.xcb.id, text_len, (xcb_char2b_t*)text);
-    xcb_query_text_extents_reply_t *reply = xcb_query_text_extents_reply(conn,
-            cookie, &error);
+    xcb_query_text_extents_reply_t *reply = X_WAIT(xcb_query_text_extents_reply,
+            conn, cookie, &error);
     if (reply == NULL) {
         /* We return a safe estimate because a rendering error is better than
          * a crash. Plus, the user will see the error in his log. */
@@ -30,7 +30,7 @@ uint32_t aio_get_mod_mask_for(uint32_t keysym, xcb_key_symbols_t *symbols) {
 
     /* Get the current modifier mapping (this is blocking!) */
     cookie = xcb_get_modifier_mapping(conn);
-    if (!(modmap_r = xcb_get_modifier_mapping_reply(conn, cookie, NULL)))
+    if (!(modmap_r = X_WAIT(xcb_get_modifier_mapping_reply, conn, cookie, NULL)))
         return 0;
 
     uint32_t result = get_mod_mask_for(keysym, symbols, modmap_r);
@@ -0,0 +1,157 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * intern.c: A global pool of interned (deduplicated, reference counted)
+ *           strings. Equal strings share one copy, so they can be compared
+ *           and hashed by pointer.
+ *
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "libi3.h"
+
+struct interned_string {
+    struct interned_string *next;
+    uint32_t hash;
+    uint32_t refcount;
+    size_t len;
+    char str[];
+};
+
+static struct interned_string **buckets = NULL;
+static size_t num_buckets = 0;
+static size_t num_entries = 0;
+
+/* FNV-1a */
+static uint32_t hash_string(const char *str, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+    return hash;
+}
+
+static struct interned_string *find_interned(const char *str, size_t len, uint32_t hash) {
+    if (num_buckets == 0)
+        return NULL;
+
+    struct interned_string *entry;
+    for (entry = buckets[hash & (num_buckets - 1)]; entry != NULL; entry = entry->next)
+        if (entry->hash == hash && entry->len == len && memcmp(entry->str, str, len) == 0)
+            return entry;
+    return NULL;
+}
+
+/*
+ * Doubles the number of buckets (which is always a power of two) and
+ * redistributes all entries.
+ *
+ */
+static void grow_buckets(void) {
+    size_t new_num = (num_buckets == 0 ? 64 : num_buckets * 2);
+    struct interned_string **new_buckets = scalloc(new_num * sizeof(struct interned_string *));
+
+    for (size_t c = 0; c < num_buckets; c++) {
+        struct interned_string *entry = buckets[c], *next;
+        for (; entry != NULL; entry = next) {
+            next = entry->next;
+            entry->next = new_buckets[entry->hash & (new_num - 1)];
+            new_buckets[entry->hash & (new_num - 1)] = entry;
+        }
+    }
+
+    free(buckets);
+    buckets = new_buckets;
+    num_buckets = new_num;
+}
+
+/*
+ * Returns the interned copy of the first len bytes of the given string (which
+ * does not need to be NUL-terminated). The returned string is NUL-terminated.
+ * Equal strings always yield the same pointer.
+ *
+ * Every call takes a reference, which has to be given back with
+ * release_interned_string().
+ *
+ */
+const char *intern_string_with_length(const char *str, size_t len) {
+    const uint32_t hash = hash_string(str, len);
+    struct interned_string *entry = find_interned(str, len, hash);
+    if (entry != NULL) {
+        entry->refcount++;
+        return entry->str;
+    }
+
+    if (num_entries >= (num_buckets / 4) * 3)
+        grow_buckets();
+
+    entry = smalloc(sizeof(struct interned_string) + len + 1);
+    memcpy(entry->str, str, len);
+    entry->str[len] = '\0';
+    entry->len = len;
+    entry->hash = hash;
+    entry->refcount = 1;
+    entry->next = buckets[hash & (num_buckets - 1)];
+    buckets[hash & (num_buckets - 1)] = entry;
+    num_entries++;
+    return entry->str;
+}
+
+/*
+ * Returns the interned copy of the given string, see
+ * intern_string_with_length().
+ *
+ */
+const char *intern_string(const char *str) {
+    return intern_string_with_length(str, strlen(str));
+}
+
+/*
+ * Returns the interned copy of the given string without taking a reference,
+ * or NULL if the string is not interned. Useful for lookups: if a string is
+ * not interned, no interned string can be equal to it.
+ *
+ */
+const char *lookup_interned_string(const char *str) {
+    const size_t len = strlen(str);
+    struct interned_string *entry = find_interned(str, len, hash_string(str, len));
+    return (entry == NULL ? NULL : entry->str);
+}
+
+/*
+ * Takes an additional reference to an already interned string and returns it.
+ *
+ */
+const char *ref_interned_string(const char *interned) {
+    if (interned == NULL)
+        return NULL;
+    struct interned_string *entry = (struct interned_string *)(interned - offsetof(struct interned_string, str));
+    entry->refcount++;
+    return interned;
+}
+
+/*
+ * Gives back a reference to an interned string. When the last reference is
+ * gone, the string is freed. Passing NULL is a no-op.
+ *
+ */
+void release_interned_string(const char *interned) {
+    if (interned == NULL)
+        return;
+
+    struct interned_string *entry = (struct interned_string *)(interned - offsetof(struct interned_string, str));
+    if (--(entry->refcount) > 0)
+        return;
+
+    struct interned_string **walk = &(buckets[entry->hash & (num_buckets - 1)]);
+    while (*walk != entry)
+        walk = &((*walk)->next);
+    *walk = entry->next;
+    num_entries--;
+    free(entry);
+}
@@ -0,0 +1,489 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * json_writer.c: A small append-only JSON writer. It is used instead of
+ *                yajl_gen where i3 generates a lot of JSON (the tree, IPC
+ *                events, command replies).
+ *
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#include "libi3.h"
+
+/* The state of one open map or array. */
+enum {
+    JW_MAP_FIRST_KEY,
+    JW_MAP_KEY,
+    JW_MAP_VALUE,
+    JW_ARRAY_FIRST,
+    JW_ARRAY
+};
+
+static void reserve(json_writer *writer, size_t len) {
+    /* One more byte for the terminating NUL byte, see json_writer_get_buf(). */
+    if (writer->len + len + 1 <= writer->size)
+        return;
+    size_t size = (writer->size == 0 ? 4096 : writer->size);
+    while (writer->len + len + 1 > size)
+        size *= 2;
+    writer->buf = srealloc(writer->buf, size);
+    writer->size = size;
+}
+
+static void append(json_writer *writer, const char *str, size_t len) {
+    reserve(writer, len);
+    memcpy(writer->buf + writer->len, str, len);
+    writer->len += len;
+}
+
+static void append_char(json_writer *writer, char c) {
+    reserve(writer, 1);
+    writer->buf[writer->len++] = c;
+}
+
+/*
+ * Inserts the separator (if any) which needs to precede the next token and
+ * updates the state of the innermost map/array.
+ *
+ */
+static void separate(json_writer *writer) {
+    if (writer->depth == 0)
+        return;
+
+    unsigned char *state = &(writer->stack[writer->depth - 1]);
+    switch (*state) {
+        case JW_MAP_FIRST_KEY:
+            *state = JW_MAP_VALUE;
+            break;
+        case JW_MAP_KEY:
+            append_char(writer, ',');
+            *state = JW_MAP_VALUE;
+            break;
+        case JW_MAP_VALUE:
+            append_char(writer, ':');
+            *state = JW_MAP_KEY;
+            break;
+        case JW_ARRAY_FIRST:
+            *state = JW_ARRAY;
+            break;
+        case JW_ARRAY:
+            append_char(writer, ',');
+            break;
+    }
+}
+
+static void open_container(json_writer *writer, char c, unsigned char state) {
+    separate(writer);
+    append_char(writer, c);
+    if (writer->depth == writer->stack_size) {
+        writer->stack_size = (writer->stack_size == 0 ? 32 : writer->stack_size * 2);
+        writer->stack = srealloc(writer->stack, writer->stack_size);
+    }
+    writer->stack[writer->depth++] = state;
+}
+
+/*
+ * Empties the writer, so that a new document can be generated. The buffer is
+ * kept, so a writer which is re-used does not allocate once it has grown to
+ * the size of the biggest document.
+ *
+ */
+void json_writer_reset(json_writer *writer) {
+    writer->len = 0;
+    writer->depth = 0;
+}
+
+/*
+ * Frees the buffers of the writer (but not the json_writer itself).
+ *
+ */
+void json_writer_free(json_writer *writer) {
+    free(writer->buf);
+    free(writer->stack);
+    memset(writer, 0, sizeof(json_writer));
+}
+
+/*
+ * Returns the generated JSON. The buffer is NUL-terminated (the terminating
+ * NUL byte is not included in len) and belongs to the writer.
+ *
+ */
+void json_writer_get_buf(json_writer *writer, const unsigned char **buf, size_t *len) {
+    reserve(writer, 0);
+    writer->buf[writer->len] = '\0';
+    *buf = (const unsigned char *)writer->buf;
+    *len = writer->len;
+}
+
+void json_writer_map_open(json_writer *writer) {
+    open_container(writer, '{', JW_MAP_FIRST_KEY);
+}
+
+void json_writer_map_close(json_writer *writer) {
+    writer->depth--;
+    append_char(writer, '}');
+}
+
+void json_writer_array_open(json_writer *writer) {
+    open_container(writer, '[', JW_ARRAY_FIRST);
+}
+
+void json_writer_array_close(json_writer *writer) {
+    writer->depth--;
+    append_char(writer, ']');
+}
+
+/*
+ * Appends the first len bytes of str as a JSON string (a key or a value,
+ * depending on the position inside a map), escaping it as necessary. The
+ * string is expected to be UTF-8 and is not validated.
+ *
+ */
+void json_writer_string_len(json_writer *writer, const char *str, size_t len) {
+    static const char hex[] = "0123456789ABCDEF";
+
+    separate(writer);
+    /* Worst case: every byte is escaped as \u00XX. */
+    reserve(writer, len * 6 + 2);
+
+    char *out = writer->buf + writer->len;
+    *out++ = '"';
+    const char *run = str;
+    for (const char *walk = str; walk < str + len; walk++) {
+        const unsigned char c = *walk;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+
+        /* Copy the run of characters which do not need to be escaped. */
+        memcpy(out, run, walk - run);
+        out += walk - run;
+        run = walk + 1;
+
+        *out++ = '\\';
+        switch (c) {
+            case '"':
+            case '\\':
+                *out++ = c;
+                break;
+            case '\n':
+                *out++ = 'n';
+                break;
+            case '\t':
+                *out++ = 't';
+                break;
+            case '\r':
+                *out++ = 'r';
+                break;
+            case '\b':
+                *out++ = 'b';
+                break;
+            case '\f':
+                *out++ = 'f';
+                break;
+            default:
+                *out++ = 'u';
+                *out++ = '0';
+                *out++ = '0';
+                *out++ = hex[c >> 4];
+                *out++ = hex[c & 0xf];
+                break;
+        }
+    }
+    memcpy(out, run, (str + len) - run);
+    out += (str + len) - run;
+    *out++ = '"';
+    writer->len = out - writer->buf;
+}
+
+void json_writer_string(json_writer *writer, const char *str) {
+    json_writer_string_len(writer, str, strlen(str));
+}
+
+/*
+ * Appends a map key which is already quoted and escaped, see json_writer_key().
+ *
+ */
+void json_writer_key_literal(json_writer *writer, const char *quoted, size_t len) {
+    separate(writer);
+    append(writer, quoted, len);
+}
+
+/*
+ * Appends an already generated JSON value (e.g. the output of another
+ * json_writer) as the next value.
+ *
+ */
+void json_writer_raw(json_writer *writer, const char *json, size_t len) {
+    separate(writer);
+    append(writer, json, len);
+}
+
+void json_writer_integer(json_writer *writer, long long number) {
+    char digits[24];
+    char *walk = digits + sizeof(digits);
+    /* Negating LLONG_MIN overflows, so we convert to unsigned first. */
+    unsigned long long value = (number < 0 ? -(unsigned long long)number : (unsigned long long)number);
+
+    do {
+        *--walk = '0' + (value % 10);
+        value /= 10;
+    } while (value > 0);
+    if (number < 0)
+        *--walk = '-';
+
+    separate(writer);
+    append(writer, walk, digits + sizeof(digits) - walk);
+}
+
+/*
+ * Appends a floating point number, formatted like yajl 2 does ("%.20g"). The
+ * output does not depend on the locale (unlike yajl_gen_double(), which needs
+ * LC_NUMERIC to be "C"). Numbers without a fractional part get a ".0", so that
+ * they are still parsed as floating point numbers. NaN and infinity cannot be
+ * represented in JSON, they are written as null.
+ *
+ */
+void json_writer_double(json_writer *writer, double number) {
+    if (!isfinite(number)) {
+        json_writer_null(writer);
+        return;
+    }
+
+    char formatted[32];
+    int len = snprintf(formatted, sizeof(formatted), "%.20g", number);
+    bool integral = true;
+    for (int c = 0; c < len; c++) {
+        /* Some locales use a comma as decimal separator. */
+        if (formatted[c] == ',')
+            formatted[c] = '.';
+        if (formatted[c] == '.' || formatted[c] == 'e')
+            integral = false;
+    }
+    if (integral) {
+        formatted[len++] = '.';
+        formatted[len++] = '0';
+    }
+
+    separate(writer);
+    append(writer, formatted, len);
+}
+
+void json_writer_bool(json_writer *writer, bool value) {
+    separate(writer);
+    if (value)
+        append(writer, "true", strlen("true"));
+    else append(writer, "false", strlen("false"));
+}
+
+void json_writer_null(json_writer *writer) {
+    separate(writer);
+    append(writer, "null", strlen("null"));
+}
+
+/*******************************************************************************
+ * Code for building the stand-alone binary test.json_writer, which verifies
+ * that the writer generates the same JSON as yajl_gen and compares their
+ * throughput when dumping a (synthetic) layout tree like GET_TREE does.
+ ******************************************************************************/
+
+#ifdef TEST_JSON_WRITER
+
+#include <time.h>
+#include <yajl/yajl_gen.h>
+#include <yajl/yajl_version.h>
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/* The tree is described by its branching factor per level. Each container
+ * gets 1/n of its parent, so the percent values include 1.0, 1/3 and 1/6. */
+static const int branching[] = { 2, 3, 4, 6 };
+#define LEVELS (int)(sizeof(branching) / sizeof(branching[0]))
+
+static const char *rect_keys[] = { "rect", "window_rect", "geometry" };
+
+/* Note that the names must not contain a '/': yajl 1 escapes it as "\/"
+ * (yajl 2 and the JSON writer do not), so the output would differ. */
+
+#define y(x, ...) yajl_gen_ ## x (gen, ##__VA_ARGS__)
+#define ystr(str) yajl_gen_string(gen, (unsigned char*)str, strlen(str))
+
+/* Same document as dump_with_writer(), generated with yajl_gen. */
+static void dump_with_yajl(yajl_gen gen, int level, long long *id) {
+    y(map_open);
+    ystr("id");
+    y(integer, (*id)++);
+    ystr("type");
+    y(integer, level);
+    ystr("orientation");
+    ystr("horizontal");
+    ystr("percent");
+    y(double, (level > 0 ? 1.0 / branching[level - 1] : 1.0));
+    ystr("urgent");
+    y(bool, false);
+    ystr("focused");
+    y(bool, true);
+    ystr("layout");
+    ystr("splith");
+    ystr("border");
+    ystr("normal");
+    for (int c = 0; c < 3; c++) {
+        ystr(rect_keys[c]);
+        y(map_open);
+        ystr("x");
+        y(integer, 1280);
+        ystr("y");
+        y(integer, 18);
+        ystr("width");
+        y(integer, 640);
+        ystr("height");
+        y(integer, 782);
+        y(map_close);
+    }
+    ystr("name");
+    ystr("urxvt: ~ i3 \"tree\"\tdump");
+    ystr("window");
+    y(null);
+    ystr("nodes");
+    y(array_open);
+    if (level < LEVELS)
+        for (int c = 0; c < branching[level]; c++)
+            dump_with_yajl(gen, level + 1, id);
+    y(array_close);
+    ystr("focus");
+    y(array_open);
+    y(array_close);
+    y(map_close);
+}
+
+#undef y
+#undef ystr
+#define y(x, ...) json_writer_ ## x (writer, ##__VA_ARGS__)
+#define ystr(str) json_writer_string(writer, str)
+#define ykey(key) json_writer_key(writer, key)
+
+static void dump_with_writer(json_writer *writer, int level, long long *id) {
+    y(map_open);
+    ykey("id");
+    y(integer, (*id)++);
+    ykey("type");
+    y(integer, level);
+    ykey("orientation");
+    ystr("horizontal");
+    ykey("percent");
+    y(double, (level > 0 ? 1.0 / branching[level - 1] : 1.0));
+    ykey("urgent");
+    y(bool, false);
+    ykey("focused");
+    y(bool, true);
+    ykey("layout");
+    ystr("splith");
+    ykey("border");
+    ystr("normal");
+    for (int c = 0; c < 3; c++) {
+        ystr(rect_keys[c]);
+        y(map_open);
+        ykey("x");
+        y(integer, 1280);
+        ykey("y");
+        y(integer, 18);
+        ykey("width");
+        y(integer, 640);
+        ykey("height");
+        y(integer, 782);
+        y(map_close);
+    }
+    ykey("name");
+    ystr("urxvt: ~ i3 \"tree\"\tdump");
+    ykey("window");
+    y(null);
+    ykey("nodes");
+    y(array_open);
+    if (level < LEVELS)
+        for (int c = 0; c < branching[level]; c++)
+            dump_with_writer(writer, level + 1, id);
+    y(array_close);
+    ykey("focus");
+    y(array_open);
+    y(array_close);
+    y(map_close);
+}
+
+/*
+ * Syntax: test.json_writer [iterations]
+ *
+ * Generates the same tree with yajl_gen and with the JSON writer, exits with
+ * 1 if the output differs, and prints how many trees per second each of them
+ * generates.
+ *
+ */
+int main(int argc, char *argv[]) {
+    const long iterations = (argc > 1 ? atol(argv[1]) : 1000);
+    long long id;
+    const unsigned char *expected, *got;
+#if YAJL_MAJOR >= 2
+    size_t expected_len;
+#else
+    unsigned int expected_len;
+#endif
+    size_t got_len;
+
+    double start = now();
+    for (long i = 0; i < iterations; i++) {
+#if YAJL_MAJOR >= 2
+        yajl_gen gen = yajl_gen_alloc(NULL);
+#else
+        yajl_gen gen = yajl_gen_alloc(NULL, NULL);
+#endif
+        id = 1;
+        dump_with_yajl(gen, 0, &id);
+        yajl_gen_get_buf(gen, &expected, &expected_len);
+        yajl_gen_free(gen);
+    }
+    const double yajl_duration = now() - start;
+
+    json_writer writer = { 0 };
+    start = now();
+    for (long i = 0; i < iterations; i++) {
+        json_writer_reset(&writer);
+        id = 1;
+        dump_with_writer(&writer, 0, &id);
+        json_writer_get_buf(&writer, &got, &got_len);
+    }
+    const double writer_duration = now() - start;
+
+#if YAJL_MAJOR >= 2
+    yajl_gen gen = yajl_gen_alloc(NULL);
+#else
+    yajl_gen gen = yajl_gen_alloc(NULL, NULL);
+#endif
+    id = 1;
+    dump_with_yajl(gen, 0, &id);
+    yajl_gen_get_buf(gen, &expected, &expected_len);
+
+    int result = 0;
+    if (expected_len != got_len || memcmp(expected, got, got_len) != 0) {
+        fprintf(stderr, "MISMATCH:\nyajl:   %.*s\nwriter: %.*s\n",
+                (int)expected_len, expected, (int)got_len, got);
+        result = 1;
+    }
+
+    printf("%ld trees of %lld containers (%zu bytes)\n", iterations, id - 1, got_len);
+    printf("yajl_gen:    %.0f trees/s\n", iterations / yajl_duration);
+    printf("json_writer: %.0f trees/s\n", iterations / writer_duration);
+
+    yajl_gen_free(gen);
+    json_writer_free(&writer);
+    return result;
+}
+#endif
@@ -0,0 +1,95 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * latency.c: Histograms of how long the hot paths of i3 and i3bar take. They
+ *            are always enabled, so recording needs to be cheap: two clock
+ *            reads (no syscall, clock_gettime() is handled in the vDSO) and a
+ *            few additions.
+ *
+ */
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "libi3.h"
+
+/* See X_WAIT(), set by i3 to account X11 round-trips. */
+void (*x_wait_hook)(x_call_site *site, uint64_t start) = NULL;
+
+/*
+ * Returns the current time in nanoseconds (from a monotonic clock, only
+ * useful for latency_record()).
+ *
+ */
+uint64_t latency_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * Records the time since start (a return value of latency_now()).
+ *
+ */
+void latency_record(latency_histogram *histogram, uint64_t start) {
+    const uint64_t ns = latency_now() - start;
+    const uint64_t us = ns / 1000;
+
+    /* Bucket i counts durations of at least 2^(i-1) µs, i.e. i is the number
+     * of significant bits of the duration in µs. */
+    int bucket = (us == 0 ? 0 : 64 - __builtin_clzll(us));
+    if (bucket >= LATENCY_BUCKETS)
+        bucket = LATENCY_BUCKETS - 1;
+
+    histogram->count++;
+    histogram->total_ns += ns;
+    if (ns > histogram->max_ns)
+        histogram->max_ns = ns;
+    histogram->buckets[bucket]++;
+}
+
+/*
+ * Empties the histogram.
+ *
+ */
+void latency_reset(latency_histogram *histogram) {
+    const char *name = histogram->name;
+    memset(histogram, 0, sizeof(latency_histogram));
+    histogram->name = name;
+}
+
+/*
+ * Generates a JSON map with the name, count, total_us, max_us and buckets of
+ * the histogram. If name is not NULL, it is used instead of histogram->name.
+ *
+ */
+void latency_dump(json_writer *writer, const latency_histogram *histogram, const char *name) {
+    json_writer_map_open(writer);
+
+    json_writer_key(writer, "name");
+    json_writer_string(writer, (name != NULL ? name : histogram->name));
+
+    json_writer_key(writer, "count");
+    json_writer_integer(writer, histogram->count);
+
+    json_writer_key(writer, "total_us");
+    json_writer_integer(writer, histogram->total_ns / 1000);
+
+    json_writer_key(writer, "max_us");
+    json_writer_integer(writer, histogram->max_ns / 1000);
+
+    /* Trailing empty buckets are left out. */
+    int used = LATENCY_BUCKETS;
+    while (used > 0 && histogram->buckets[used - 1] == 0)
+        used--;
+    json_writer_key(writer, "buckets");
+    json_writer_array_open(writer);
+    for (int i = 0; i < used; i++)
+        json_writer_integer(writer, histogram->buckets[i]);
+    json_writer_array_close(writer);
+
+    json_writer_map_close(writer);
+}
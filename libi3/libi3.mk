@@ -12,10 +12,19 @@ libi3/%.o: libi3/%.c $(libi3_HEADERS)
 	echo "[libi3] CC $<"
 	$(CC) $(I3_CPPFLAGS) $(XCB_CPPFLAGS) $(CPPFLAGS) $(libi3_CFLAGS) $(I3_CFLAGS) $(CFLAGS) -c -o $@ $<
 
+# This target compiles the JSON writer twice:
+# Once with -DTEST_JSON_WRITER, creating a stand-alone executable which
+# compares its output with yajl_gen (used for tests and benchmarks), and once
+# as an object file for libi3.
+libi3/json_writer.o: libi3/json_writer.c $(libi3_HEADERS)
+	echo "[libi3] CC $<"
+	$(CC) $(I3_CPPFLAGS) $(XCB_CPPFLAGS) $(CPPFLAGS) $(libi3_CFLAGS) $(YAJL_CFLAGS) $(I3_CFLAGS) $(CFLAGS) $(I3_LDFLAGS) $(LDFLAGS) -DTEST_JSON_WRITER -g -o test.json_writer $< libi3/safewrappers.c $(YAJL_LIBS) -lm
+	$(CC) $(I3_CPPFLAGS) $(XCB_CPPFLAGS) $(CPPFLAGS) $(libi3_CFLAGS) $(I3_CFLAGS) $(CFLAGS) -c -o $@ $<
+
 libi3.a: $(libi3_OBJECTS)
 	echo "[libi3] AR libi3.a"
 	$(AR) rcs $@ $^ $(libi3_LIBS)
 
 clean-libi3:
 	echo "[libi3] Clean"
-	rm -f $(libi3_OBJECTS) libi3/libi3.a libi3.a
+	rm -f $(libi3_OBJECTS) libi3/libi3.a libi3.a test.json_writer
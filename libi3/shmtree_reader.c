@@ -0,0 +1,145 @@
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * shmtree_reader.c: Reads the tree snapshot which i3 publishes in shared
+ *                   memory, see include/shmtree.h.
+ *
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "libi3.h"
+#include "shmtree.h"
+
+/* How often the snapshot is copied before giving up because i3 modifies it
+ * all the time (which should never happen in practice). */
+#define MAX_TRIES 1000
+
+/*
+ * (Re-)Maps the whole segment. Returns false if it cannot be mapped.
+ *
+ */
+static bool map_segment(shmtree_reader *reader, size_t size) {
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (mapping == MAP_FAILED)
+        return false;
+
+    if (reader->mapping != NULL)
+        munmap(reader->mapping, reader->mapping_size);
+    reader->mapping = mapping;
+    reader->mapping_size = size;
+    return true;
+}
+
+/*
+ * Opens the SHM segment with the given name (the contents of the
+ * I3_SHMTREE_PATH atom) read-only. Returns false if it cannot be opened.
+ *
+ */
+bool shmtree_open(shmtree_reader *reader, const char *name) {
+    memset(reader, 0, sizeof(shmtree_reader));
+    if ((reader->fd = shm_open(name, O_RDONLY, 0)) == -1)
+        return false;
+
+    struct stat statbuf;
+    if (fstat(reader->fd, &statbuf) != 0 ||
+        (size_t)statbuf.st_size < sizeof(i3_shmtree_header) ||
+        !map_segment(reader, statbuf.st_size)) {
+        close(reader->fd);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Returns true if i3 published a new snapshot since the last shmtree_read()
+ * (without copying anything).
+ *
+ */
+bool shmtree_changed(shmtree_reader *reader) {
+    const volatile i3_shmtree_header *shared = reader->mapping;
+    return (shared->sequence != reader->sequence);
+}
+
+/*
+ * Copies a consistent snapshot out of the segment and returns it (use
+ * I3_SHMTREE_NODES() and I3_SHMTREE_NAME() to access it). The snapshot
+ * belongs to the reader and is valid until the next call. Returns NULL if i3
+ * did not publish a (compatible) snapshot.
+ *
+ * No syscalls are made unless the segment grew, or i3 is writing a snapshot
+ * at the same time.
+ *
+ */
+const struct i3_shmtree_header *shmtree_read(shmtree_reader *reader) {
+    for (int tries = 0; tries < MAX_TRIES; tries++) {
+        const volatile i3_shmtree_header *shared = reader->mapping;
+        if (shared->magic != I3_SHMTREE_MAGIC || shared->version != I3_SHMTREE_VERSION)
+            return NULL;
+
+        const uint32_t sequence = shared->sequence;
+        if (sequence & 1) {
+            /* i3 is writing right now. It might have been scheduled away in
+             * the middle of it, so let it continue instead of spinning. */
+            sched_yield();
+            continue;
+        }
+        __sync_synchronize();
+
+        const size_t segment_size = shared->size;
+        if (segment_size > reader->mapping_size) {
+            if (!map_segment(reader, segment_size))
+                return NULL;
+            continue;
+        }
+
+        /* The size might be garbage if i3 started writing in the meantime,
+         * the sequence check below catches that. */
+        const size_t size = sizeof(i3_shmtree_header) + shared->data_size;
+        if (size > reader->mapping_size)
+            continue;
+
+        if (size > reader->snapshot_size) {
+            reader->snapshot = srealloc(reader->snapshot, size);
+            reader->snapshot_size = size;
+        }
+        memcpy(reader->snapshot, reader->mapping, size);
+
+        __sync_synchronize();
+        if (shared->sequence != sequence)
+            continue;
+
+        i3_shmtree_header *snapshot = reader->snapshot;
+        if ((size_t)snapshot->num_nodes * sizeof(i3_shmtree_node) > snapshot->data_size)
+            return NULL;
+        snapshot->sequence = sequence;
+        reader->sequence = sequence;
+        return snapshot;
+    }
+
+    return NULL;
+}
+
+/*
+ * Unmaps the segment and frees the snapshot.
+ *
+ */
+void shmtree_close(shmtree_reader *reader) {
+    if (reader->mapping != NULL) {
+        munmap(reader->mapping, reader->mapping_size);
+        close(reader->fd);
+    }
+    free(reader->snapshot);
+    memset(reader, 0, sizeof(shmtree_reader));
+}
@@ -39,6 +39,7 @@ state INITIAL:
   'force_display_urgency_hint'             -> FORCE_DISPLAY_URGENCY_HINT
   'workspace'                              -> WORKSPACE
   'ipc_socket', 'ipc-socket'               -> IPC_SOCKET
+  'restart_state_format'                   -> RESTART_STATE_FORMAT
   'restart_state'                          -> RESTART_STATE
   'popup_during_fullscreen'                -> POPUP_DURING_FULLSCREEN
   exectype = 'exec_always', 'exec'         -> EXEC
@@ -227,6 +228,11 @@ state RESTART_STATE:
   path = string
       -> call cfg_restart_state($path)
 
+# restart_state_format json|binary
+state RESTART_STATE_FORMAT:
+  format = 'json', 'binary'
+      -> call cfg_restart_state_format($format)
+
 # popup_during_fullscreen
 state POPUP_DURING_FULLSCREEN:
   value = 'ignore', 'leave_fullscreen', 'smart'
@@ -347,6 +353,7 @@ state BAR:
   'set' -> BAR_IGNORE_LINE
   'i3bar_command'     -> BAR_BAR_COMMAND
   'status_command'    -> BAR_STATUS_COMMAND
+  'status_interval'   -> BAR_STATUS_INTERVAL
   'socket_path'       -> BAR_SOCKET_PATH
   'mode'              -> BAR_MODE
   'modifier'          -> BAR_MODIFIER
@@ -373,6 +380,17 @@ state BAR_STATUS_COMMAND:
   command = string
       -> call cfg_bar_status_command($command); BAR
 
+# status_interval <interval> ms
+state BAR_STATUS_INTERVAL:
+  interval_ms = number
+      -> BAR_STATUS_INTERVAL_MS
+
+state BAR_STATUS_INTERVAL_MS:
+  'ms'
+      ->
+  end
+      -> call cfg_bar_status_interval(&interval_ms); BAR
+
 state BAR_SOCKET_PATH:
   path = string
       -> call cfg_bar_socket_path($path); BAR
@@ -50,8 +50,6 @@ void run_assignments(i3Window *window) {
 
             if (command_output->needs_tree_render)
                 needs_tree_render = true;
-
-            yajl_gen_free(command_output->json_gen);
         }
 
         /* Store that we ran this assignment to not execute it again */
@@ -15,8 +15,8 @@
 #include "all.h"
 
 // Macros to make the YAJL API a bit easier to use.
-#define y(x, ...) yajl_gen_ ## x (cmd_output->json_gen, ##__VA_ARGS__)
-#define ystr(str) yajl_gen_string(cmd_output->json_gen, (unsigned char*)str, strlen(str))
+#define y(x, ...) json_writer_ ## x (cmd_output->json_gen, ##__VA_ARGS__)
+#define ystr(str) json_writer_string(cmd_output->json_gen, str)
 #define ysuccess(success) do { \
     y(map_open); \
     ystr("success"); \
@@ -78,7 +78,9 @@ static Output *get_output_from_string(Output *current_output, const char *output
 static bool maybe_back_and_forth(struct CommandResult *cmd_output, char *name) {
     Con *ws = con_get_workspace(focused);
 
-    /* If we switched to a different workspace, do nothing */
+    /* If we switched to a different workspace, do nothing. The names are
+     * compared exactly (not by name_key): switching to the focused workspace
+     * with a differently cased name is not a back and forth. */
     if (strcmp(ws->name, name) != 0)
         return false;
 
@@ -525,7 +527,7 @@ void cmd_move_con_to_workspace_number(I3_CMD, char *which) {
 
     LOG("should move window to workspace %s\n", which);
     /* get the workspace */
-    Con *output, *workspace = NULL;
+    Con *workspace = NULL;
 
     char *endptr = NULL;
     long parsed_num = strtol(which, &endptr, 10);
@@ -544,9 +546,7 @@ void cmd_move_con_to_workspace_number(I3_CMD, char *which) {
         return;
     }
 
-    TAILQ_FOREACH(output, &(croot->nodes_head), nodes)
-        GREP_FIRST(workspace, output_get_content(output),
-            child->num == parsed_num);
+    workspace = workspace_by_number(parsed_num);
 
     if (!workspace) {
         workspace = workspace_get(which, NULL);
@@ -912,7 +912,7 @@ void cmd_workspace(I3_CMD, char *which) {
  *
  */
 void cmd_workspace_number(I3_CMD, char *which) {
-    Con *output, *workspace = NULL;
+    Con *workspace = NULL;
 
     char *endptr = NULL;
     long parsed_num = strtol(which, &endptr, 10);
@@ -932,9 +932,7 @@ void cmd_workspace_number(I3_CMD, char *which) {
         return;
     }
 
-    TAILQ_FOREACH(output, &(croot->nodes_head), nodes)
-        GREP_FIRST(workspace, output_get_content(output),
-            child->num == parsed_num);
+    workspace = workspace_by_number(parsed_num);
 
     if (!workspace) {
         LOG("There is no workspace with number %ld, creating a new one.\n", parsed_num);
@@ -1159,11 +1157,7 @@ void cmd_move_workspace_to_output(I3_CMD, char *name) {
                     continue;
 
                 /* check if this workspace is already attached to the tree */
-                Con *workspace = NULL, *out;
-                TAILQ_FOREACH(out, &(croot->nodes_head), nodes)
-                    GREP_FIRST(workspace, output_get_content(out),
-                               !strcasecmp(child->name, assignment->name));
-                if (workspace != NULL)
+                if (workspace_by_name(assignment->name) != NULL)
                     continue;
 
                 /* so create the workspace referenced to by this assignment */
@@ -1832,11 +1826,9 @@ void cmd_rename_workspace(I3_CMD, char *old_name, char *new_name) {
         LOG("Renaming current workspace to \"%s\"\n", new_name);
     }
 
-    Con *output, *workspace = NULL;
+    Con *workspace = NULL;
     if (old_name) {
-        TAILQ_FOREACH(output, &(croot->nodes_head), nodes)
-            GREP_FIRST(workspace, output_get_content(output),
-                !strcasecmp(child->name, old_name));
+        workspace = workspace_by_name(old_name);
     } else {
         workspace = con_get_workspace(focused);
     }
@@ -1854,12 +1846,7 @@ void cmd_rename_workspace(I3_CMD, char *old_name, char *new_name) {
         return;
     }
 
-    Con *check_dest = NULL;
-    TAILQ_FOREACH(output, &(croot->nodes_head), nodes)
-        GREP_FIRST(check_dest, output_get_content(output),
-            !strcasecmp(child->name, new_name));
-
-    if (check_dest != NULL) {
+    if (workspace_by_name(new_name) != NULL) {
         // TODO: we should include the new workspace name here and use yajl for
         // generating the reply.
         y(map_open);
@@ -1872,6 +1859,13 @@ void cmd_rename_workspace(I3_CMD, char *old_name, char *new_name) {
         return;
     }
 
+    /* Detach first, so that the workspace index is updated with the new name
+     * and number when re-attaching. By re-attaching, the sort order will be
+     * correct afterwards. */
+    Con *previously_focused = focused;
+    Con *parent = workspace->parent;
+    con_detach(workspace);
+
     /* Change the name and try to parse it as a number. */
     FREE(workspace->name);
     workspace->name = sstrdup(new_name);
@@ -1885,10 +1879,6 @@ void cmd_rename_workspace(I3_CMD, char *old_name, char *new_name) {
     else workspace->num = parsed_num;
     LOG("num = %d\n", workspace->num);
 
-    /* By re-attaching, the sort order will be correct afterwards. */
-    Con *previously_focused = focused;
-    Con *parent = workspace->parent;
-    con_detach(workspace);
     con_attach(workspace, parent, false);
     /* Restore the previous focus since con_attach messes with the focus. */
     con_focus(previously_focused);
@@ -37,7 +37,7 @@ static void con_force_split_parents_redraw(Con *con) {
 
     while (parent && parent->type != CT_WORKSPACE && parent->type != CT_DOCKAREA) {
         if (!con_is_leaf(parent))
-            FREE(parent->deco_render_params);
+            POOL_FREE(&deco_render_params_pool, parent->deco_render_params);
         parent = parent->parent;
     }
 }
@@ -48,7 +48,7 @@ static void con_force_split_parents_redraw(Con *con) {
  *
  */
 Con *con_new_skeleton(Con *parent, i3Window *window) {
-    Con *new = scalloc(sizeof(Con));
+    Con *new = pool_alloc(&con_pool);
     new->on_remove_child = con_on_remove_child;
     TAILQ_INSERT_TAIL(&all_cons, new, all_cons);
     new->type = CT_CON;
@@ -111,6 +111,12 @@ void con_attach(Con *con, Con *parent, bool ignore_focus) {
      * right position. */
     if (con->type == CT_WORKSPACE) {
         DLOG("it's a workspace. num = %d\n", con->num);
+        /* Every workspace is attached after its name was set or changed, so
+         * this is where we keep the lookup key up to date. */
+        const char *old_key = con->name_key;
+        con->name_key = workspace_name_key(con->name, true);
+        release_interned_string(old_key);
+        workspace_index_add(con);
         if (con->num == -1 || TAILQ_EMPTY(nodes_head)) {
             TAILQ_INSERT_TAIL(nodes_head, con, nodes);
         } else {
@@ -186,6 +192,8 @@ add_to_focus_head:
      * to focus them. */
     TAILQ_INSERT_TAIL(focus_head, con, focused);
     con_force_split_parents_redraw(con);
+    con_invalidate_fullscreen_con(con);
+    con_aggregates_attach(con);
 }
 
 /*
@@ -194,6 +202,10 @@ add_to_focus_head:
  */
 void con_detach(Con *con) {
     con_force_split_parents_redraw(con);
+    con_invalidate_fullscreen_con(con);
+    con_aggregates_detach(con);
+    if (con->type == CT_WORKSPACE)
+        workspace_index_remove(con);
     if (con->type == CT_FLOATING_CON) {
         TAILQ_REMOVE(&(con->parent->floating_head), con, floating_windows);
         TAILQ_REMOVE(&(con->parent->focus_head), con, focused);
@@ -203,6 +215,105 @@ void con_detach(Con *con) {
     }
 }
 
+/*
+ * Adds the aggregates (see num_children and urgent_windows in struct Con) of
+ * the given container to its parent and all further ancestors. Called by
+ * con_attach() and needs to be called by all code which links a container
+ * into its parent’s nodes_head or floating_head by hand.
+ *
+ */
+void con_aggregates_attach(Con *con) {
+    if (con->type != CT_FLOATING_CON)
+        con->parent->num_children++;
+    for (Con *parent = con->parent; parent != NULL; parent = parent->parent)
+        parent->urgent_windows += con->urgent_windows;
+}
+
+/*
+ * Removes the aggregates of the given container from its ancestors. Called by
+ * con_detach(), needs to be called before unlinking a container by hand.
+ *
+ */
+void con_aggregates_detach(Con *con) {
+    if (con->type != CT_FLOATING_CON)
+        con->parent->num_children--;
+    for (Con *parent = con->parent; parent != NULL; parent = parent->parent)
+        parent->urgent_windows -= con->urgent_windows;
+}
+
+/*
+ * Adds delta to the urgent_windows count of the given container and all of
+ * its ancestors.
+ *
+ */
+static void con_add_urgent_windows(Con *con, int delta) {
+    for (; con != NULL; con = con->parent)
+        con->urgent_windows += delta;
+}
+
+/*
+ * Sets the urgent flag of the given container and keeps the urgent_windows
+ * counts of the container and its ancestors up to date. The urgent flags of
+ * the parents are not touched, see con_update_parents_urgency().
+ *
+ */
+void con_set_urgent_flag(Con *con, bool urgent) {
+    if (con->urgent == urgent)
+        return;
+    con->urgent = urgent;
+    /* Only the urgency of windows is counted. Split containers inherit it
+     * from their children. */
+    if (con->window != NULL)
+        con_add_urgent_windows(con, (urgent ? 1 : -1));
+}
+
+/*
+ * Sets the window of the given container (or takes it away when window is
+ * NULL), keeping the urgent_windows counts up to date.
+ *
+ */
+void con_set_window(Con *con, i3Window *window) {
+    if (con->urgent && (con->window != NULL) != (window != NULL))
+        con_add_urgent_windows(con, (window != NULL ? 1 : -1));
+    con->window = window;
+}
+
+#ifdef DEBUG_AGGREGATES
+/*
+ * Recomputes the aggregates of every container below (and including) the
+ * given one and aborts on the first mismatch.
+ *
+ */
+void con_verify_aggregates(Con *con) {
+    Con *child;
+    int num_children = 0;
+    int urgent_windows = (con->window != NULL && con->urgent ? 1 : 0);
+
+    TAILQ_FOREACH(child, &(con->nodes_head), nodes) {
+        con_verify_aggregates(child);
+        num_children++;
+        urgent_windows += child->urgent_windows;
+    }
+
+    TAILQ_FOREACH(child, &(con->floating_head), floating_windows) {
+        con_verify_aggregates(child);
+        urgent_windows += child->urgent_windows;
+    }
+
+    if (con->num_children != num_children) {
+        ELOG("BUG: con %p (%s) has num_children = %d, but %d children\n",
+             con, con->name, con->num_children, num_children);
+        assert(false);
+    }
+
+    if (con->urgent_windows != urgent_windows) {
+        ELOG("BUG: con %p (%s) has urgent_windows = %d, but %d urgent windows\n",
+             con, con->name, con->urgent_windows, urgent_windows);
+        assert(false);
+    }
+}
+#endif
+
 /*
  * Sets input focus to the given container. Will be updated in X11 in the next
  * run of x_push_changes().
@@ -226,7 +337,7 @@ void con_focus(Con *con) {
      * checks before resetting the urgency.
      */
     if (con->urgent && con_is_leaf(con)) {
-        con->urgent = false;
+        con_set_urgent_flag(con, false);
         con_update_parents_urgency(con);
         workspace_update_urgent_flag(con_get_workspace(con));
     }
@@ -338,62 +449,93 @@ Con *con_parent_with_orientation(Con *con, orientation_t orientation) {
 }
 
 /*
- * helper data structure for the breadth-first-search in
- * con_get_fullscreen_con()
+ * Returns true if 'con' is a (direct or indirect) child of 'ancestor'.
  *
  */
-struct bfs_entry {
-    Con *con;
-
-    TAILQ_ENTRY(bfs_entry) entries;
-};
+static bool con_is_below(Con *con, Con *ancestor) {
+    for (con = con->parent; con != NULL; con = con->parent)
+        if (con == ancestor)
+            return true;
+    return false;
+}
 
 /*
- * Returns the first fullscreen node below this node.
+ * The breadth-first-search of con_get_fullscreen_con(). The queue is kept
+ * around between calls, so that searching does not allocate.
  *
  */
-Con *con_get_fullscreen_con(Con *con, int fullscreen_mode) {
+static Con *con_find_fullscreen_con(Con *con, int fullscreen_mode) {
+    static Con **queue = NULL;
+    static size_t queue_size = 0;
+    size_t head = 0, tail = 0;
     Con *current, *child;
 
     /* TODO: is breadth-first-search really appropriate? (check as soon as
      * fullscreen levels and fullscreen for containers is implemented) */
-    TAILQ_HEAD(bfs_head, bfs_entry) bfs_head = TAILQ_HEAD_INITIALIZER(bfs_head);
-    struct bfs_entry *entry = smalloc(sizeof(struct bfs_entry));
-    entry->con = con;
-    TAILQ_INSERT_TAIL(&bfs_head, entry, entries);
-
-    while (!TAILQ_EMPTY(&bfs_head)) {
-        entry = TAILQ_FIRST(&bfs_head);
-        current = entry->con;
-        if (current != con && current->fullscreen_mode == fullscreen_mode) {
-            /* empty the queue */
-            while (!TAILQ_EMPTY(&bfs_head)) {
-                entry = TAILQ_FIRST(&bfs_head);
-                TAILQ_REMOVE(&bfs_head, entry, entries);
-                free(entry);
-            }
+#define ENQUEUE(c) do { \
+    if (tail == queue_size) { \
+        queue_size = (queue_size == 0 ? 64 : queue_size * 2); \
+        queue = srealloc(queue, queue_size * sizeof(Con*)); \
+    } \
+    queue[tail++] = (c); \
+} while (0)
+
+    ENQUEUE(con);
+    while (head < tail) {
+        current = queue[head++];
+        if (current != con && current->fullscreen_mode == fullscreen_mode)
             return current;
-        }
-
-        TAILQ_REMOVE(&bfs_head, entry, entries);
-        free(entry);
 
-        TAILQ_FOREACH(child, &(current->nodes_head), nodes) {
-            entry = smalloc(sizeof(struct bfs_entry));
-            entry->con = child;
-            TAILQ_INSERT_TAIL(&bfs_head, entry, entries);
-        }
+        TAILQ_FOREACH(child, &(current->nodes_head), nodes)
+            ENQUEUE(child);
 
-        TAILQ_FOREACH(child, &(current->floating_head), floating_windows) {
-            entry = smalloc(sizeof(struct bfs_entry));
-            entry->con = child;
-            TAILQ_INSERT_TAIL(&bfs_head, entry, entries);
-        }
+        TAILQ_FOREACH(child, &(current->floating_head), floating_windows)
+            ENQUEUE(child);
     }
+#undef ENQUEUE
 
     return NULL;
 }
 
+/*
+ * Returns the first fullscreen node below this node.
+ *
+ * The result is cached for workspaces (with CF_OUTPUT) and the root container
+ * (with CF_GLOBAL), which is what rendering asks for.
+ *
+ */
+Con *con_get_fullscreen_con(Con *con, int fullscreen_mode) {
+    const bool cached = ((con->type == CT_WORKSPACE && fullscreen_mode == CF_OUTPUT) ||
+                         (con->type == CT_ROOT && fullscreen_mode == CF_GLOBAL));
+    if (!cached)
+        return con_find_fullscreen_con(con, fullscreen_mode);
+
+    /* A cached container which left fullscreen mode or was moved away is
+     * noticed here. A container entering fullscreen mode or being moved here
+     * invalidates the cache, see con_invalidate_fullscreen_con(). */
+    Con *fullscreen = con->fullscreen_con;
+    if (con->fullscreen_con_valid &&
+        (fullscreen == NULL ||
+         (fullscreen->fullscreen_mode == fullscreen_mode && con_is_below(fullscreen, con))))
+        return fullscreen;
+
+    con->fullscreen_con = con_find_fullscreen_con(con, fullscreen_mode);
+    con->fullscreen_con_valid = true;
+    return con->fullscreen_con;
+}
+
+/*
+ * Invalidates the cached fullscreen containers of the workspace and the root
+ * container above the given container. Needs to be called whenever a
+ * fullscreen container could have been added below them.
+ *
+ */
+void con_invalidate_fullscreen_con(Con *con) {
+    for (; con != NULL; con = con->parent)
+        if (con->type == CT_WORKSPACE || con->type == CT_ROOT)
+            con->fullscreen_con_valid = false;
+}
+
 /**
  * Returns true if the container is internal, such as __i3_scratch
  *
@@ -514,13 +656,7 @@ Con *con_for_window(Con *con, i3Window *window, Match **store_match) {
  *
  */
 int con_num_children(Con *con) {
-    Con *child;
-    int children = 0;
-
-    TAILQ_FOREACH(child, &(con->nodes_head), nodes)
-        children++;
-
-    return children;
+    return con->num_children;
 }
 
 /*
@@ -600,6 +736,7 @@ void con_toggle_fullscreen(Con *con, int fullscreen_mode) {
 
         /* 2: enable fullscreen */
         con->fullscreen_mode = fullscreen_mode;
+        con_invalidate_fullscreen_con(con);
     } else {
         /* 1: disable fullscreen */
         con->fullscreen_mode = CF_NONE;
@@ -797,7 +934,7 @@ void con_move_to_workspace(Con *con, Con *workspace, bool fix_coordinates, bool
 
             cookie = xcb_get_property(conn, false, child->window->id,
                 A__NET_STARTUP_ID, XCB_GET_PROPERTY_TYPE_ANY, 0, 512);
-            startup_id_reply = xcb_get_property_reply(conn, cookie, NULL);
+            startup_id_reply = X_WAIT(xcb_get_property_reply, conn, cookie, NULL);
 
             sequence = startup_sequence_get(child->window, startup_id_reply, true);
             if (sequence != NULL)
@@ -808,7 +945,7 @@ void con_move_to_workspace(Con *con, Con *workspace, bool fix_coordinates, bool
     if (con->window) {
         cookie = xcb_get_property(conn, false, con->window->id,
             A__NET_STARTUP_ID, XCB_GET_PROPERTY_TYPE_ANY, 0, 512);
-        startup_id_reply = xcb_get_property_reply(conn, cookie, NULL);
+        startup_id_reply = X_WAIT(xcb_get_property_reply, conn, cookie, NULL);
 
         sequence = startup_sequence_get(con->window, startup_id_reply, true);
         if (sequence != NULL)
@@ -1507,19 +1644,11 @@ bool con_fullscreen_permits_focusing(Con *con) {
  *
  */
 bool con_has_urgent_child(Con *con) {
-    Con *child;
-
     if (con_is_leaf(con))
         return con->urgent;
 
-    /* We are not interested in floating windows since they can only be
-     * attached to a workspace → nodes_head instead of focus_head */
-    TAILQ_FOREACH(child, &(con->nodes_head), nodes) {
-        if (con_has_urgent_child(child))
-            return true;
-    }
-
-    return false;
+    /* Note that for workspaces, this includes floating windows. */
+    return (con->urgent_windows > 0);
 }
 
 /*
@@ -1533,12 +1662,12 @@ void con_update_parents_urgency(Con *con) {
     bool new_urgency_value = con->urgent;
     while (parent && parent->type != CT_WORKSPACE && parent->type != CT_DOCKAREA) {
         if (new_urgency_value) {
-            parent->urgent = true;
+            con_set_urgent_flag(parent, true);
         } else {
             /* We can only reset the urgency when the parent
              * has no other urgent children */
             if (!con_has_urgent_child(parent))
-                parent->urgent = false;
+                con_set_urgent_flag(parent, false);
         }
         parent = parent->parent;
     }
@@ -1557,7 +1686,7 @@ void con_set_urgency(Con *con, bool urgent) {
     }
 
     if (con->urgency_timer == NULL) {
-        con->urgent = urgent;
+        con_set_urgent_flag(con, urgent);
     } else
         DLOG("Discarding urgency WM_HINT because timer is running\n");
 
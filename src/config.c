@@ -319,6 +319,7 @@ void load_configuration(xcb_connection_t *conn, const char *override_configpath,
             FREE(bindings);
             SLIST_REMOVE(&modes, mode, Mode, modes);
         }
+        workspace_invalidate_binding_names();
 
         struct Assignment *assign;
         while (!TAILQ_EMPTY(&assignments)) {
@@ -375,7 +376,7 @@ void load_configuration(xcb_connection_t *conn, const char *override_configpath,
         /* Invalidate pixmap caches in case font or colors changed */
         Con *con;
         TAILQ_FOREACH(con, &all_cons, all_cons)
-            FREE(con->deco_render_params);
+            POOL_FREE(&deco_render_params_pool, con->deco_render_params);
 
         /* Get rid of the current font */
         free_font();
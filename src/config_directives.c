@@ -391,6 +391,10 @@ CFGFUN(restart_state, const char *path) {
     config.restart_state_path = sstrdup(path);
 }
 
+CFGFUN(restart_state_format, const char *format) {
+    config.restart_state_binary = (strcmp(format, "binary") == 0);
+}
+
 CFGFUN(popup_during_fullscreen, const char *value) {
     if (strcmp(value, "ignore") == 0) {
         config.popup_during_fullscreen = PDF_IGNORE;
@@ -542,6 +546,10 @@ CFGFUN(bar_status_command, const char *command) {
     current_bar.status_command = sstrdup(command);
 }
 
+CFGFUN(bar_status_interval, const long interval_ms) {
+    current_bar.status_interval = interval_ms;
+}
+
 CFGFUN(bar_workspace_buttons, const char *value) {
     current_bar.hide_workspace_buttons = !eval_boolstr(value);
 }
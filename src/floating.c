@@ -41,9 +41,11 @@ void floating_check_size(Con *floating_con) {
     Rect floating_sane_max_dimensions;
     Con *focused_con = con_descend_focused(floating_con);
 
-    /* obey size increments */
-    if (focused_con->height_increment || focused_con->width_increment) {
-        Rect border_rect = con_border_style_rect(focused_con);
+    const bool proportional = (focused_con->proportional_width != 0 &&
+                               focused_con->proportional_height != 0);
+    Rect border_rect = { 0, 0, 0, 0 };
+    if (focused_con->height_increment || focused_con->width_increment || proportional) {
+        border_rect = con_border_style_rect(focused_con);
 
         /* We have to do the opposite calculations that render_con() do
          * to get the exact size we want. */
@@ -53,6 +55,23 @@ void floating_check_size(Con *floating_con) {
         border_rect.height += 2 * focused_con->border_width;
         if (con_border_style(focused_con) == BS_NORMAL)
             border_rect.height += render_deco_height();
+    }
+
+    /* obey the aspect ratio, so that render_con() does not need to leave
+     * empty space around the window */
+    if (proportional &&
+        floating_con->rect.width > border_rect.width &&
+        floating_con->rect.height > border_rect.height) {
+        uint32_t width = floating_con->rect.width - border_rect.width;
+        uint32_t height = floating_con->rect.height - border_rect.height;
+        fit_aspect_ratio(&width, &height,
+                         focused_con->proportional_width, focused_con->proportional_height);
+        floating_con->rect.width = width + border_rect.width;
+        floating_con->rect.height = height + border_rect.height;
+    }
+
+    /* obey size increments */
+    if (focused_con->height_increment || focused_con->width_increment) {
 
         if (focused_con->height_increment &&
             floating_con->rect.height >= focused_con->base_height + border_rect.height) {
@@ -160,6 +179,7 @@ void floating_enable(Con *con, bool automatic) {
 
     /* 1: detach the container from its parent */
     /* TODO: refactor this with tree_close() */
+    con_aggregates_detach(con);
     TAILQ_REMOVE(&(con->parent->nodes_head), con, nodes);
     TAILQ_REMOVE(&(con->parent->focus_head), con, focused);
 
@@ -180,6 +200,7 @@ void floating_enable(Con *con, bool automatic) {
      * closed in tree_close()) even though it’s not. */
     TAILQ_INSERT_TAIL(&(ws->floating_head), nc, floating_windows);
     TAILQ_INSERT_TAIL(&(ws->focus_head), nc, focused);
+    con_aggregates_attach(nc);
 
     /* check if the parent container is empty and close it if so */
     if ((con->parent->type == CT_CON || con->parent->type == CT_FLOATING_CON) &&
@@ -287,6 +308,8 @@ void floating_enable(Con *con, bool automatic) {
 
     TAILQ_INSERT_TAIL(&(nc->nodes_head), con, nodes);
     TAILQ_INSERT_TAIL(&(nc->focus_head), con, focused);
+    con_invalidate_fullscreen_con(con);
+    con_aggregates_attach(con);
 
     /* render the cons to get initial window_rect correct */
     render_con(nc, false);
@@ -318,6 +341,7 @@ void floating_disable(Con *con, bool automatic) {
     Con *ws = con_get_workspace(con);
 
     /* 1: detach from parent container */
+    con_aggregates_detach(con);
     TAILQ_REMOVE(&(con->parent->nodes_head), con, nodes);
     TAILQ_REMOVE(&(con->parent->focus_head), con, focused);
 
@@ -582,7 +606,7 @@ void drag_pointer(Con *con, const xcb_button_press_event_t *event, xcb_window_t
         xcursor,             /* possibly display a special cursor */
         XCB_CURRENT_TIME);
 
-    if ((reply = xcb_grab_pointer_reply(conn, cookie, NULL)) == NULL) {
+    if ((reply = X_WAIT(xcb_grab_pointer_reply, conn, cookie, NULL)) == NULL) {
         ELOG("Could not grab pointer\n");
         return;
     }
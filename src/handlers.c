@@ -491,7 +491,7 @@ ignore_end:
      * into fullscreen and moving the pointer to a different window, without
      * using GetInputFocus, subsequent (legitimate) EnterNotify events arrived
      * with the same sequence and thus were ignored (see ticket #609). */
-    free(xcb_get_input_focus_reply(conn, cookie, NULL));
+    free(X_WAIT(xcb_get_input_focus_reply, conn, cookie, NULL));
 }
 
 /*
@@ -730,7 +730,7 @@ static bool handle_normal_hints(void *data, xcb_connection_t *conn, uint8_t stat
     if (reply != NULL)
         xcb_icccm_get_wm_size_hints_from_reply(&size_hints, reply);
     else
-        xcb_icccm_get_wm_normal_hints_reply(conn, xcb_icccm_get_wm_normal_hints_unchecked(conn, con->window->id), &size_hints, NULL);
+        X_WAIT(xcb_icccm_get_wm_normal_hints_reply, conn, xcb_icccm_get_wm_normal_hints_unchecked(conn, con->window->id), &size_hints, NULL);
 
     if ((size_hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE)) {
         // TODO: Minimum size is not yet implemented
@@ -785,36 +785,38 @@ static bool handle_normal_hints(void *data, xcb_connection_t *conn, uint8_t stat
     }
 
     /* XXX: do we really use rect here, not window_rect? */
-    double width = con->rect.width - base_width;
-    double height = con->rect.height - base_height;
-    /* Convert numerator/denominator to a double */
-    double min_aspect = (double)size_hints.min_aspect_num / size_hints.min_aspect_den;
-    double max_aspect = (double)size_hints.max_aspect_num / size_hints.min_aspect_den;
+    const int64_t width = (int64_t)con->rect.width - base_width;
+    const int64_t height = (int64_t)con->rect.height - base_height;
 
-    DLOG("Aspect ratio set: minimum %f, maximum %f\n", min_aspect, max_aspect);
-    DLOG("width = %f, height = %f\n", width, height);
+    DLOG("Aspect ratio set: minimum %d/%d, maximum %d/%d\n",
+         size_hints.min_aspect_num, size_hints.min_aspect_den,
+         size_hints.max_aspect_num, size_hints.max_aspect_den);
+    DLOG("width = %d, height = %d\n", (int)width, (int)height);
 
     /* Sanity checks, this is user-input, in a way */
-    if (max_aspect <= 0 || min_aspect <= 0 || height == 0 || (width / height) <= 0)
+    if (size_hints.max_aspect_num <= 0 || size_hints.max_aspect_den <= 0 ||
+        width <= 0 || height <= 0)
         goto render_and_return;
 
-    /* Check if we need to set proportional_* variables using the correct ratio */
-    if ((width / height) < min_aspect) {
-        if (con->proportional_width != width ||
-            con->proportional_height != (width / min_aspect)) {
-            con->proportional_width = width;
-            con->proportional_height = width / min_aspect;
-            changed = true;
-        }
-    } else if ((width / height) > max_aspect) {
-        if (con->proportional_width != width ||
-            con->proportional_height != (width / max_aspect)) {
-            con->proportional_width = width;
-            con->proportional_height = width / max_aspect;
-            changed = true;
-        }
+    /* Check if we need to set proportional_* variables using the correct
+     * ratio. The ratios are compared (and stored) as fractions, so that
+     * render_con() can fit the window exactly. */
+    int ratio_width, ratio_height;
+    if (width * size_hints.min_aspect_den < height * size_hints.min_aspect_num) {
+        ratio_width = size_hints.min_aspect_num;
+        ratio_height = size_hints.min_aspect_den;
+    } else if (width * size_hints.max_aspect_den > height * size_hints.max_aspect_num) {
+        ratio_width = size_hints.max_aspect_num;
+        ratio_height = size_hints.max_aspect_den;
     } else goto render_and_return;
 
+    if (con->proportional_width != ratio_width ||
+        con->proportional_height != ratio_height) {
+        con->proportional_width = ratio_width;
+        con->proportional_height = ratio_height;
+        changed = true;
+    }
+
 render_and_return:
     if (changed)
         tree_render();
@@ -837,7 +839,7 @@ static bool handle_hints(void *data, xcb_connection_t *conn, uint8_t state, xcb_
     xcb_icccm_wm_hints_t hints;
 
     if (reply == NULL)
-        if (!(reply = xcb_get_property_reply(conn, xcb_icccm_get_wm_hints(conn, window), NULL)))
+        if (!(reply = X_WAIT(xcb_get_property_reply, conn, xcb_icccm_get_wm_hints(conn, window), NULL)))
             return false;
 
     if (!xcb_icccm_get_wm_hints_from_reply(&hints, reply))
@@ -872,7 +874,7 @@ static bool handle_transient_for(void *data, xcb_connection_t *conn, uint8_t sta
     }
 
     if (prop == NULL) {
-        prop = xcb_get_property_reply(conn, xcb_get_property_unchecked(conn,
+        prop = X_WAIT(xcb_get_property_reply, conn, xcb_get_property_unchecked(conn,
                                 false, window, XCB_ATOM_WM_TRANSIENT_FOR, XCB_ATOM_WINDOW, 0, 32), NULL);
         if (prop == NULL)
             return false;
@@ -895,7 +897,7 @@ static bool handle_clientleader_change(void *data, xcb_connection_t *conn, uint8
         return false;
 
     if (prop == NULL) {
-        prop = xcb_get_property_reply(conn, xcb_get_property_unchecked(conn,
+        prop = X_WAIT(xcb_get_property_reply, conn, xcb_get_property_unchecked(conn,
                                 false, window, A_WM_CLIENT_LEADER, XCB_ATOM_WINDOW, 0, 32), NULL);
         if (prop == NULL)
             return false;
@@ -1015,7 +1017,7 @@ static void property_notify(uint8_t state, xcb_window_t window, xcb_atom_t atom)
 
     if (state != XCB_PROPERTY_DELETE) {
         xcb_get_property_cookie_t cookie = xcb_get_property(conn, 0, window, atom, XCB_GET_PROPERTY_TYPE_ANY, 0, handler->long_len);
-        propr = xcb_get_property_reply(conn, cookie, 0);
+        propr = X_WAIT(xcb_get_property_reply, conn, cookie, 0);
     }
 
     /* the handler will free() the reply unless it returns false */
@@ -1023,12 +1025,7 @@ static void property_notify(uint8_t state, xcb_window_t window, xcb_atom_t atom)
         FREE(propr);
 }
 
-/*
- * Takes an xcb_generic_event_t and calls the appropriate handler, based on the
- * event type.
- *
- */
-void handle_event(int type, xcb_generic_event_t *event) {
+static void dispatch_event(int type, xcb_generic_event_t *event) {
     if (randr_base > -1 &&
         type == randr_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
         handle_screen_change(event);
@@ -1103,3 +1100,19 @@ void handle_event(int type, xcb_generic_event_t *event) {
             break;
     }
 }
+
+/*
+ * Takes an xcb_generic_event_t and calls the appropriate handler, based on the
+ * event type.
+ *
+ */
+void handle_event(int type, xcb_generic_event_t *event) {
+    x_stats_span span;
+    x_stats_begin(&span);
+    const uint64_t start = latency_now();
+
+    dispatch_event(type, event);
+
+    latency_record_event(type, start);
+    x_stats_end_event(&span, type);
+}
@@ -11,13 +11,13 @@
  */
 #include "all.h"
 #include "yajl_utils.h"
+#include "json_utils.h"
 
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <fcntl.h>
 #include <libgen.h>
 #include <ev.h>
-#include <yajl/yajl_gen.h>
 #include <yajl/yajl_parse.h>
 
 char *current_socketpath = NULL;
@@ -67,26 +67,121 @@ static bool mkdirp(const char *path) {
     return result;
 }
 
+/*
+ * While a COMMAND_BATCH is executed, events are queued instead of sent
+ * immediately (see queue_event()) and sent after the tree was rendered.
+ *
+ */
+typedef struct queued_event {
+    char *event;
+    uint32_t message_type;
+    char *payload;
+
+    TAILQ_ENTRY(queued_event) queued_events;
+} queued_event;
+
+static TAILQ_HEAD(queued_events_head, queued_event) queued_events =
+    TAILQ_HEAD_INITIALIZER(queued_events);
+
+static bool batch_running = false;
+
+static bool client_subscribed(ipc_client *client, const char *event);
+
+/* Events which describe the new state as a whole, so that two identical ones
+ * in a row say nothing more than one of them. Other events are never
+ * coalesced: e.g. two {"change":"empty"} workspace events are about different
+ * workspaces. */
+static const char *coalesced_events[] = { "mode", "output" };
+
+/*
+ * Queues the event until the COMMAND_BATCH is done. Events nobody subscribed
+ * to are dropped right away. One of the coalesced_events is dropped if it is
+ * identical (same event, message type and payload) to the event queued right
+ * before it.
+ *
+ */
+static void queue_event(const char *event, uint32_t message_type, const char *payload) {
+    if (!ipc_has_subscribers(event))
+        return;
+
+    queued_event *queued = TAILQ_LAST(&queued_events, queued_events_head);
+    if (queued != NULL &&
+        strcmp(queued->event, event) == 0 &&
+        queued->message_type == message_type &&
+        strcmp(queued->payload, payload) == 0) {
+        for (size_t c = 0; c < sizeof(coalesced_events) / sizeof(coalesced_events[0]); c++) {
+            if (strcmp(event, coalesced_events[c]) != 0)
+                continue;
+            DLOG("Coalescing %s event during command batch\n", event);
+            return;
+        }
+    }
+
+    queued = smalloc(sizeof(queued_event));
+    queued->event = sstrdup(event);
+    queued->message_type = message_type;
+    queued->payload = sstrdup(payload);
+    TAILQ_INSERT_TAIL(&queued_events, queued, queued_events);
+}
+
+/*
+ * Sends all queued events (in the order they were generated).
+ *
+ */
+static void send_queued_events(void) {
+    while (!TAILQ_EMPTY(&queued_events)) {
+        queued_event *queued = TAILQ_FIRST(&queued_events);
+        TAILQ_REMOVE(&queued_events, queued, queued_events);
+        ipc_send_event(queued->event, queued->message_type, queued->payload);
+        free(queued->event);
+        free(queued->payload);
+        free(queued);
+    }
+}
+
+/*
+ * Returns true if the given client subscribed to the given event.
+ *
+ */
+static bool client_subscribed(ipc_client *client, const char *event) {
+    for (int i = 0; i < client->num_events; i++)
+        if (strcasecmp(client->events[i], event) == 0)
+            return true;
+    return false;
+}
+
+/*
+ * Returns true if at least one of the connected IPC clients subscribed to the
+ * given event. Event producers check this before generating the payload, so
+ * that no time is spent on events nobody receives.
+ *
+ */
+bool ipc_has_subscribers(const char *event) {
+    ipc_client *current;
+    TAILQ_FOREACH(current, &all_clients, clients)
+        if (client_subscribed(current, event))
+            return true;
+    return false;
+}
+
 /*
  * Sends the specified event to all IPC clients which are currently connected
  * and subscribed to this kind of event.
  *
  */
 void ipc_send_event(const char *event, uint32_t message_type, const char *payload) {
+    if (batch_running) {
+        queue_event(event, message_type, payload);
+        return;
+    }
+
+    const size_t length = strlen(payload);
     ipc_client *current;
     TAILQ_FOREACH(current, &all_clients, clients) {
-        /* see if this client is interested in this event */
-        bool interested = false;
-        for (int i = 0; i < current->num_events; i++) {
-            if (strcasecmp(current->events[i], event) != 0)
-                continue;
-            interested = true;
-            break;
-        }
-        if (!interested)
+        if (!client_subscribed(current, event))
             continue;
 
-        ipc_send_message(current->fd, strlen(payload), message_type, (const uint8_t*)payload);
+        ipc_send_message(current->fd, length, message_type, (const uint8_t*)payload);
     }
 }
 
@@ -106,6 +201,18 @@ void ipc_shutdown(void) {
     }
 }
 
+/*
+ * Returns the (emptied) writer which the IPC handlers generate their replies
+ * with. Replies are sent before the handler returns, so one writer can be
+ * shared by all of them and its buffer only grows up to the biggest reply.
+ *
+ */
+static json_writer *reply_writer(void) {
+    static json_writer writer;
+    json_writer_reset(&writer);
+    return &writer;
+}
+
 /*
  * Executes the command and returns whether it could be successfully parsed
  * or not (at the moment, always returns true).
@@ -124,256 +231,724 @@ IPC_HANDLER(command) {
         tree_render();
 
     const unsigned char *reply;
-    ylength length;
-    yajl_gen_get_buf(command_output->json_gen, &reply, &length);
+    size_t length;
+    json_writer_get_buf(command_output->json_gen, &reply, &length);
 
     ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_COMMAND,
                      (const uint8_t*)reply);
+}
+
+/*
+ * The state of the parser for a COMMAND_BATCH request (a JSON list of
+ * commands).
+ *
+ */
+struct batch_request {
+    int nesting;
+    char **commands;
+    int num_commands;
+    const char *error;
+};
+
+#if YAJL_MAJOR >= 2
+static int batch_request_string(void *ctx, const unsigned char *val, size_t len) {
+#else
+static int batch_request_string(void *ctx, const unsigned char *val, unsigned int len) {
+#endif
+    struct batch_request *request = ctx;
+    if (request->nesting != 1) {
+        request->error = "a command batch has to be a list of strings";
+        return 0;
+    }
+    char *command = scalloc(len + 1);
+    strncpy(command, (const char*)val, len);
+    request->commands = srealloc(request->commands, sizeof(char*) * (request->num_commands + 1));
+    request->commands[request->num_commands++] = command;
+    return 1;
+}
+
+static int batch_request_start_array(void *ctx) {
+    struct batch_request *request = ctx;
+    if (request->nesting++ != 0) {
+        request->error = "a command batch has to be a list of strings";
+        return 0;
+    }
+    return 1;
+}
+
+static int batch_request_end_array(void *ctx) {
+    struct batch_request *request = ctx;
+    request->nesting--;
+    return 1;
+}
+
+static int batch_request_invalid(void *ctx) {
+    struct batch_request *request = ctx;
+    request->error = "a command batch has to be a list of strings";
+    return 0;
+}
+
+static int batch_request_invalid_boolean(void *ctx, int val) {
+    return batch_request_invalid(ctx);
+}
+
+#if YAJL_MAJOR >= 2
+static int batch_request_invalid_number(void *ctx, const char *val, size_t len) {
+#else
+static int batch_request_invalid_number(void *ctx, const char *val, unsigned int len) {
+#endif
+    return batch_request_invalid(ctx);
+}
+
+/*
+ * Parses the payload of a COMMAND_BATCH request, like
+ * ["workspace 3", "layout tabbed"].
+ *
+ * Returns an error message if the request is invalid, NULL otherwise.
+ *
+ */
+static const char *parse_batch_request(struct batch_request *request, const uint8_t *message, uint32_t message_size) {
+    static yajl_callbacks callbacks = {
+        .yajl_null = batch_request_invalid,
+        .yajl_boolean = batch_request_invalid_boolean,
+        .yajl_number = batch_request_invalid_number,
+        .yajl_string = batch_request_string,
+        .yajl_start_map = batch_request_invalid,
+        .yajl_start_array = batch_request_start_array,
+        .yajl_end_array = batch_request_end_array,
+    };
+
+    yajl_handle handle = yalloc(&callbacks, request);
+    yajl_status stat = yajl_parse(handle, message, message_size);
+#if YAJL_MAJOR >= 2
+    if (stat == yajl_status_ok)
+        stat = yajl_complete_parse(handle);
+#endif
+    if (stat != yajl_status_ok && request->error == NULL)
+        request->error = "could not parse the command batch";
+    yajl_free(handle);
+    return request->error;
+}
+
+/*
+ * Executes a list of commands as one transaction: the tree is rendered (and
+ * pushed to X11) only once, after the last command. Events generated by the
+ * commands are coalesced and sent after rendering. The reply is a list
+ * containing the reply of each command (as for COMMAND).
+ *
+ */
+IPC_HANDLER(command_batch) {
+    static json_writer writer;
+    json_writer *gen = &writer;
+    json_writer_reset(gen);
+
+    struct batch_request request = { 0 };
+    if (parse_batch_request(&request, message, message_size) != NULL) {
+        ELOG("Invalid COMMAND_BATCH request: %s\n", request.error);
+        y(map_open);
+        ykey("success");
+        y(bool, false);
+        ykey("error");
+        ystr(request.error);
+        y(map_close);
+    } else {
+        LOG("IPC: received a batch of %d commands\n", request.num_commands);
+        /* Commands like kill render the tree on their own. Those renders are
+         * deferred until all commands ran, so the batch is rendered once. */
+        bool needs_tree_render = false;
+        batch_running = true;
+        tree_defer_render(true);
+        y(array_open);
+        for (int c = 0; c < request.num_commands; c++) {
+            LOG("IPC: batch command %d: *%s*\n", c, request.commands[c]);
+            struct CommandResult *command_output = parse_command(request.commands[c]);
+            if (command_output->needs_tree_render)
+                needs_tree_render = true;
+
+            const unsigned char *reply;
+            size_t length;
+            json_writer_get_buf(command_output->json_gen, &reply, &length);
+            y(raw, (const char*)reply, length);
+        }
+        y(array_close);
+
+        if (needs_tree_render)
+            tree_render();
+        tree_defer_render(false);
+        batch_running = false;
+        send_queued_events();
+    }
 
-    yajl_gen_free(command_output->json_gen);
+    for (int c = 0; c < request.num_commands; c++)
+        free(request.commands[c]);
+    free(request.commands);
+
+    const unsigned char *payload;
+    size_t length;
+    y(get_buf, &payload, &length);
+
+    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_COMMAND_BATCH, payload);
 }
 
-static void dump_rect(yajl_gen gen, const char *name, Rect r) {
+/*
+ * The fields of a container in a GET_TREE reply. A client can request only
+ * some of them, see struct tree_projection.
+ *
+ */
+enum tree_field {
+    TF_ID = 0,
+    TF_TYPE,
+    TF_ORIENTATION,
+    TF_SCRATCHPAD_STATE,
+    TF_PERCENT,
+    TF_URGENT,
+    TF_MARK,
+    TF_FOCUSED,
+    TF_LAYOUT,
+    TF_WORKSPACE_LAYOUT,
+    TF_LAST_SPLIT_LAYOUT,
+    TF_BORDER,
+    TF_CURRENT_BORDER_WIDTH,
+    TF_RECT,
+    TF_WINDOW_RECT,
+    TF_GEOMETRY,
+    TF_NAME,
+    TF_NUM,
+    TF_WINDOW,
+    TF_NODES,
+    TF_FLOATING_NODES,
+    TF_FOCUS,
+    TF_FULLSCREEN_MODE,
+    TF_FLOATING,
+    TF_SWALLOWS,
+    TF_NUMBER_OF_FIELDS
+};
+
+static const char *tree_field_names[TF_NUMBER_OF_FIELDS] = {
+    "id",
+    "type",
+    "orientation",
+    "scratchpad_state",
+    "percent",
+    "urgent",
+    "mark",
+    "focused",
+    "layout",
+    "workspace_layout",
+    "last_split_layout",
+    "border",
+    "current_border_width",
+    "rect",
+    "window_rect",
+    "geometry",
+    "name",
+    "num",
+    "window",
+    "nodes",
+    "floating_nodes",
+    "focus",
+    "fullscreen_mode",
+    "floating",
+    "swallows",
+};
+
+#define TF_ALL ((1 << TF_NUMBER_OF_FIELDS) - 1)
+
+/*
+ * Selects the part of the tree and the fields which are dumped.
+ *
+ */
+struct tree_projection {
+    /* Bitmask of (1 << enum tree_field). */
+    uint32_t fields;
+    /* The children of containers at this depth (the root has depth 0) are
+     * not dumped. -1 means no limit. */
+    int max_depth;
+};
+
+static const struct tree_projection full_projection = { TF_ALL, -1 };
+
+/* Events only describe the container itself: its children are not dumped
+ * (the "focus" list still contains their IDs). */
+static const struct tree_projection event_projection = { TF_ALL, 0 };
+
+static void dump_rect(json_writer *gen, const char *name, Rect r) {
     ystr(name);
     y(map_open);
-    ystr("x");
+    ykey("x");
     y(integer, r.x);
-    ystr("y");
+    ykey("y");
     y(integer, r.y);
-    ystr("width");
+    ykey("width");
     y(integer, r.width);
-    ystr("height");
+    ykey("height");
     y(integer, r.height);
     y(map_close);
 }
 
-void dump_node(yajl_gen gen, struct Con *con, bool inplace_restart) {
+static void dump_con(json_writer *gen, Con *con, bool inplace_restart,
+                     const struct tree_projection *projection, int depth) {
+#define WANT(field) (projection->fields & (1 << (field)))
+    const bool descend = (projection->max_depth == -1 || depth < projection->max_depth);
+
     y(map_open);
-    ystr("id");
-    y(integer, (long int)con);
+    if (WANT(TF_ID)) {
+        ykey("id");
+        y(integer, (long int)con);
+    }
 
-    ystr("type");
-    y(integer, con->type);
+    if (WANT(TF_TYPE)) {
+        ykey("type");
+        y(integer, con->type);
+    }
 
     /* provided for backwards compatibility only. */
-    ystr("orientation");
-    if (!con_is_split(con))
-        ystr("none");
-    else {
-        if (con_orientation(con) == HORIZ)
-            ystr("horizontal");
-        else ystr("vertical");
+    if (WANT(TF_ORIENTATION)) {
+        ykey("orientation");
+        if (!con_is_split(con))
+            ystr("none");
+        else {
+            if (con_orientation(con) == HORIZ)
+                ystr("horizontal");
+            else ystr("vertical");
+        }
     }
 
-    ystr("scratchpad_state");
-    switch (con->scratchpad_state) {
-        case SCRATCHPAD_NONE:
-            ystr("none");
-            break;
-        case SCRATCHPAD_FRESH:
-            ystr("fresh");
-            break;
-        case SCRATCHPAD_CHANGED:
-            ystr("changed");
-            break;
+    if (WANT(TF_SCRATCHPAD_STATE)) {
+        ykey("scratchpad_state");
+        switch (con->scratchpad_state) {
+            case SCRATCHPAD_NONE:
+                ystr("none");
+                break;
+            case SCRATCHPAD_FRESH:
+                ystr("fresh");
+                break;
+            case SCRATCHPAD_CHANGED:
+                ystr("changed");
+                break;
+        }
     }
 
-    ystr("percent");
-    if (con->percent == 0.0)
-        y(null);
-    else y(double, con->percent);
+    if (WANT(TF_PERCENT)) {
+        ykey("percent");
+        if (con->percent == 0.0)
+            y(null);
+        else y(double, con->percent);
+    }
 
-    ystr("urgent");
-    y(bool, con->urgent);
+    if (WANT(TF_URGENT)) {
+        ykey("urgent");
+        y(bool, con->urgent);
+    }
 
-    if (con->mark != NULL) {
-        ystr("mark");
+    if (WANT(TF_MARK) && con->mark != NULL) {
+        ykey("mark");
         ystr(con->mark);
     }
 
-    ystr("focused");
-    y(bool, (con == focused));
-
-    ystr("layout");
-    switch (con->layout) {
-        case L_DEFAULT:
-            DLOG("About to dump layout=default, this is a bug in the code.\n");
-            assert(false);
-            break;
-        case L_SPLITV:
-            ystr("splitv");
-            break;
-        case L_SPLITH:
-            ystr("splith");
-            break;
-        case L_STACKED:
-            ystr("stacked");
-            break;
-        case L_TABBED:
-            ystr("tabbed");
-            break;
-        case L_DOCKAREA:
-            ystr("dockarea");
-            break;
-        case L_OUTPUT:
-            ystr("output");
-            break;
+    if (WANT(TF_FOCUSED)) {
+        ykey("focused");
+        y(bool, (con == focused));
     }
 
-    ystr("workspace_layout");
-    switch (con->workspace_layout) {
-        case L_DEFAULT:
-            ystr("default");
-            break;
-        case L_STACKED:
-            ystr("stacked");
-            break;
-        case L_TABBED:
-            ystr("tabbed");
-            break;
-        default:
-            DLOG("About to dump workspace_layout=%d (none of default/stacked/tabbed), this is a bug.\n", con->workspace_layout);
-            assert(false);
-            break;
+    if (WANT(TF_LAYOUT)) {
+        ykey("layout");
+        switch (con->layout) {
+            case L_DEFAULT:
+                DLOG("About to dump layout=default, this is a bug in the code.\n");
+                assert(false);
+                break;
+            case L_SPLITV:
+                ystr("splitv");
+                break;
+            case L_SPLITH:
+                ystr("splith");
+                break;
+            case L_STACKED:
+                ystr("stacked");
+                break;
+            case L_TABBED:
+                ystr("tabbed");
+                break;
+            case L_DOCKAREA:
+                ystr("dockarea");
+                break;
+            case L_OUTPUT:
+                ystr("output");
+                break;
+        }
     }
 
-    ystr("last_split_layout");
-    switch (con->layout) {
-        case L_SPLITV:
-            ystr("splitv");
-            break;
-        default:
-            ystr("splith");
-            break;
+    if (WANT(TF_WORKSPACE_LAYOUT)) {
+        ykey("workspace_layout");
+        switch (con->workspace_layout) {
+            case L_DEFAULT:
+                ystr("default");
+                break;
+            case L_STACKED:
+                ystr("stacked");
+                break;
+            case L_TABBED:
+                ystr("tabbed");
+                break;
+            default:
+                DLOG("About to dump workspace_layout=%d (none of default/stacked/tabbed), this is a bug.\n", con->workspace_layout);
+                assert(false);
+                break;
+        }
     }
 
-    ystr("border");
-    switch (con->border_style) {
-        case BS_NORMAL:
-            ystr("normal");
-            break;
-        case BS_NONE:
-            ystr("none");
-            break;
-        case BS_PIXEL:
-            ystr("pixel");
-            break;
+    if (WANT(TF_LAST_SPLIT_LAYOUT)) {
+        ykey("last_split_layout");
+        switch (con->layout) {
+            case L_SPLITV:
+                ystr("splitv");
+                break;
+            default:
+                ystr("splith");
+                break;
+        }
     }
 
-    ystr("current_border_width");
-    y(integer, con->current_border_width);
+    if (WANT(TF_BORDER)) {
+        ykey("border");
+        switch (con->border_style) {
+            case BS_NORMAL:
+                ystr("normal");
+                break;
+            case BS_NONE:
+                ystr("none");
+                break;
+            case BS_PIXEL:
+                ystr("pixel");
+                break;
+        }
+    }
 
-    dump_rect(gen, "rect", con->rect);
-    dump_rect(gen, "window_rect", con->window_rect);
-    dump_rect(gen, "geometry", con->geometry);
+    if (WANT(TF_CURRENT_BORDER_WIDTH)) {
+        ykey("current_border_width");
+        y(integer, con->current_border_width);
+    }
 
-    ystr("name");
-    if (con->window && con->window->name)
-        ystr(i3string_as_utf8(con->window->name));
-    else
-        ystr(con->name);
+    if (WANT(TF_RECT))
+        dump_rect(gen, "rect", con->rect);
+    if (WANT(TF_WINDOW_RECT))
+        dump_rect(gen, "window_rect", con->window_rect);
+    if (WANT(TF_GEOMETRY))
+        dump_rect(gen, "geometry", con->geometry);
+
+    if (WANT(TF_NAME)) {
+        ykey("name");
+        if (con->window && con->window->name)
+            ystr(i3string_as_utf8(con->window->name));
+        else
+            ystr(con->name);
+    }
 
-    if (con->type == CT_WORKSPACE) {
-        ystr("num");
+    if (WANT(TF_NUM) && con->type == CT_WORKSPACE) {
+        ykey("num");
         y(integer, con->num);
     }
 
-    ystr("window");
-    if (con->window)
-        y(integer, con->window->id);
-    else y(null);
+    if (WANT(TF_WINDOW)) {
+        ykey("window");
+        if (con->window)
+            y(integer, con->window->id);
+        else y(null);
+    }
 
-    ystr("nodes");
-    y(array_open);
     Con *node;
-    if (con->type != CT_DOCKAREA || !inplace_restart) {
-        TAILQ_FOREACH(node, &(con->nodes_head), nodes) {
-            dump_node(gen, node, inplace_restart);
+    if (WANT(TF_NODES)) {
+        ykey("nodes");
+        y(array_open);
+        if (descend && (con->type != CT_DOCKAREA || !inplace_restart)) {
+            TAILQ_FOREACH(node, &(con->nodes_head), nodes) {
+                dump_con(gen, node, inplace_restart, projection, depth + 1);
+            }
         }
+        y(array_close);
     }
-    y(array_close);
 
-    ystr("floating_nodes");
-    y(array_open);
-    TAILQ_FOREACH(node, &(con->floating_head), floating_windows) {
-        dump_node(gen, node, inplace_restart);
+    if (WANT(TF_FLOATING_NODES)) {
+        ykey("floating_nodes");
+        y(array_open);
+        if (descend) {
+            TAILQ_FOREACH(node, &(con->floating_head), floating_windows) {
+                dump_con(gen, node, inplace_restart, projection, depth + 1);
+            }
+        }
+        y(array_close);
     }
-    y(array_close);
 
-    ystr("focus");
-    y(array_open);
-    TAILQ_FOREACH(node, &(con->focus_head), focused) {
-        y(integer, (long int)node);
+    if (WANT(TF_FOCUS)) {
+        ykey("focus");
+        y(array_open);
+        TAILQ_FOREACH(node, &(con->focus_head), focused) {
+            y(integer, (long int)node);
+        }
+        y(array_close);
     }
-    y(array_close);
-
-    ystr("fullscreen_mode");
-    y(integer, con->fullscreen_mode);
 
-    ystr("floating");
-    switch (con->floating) {
-        case FLOATING_AUTO_OFF:
-            ystr("auto_off");
-            break;
-        case FLOATING_AUTO_ON:
-            ystr("auto_on");
-            break;
-        case FLOATING_USER_OFF:
-            ystr("user_off");
-            break;
-        case FLOATING_USER_ON:
-            ystr("user_on");
-            break;
+    if (WANT(TF_FULLSCREEN_MODE)) {
+        ykey("fullscreen_mode");
+        y(integer, con->fullscreen_mode);
     }
 
-    ystr("swallows");
-    y(array_open);
-    Match *match;
-    TAILQ_FOREACH(match, &(con->swallow_head), matches) {
-        if (match->dock != -1) {
-            y(map_open);
-            ystr("dock");
-            y(integer, match->dock);
-            ystr("insert_where");
-            y(integer, match->insert_where);
-            y(map_close);
+    if (WANT(TF_FLOATING)) {
+        ykey("floating");
+        switch (con->floating) {
+            case FLOATING_AUTO_OFF:
+                ystr("auto_off");
+                break;
+            case FLOATING_AUTO_ON:
+                ystr("auto_on");
+                break;
+            case FLOATING_USER_OFF:
+                ystr("user_off");
+                break;
+            case FLOATING_USER_ON:
+                ystr("user_on");
+                break;
         }
-
-        /* TODO: the other swallow keys */
     }
 
-    if (inplace_restart) {
-        if (con->window != NULL) {
-            y(map_open);
-            ystr("id");
-            y(integer, con->window->id);
-            ystr("restart_mode");
-            y(bool, true);
-            y(map_close);
+    if (WANT(TF_SWALLOWS)) {
+        ykey("swallows");
+        y(array_open);
+        Match *match;
+        TAILQ_FOREACH(match, &(con->swallow_head), matches) {
+            if (match->dock != -1) {
+                y(map_open);
+                ykey("dock");
+                y(integer, match->dock);
+                ykey("insert_where");
+                y(integer, match->insert_where);
+                y(map_close);
+            }
+
+            /* TODO: the other swallow keys */
         }
+
+        if (inplace_restart) {
+            if (con->window != NULL) {
+                y(map_open);
+                ykey("id");
+                y(integer, con->window->id);
+                ykey("restart_mode");
+                y(bool, true);
+                y(map_close);
+            }
+        }
+        y(array_close);
     }
-    y(array_close);
 
     if (inplace_restart && con->window != NULL) {
-        ystr("depth");
+        ykey("depth");
         y(integer, con->depth);
     }
 
     y(map_close);
+#undef WANT
+}
+
+void dump_node(json_writer *gen, struct Con *con, bool inplace_restart) {
+    dump_con(gen, con, inplace_restart, &full_projection, 0);
+}
+
+/*
+ * Dumps the given container without its children, for the "container" of
+ * events like the window event.
+ *
+ */
+void dump_event_node(json_writer *gen, Con *con) {
+    dump_con(gen, con, false, &event_projection, 0);
+}
+
+/*
+ * The state of the parser for a GET_TREE request, see parse_tree_request().
+ *
+ */
+struct tree_request {
+    /* The top-level key whose value is being parsed (or NULL). */
+    const char *key;
+    int nesting;
+    const char *error;
+
+    long long root;
+    bool has_root;
+    struct tree_projection projection;
+};
+
+#if YAJL_MAJOR >= 2
+static int tree_request_map_key(void *ctx, const unsigned char *val, size_t len) {
+#else
+static int tree_request_map_key(void *ctx, const unsigned char *val, unsigned int len) {
+#endif
+    struct tree_request *request = ctx;
+    if (request->nesting != 1)
+        return 1;
+
+    static const char *keys[] = { "root", "max_depth", "fields" };
+    request->key = NULL;
+    for (size_t c = 0; c < sizeof(keys) / sizeof(keys[0]); c++) {
+        if (strlen(keys[c]) == len && strncasecmp(keys[c], (const char*)val, len) == 0) {
+            request->key = keys[c];
+            return 1;
+        }
+    }
+    request->error = "unknown key in GET_TREE request";
+    return 0;
+}
+
+#if YAJL_MAJOR >= 2
+static int tree_request_integer(void *ctx, long long val) {
+#else
+static int tree_request_integer(void *ctx, long val) {
+#endif
+    struct tree_request *request = ctx;
+    if (request->key == NULL || request->nesting != 1) {
+        request->error = "unexpected integer in GET_TREE request";
+        return 0;
+    }
+
+    if (strcmp(request->key, "root") == 0) {
+        request->root = val;
+        request->has_root = true;
+    } else if (strcmp(request->key, "max_depth") == 0 && val >= -1 && val <= INT_MAX) {
+        request->projection.max_depth = val;
+    } else {
+        request->error = "invalid integer in GET_TREE request";
+        return 0;
+    }
+    return 1;
+}
+
+#if YAJL_MAJOR >= 2
+static int tree_request_string(void *ctx, const unsigned char *val, size_t len) {
+#else
+static int tree_request_string(void *ctx, const unsigned char *val, unsigned int len) {
+#endif
+    struct tree_request *request = ctx;
+    if (request->key == NULL || strcmp(request->key, "fields") != 0 || request->nesting != 2) {
+        request->error = "unexpected string in GET_TREE request";
+        return 0;
+    }
+
+    for (int field = 0; field < TF_NUMBER_OF_FIELDS; field++) {
+        if (strlen(tree_field_names[field]) == len &&
+            strncmp(tree_field_names[field], (const char*)val, len) == 0) {
+            request->projection.fields |= (1 << field);
+            return 1;
+        }
+    }
+    request->error = "unknown field in GET_TREE request";
+    return 0;
+}
+
+static int tree_request_start(void *ctx) {
+    struct tree_request *request = ctx;
+    /* A list is only allowed as the value of "fields". */
+    if (request->nesting == 1 &&
+        (request->key == NULL || strcmp(request->key, "fields") != 0)) {
+        request->error = "unexpected list in GET_TREE request";
+        return 0;
+    }
+    if (request->nesting == 1)
+        request->projection.fields = 0;
+    request->nesting++;
+    return 1;
+}
+
+static int tree_request_start_map(void *ctx) {
+    struct tree_request *request = ctx;
+    if (request->nesting != 0) {
+        request->error = "unexpected map in GET_TREE request";
+        return 0;
+    }
+    request->nesting++;
+    return 1;
+}
+
+static int tree_request_end(void *ctx) {
+    struct tree_request *request = ctx;
+    request->nesting--;
+    request->key = NULL;
+    return 1;
 }
 
+/*
+ * Parses the (optional) JSON payload of a GET_TREE request, like
+ * {"root": 1234, "max_depth": 2, "fields": ["id", "name", "nodes"]}.
+ *
+ * Returns an error message if the request is invalid, NULL otherwise.
+ *
+ */
+static const char *parse_tree_request(struct tree_request *request, const uint8_t *message, uint32_t message_size) {
+    static yajl_callbacks callbacks = {
+        .yajl_integer = tree_request_integer,
+        .yajl_string = tree_request_string,
+        .yajl_start_map = tree_request_start_map,
+        .yajl_map_key = tree_request_map_key,
+        .yajl_end_map = tree_request_end,
+        .yajl_start_array = tree_request_start,
+        .yajl_end_array = tree_request_end,
+    };
+
+    yajl_handle handle = yalloc(&callbacks, request);
+    yajl_status stat = yajl_parse(handle, message, message_size);
+#if YAJL_MAJOR >= 2
+    if (stat == yajl_status_ok)
+        stat = yajl_complete_parse(handle);
+#endif
+    if (stat != yajl_status_ok && request->error == NULL)
+        request->error = "could not parse GET_TREE request";
+    yajl_free(handle);
+    return request->error;
+}
+
+/*
+ * Formats the reply message for a GET_TREE request and sends it to the
+ * client. Without a payload, the whole tree is dumped. Otherwise, the payload
+ * can select the root container, the maximum depth and the fields to dump.
+ *
+ */
 IPC_HANDLER(tree) {
-    setlocale(LC_NUMERIC, "C");
-    yajl_gen gen = ygenalloc();
-    dump_node(gen, croot, false);
-    setlocale(LC_NUMERIC, "");
+    struct tree_request request = {
+        .projection = full_projection
+    };
+    Con *root = croot;
+
+    if (message_size > 0 && parse_tree_request(&request, message, message_size) == NULL && request.has_root) {
+        Con *con;
+        root = NULL;
+        TAILQ_FOREACH(con, &all_cons, all_cons) {
+            if ((long int)con == request.root) {
+                root = con;
+                break;
+            }
+        }
+        if (root == NULL)
+            request.error = "no container with the given root id";
+    }
+
+    json_writer *gen = reply_writer();
+    if (request.error != NULL) {
+        ELOG("Invalid GET_TREE request: %s\n", request.error);
+        y(map_open);
+        ykey("success");
+        y(bool, false);
+        ykey("error");
+        ystr(request.error);
+        y(map_close);
+    } else {
+        dump_con(gen, root, false, &(request.projection), 0);
+    }
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_TREE, payload);
-    y(free);
 }
 
 
@@ -383,7 +958,7 @@ IPC_HANDLER(tree) {
  *
  */
 IPC_HANDLER(get_workspaces) {
-    yajl_gen gen = ygenalloc();
+    json_writer *gen = reply_writer();
     y(array_open);
 
     Con *focused_ws = con_get_workspace(focused);
@@ -397,36 +972,36 @@ IPC_HANDLER(get_workspaces) {
             assert(ws->type == CT_WORKSPACE);
             y(map_open);
 
-            ystr("num");
+            ykey("num");
             if (ws->num == -1)
                 y(null);
             else y(integer, ws->num);
 
-            ystr("name");
+            ykey("name");
             ystr(ws->name);
 
-            ystr("visible");
+            ykey("visible");
             y(bool, workspace_is_visible(ws));
 
-            ystr("focused");
+            ykey("focused");
             y(bool, ws == focused_ws);
 
-            ystr("rect");
+            ykey("rect");
             y(map_open);
-            ystr("x");
+            ykey("x");
             y(integer, ws->rect.x);
-            ystr("y");
+            ykey("y");
             y(integer, ws->rect.y);
-            ystr("width");
+            ykey("width");
             y(integer, ws->rect.width);
-            ystr("height");
+            ykey("height");
             y(integer, ws->rect.height);
             y(map_close);
 
-            ystr("output");
+            ykey("output");
             ystr(output->name);
 
-            ystr("urgent");
+            ykey("urgent");
             y(bool, ws->urgent);
 
             y(map_close);
@@ -436,11 +1011,10 @@ IPC_HANDLER(get_workspaces) {
     y(array_close);
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_WORKSPACES, payload);
-    y(free);
 }
 
 /*
@@ -449,35 +1023,35 @@ IPC_HANDLER(get_workspaces) {
  *
  */
 IPC_HANDLER(get_outputs) {
-    yajl_gen gen = ygenalloc();
+    json_writer *gen = reply_writer();
     y(array_open);
 
     Output *output;
     TAILQ_FOREACH(output, &outputs, outputs) {
         y(map_open);
 
-        ystr("name");
+        ykey("name");
         ystr(output->name);
 
-        ystr("active");
+        ykey("active");
         y(bool, output->active);
 
-        ystr("primary");
+        ykey("primary");
         y(bool, output->primary);
 
-        ystr("rect");
+        ykey("rect");
         y(map_open);
-        ystr("x");
+        ykey("x");
         y(integer, output->rect.x);
-        ystr("y");
+        ykey("y");
         y(integer, output->rect.y);
-        ystr("width");
+        ykey("width");
         y(integer, output->rect.width);
-        ystr("height");
+        ykey("height");
         y(integer, output->rect.height);
         y(map_close);
 
-        ystr("current_workspace");
+        ykey("current_workspace");
         Con *ws = NULL;
         if (output->con && (ws = con_get_fullscreen_con(output->con, CF_OUTPUT)))
             ystr(ws->name);
@@ -489,11 +1063,10 @@ IPC_HANDLER(get_outputs) {
     y(array_close);
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_OUTPUTS, payload);
-    y(free);
 }
 
 /*
@@ -502,7 +1075,7 @@ IPC_HANDLER(get_outputs) {
  *
  */
 IPC_HANDLER(get_marks) {
-    yajl_gen gen = ygenalloc();
+    json_writer *gen = reply_writer();
     y(array_open);
 
     Con *con;
@@ -513,11 +1086,10 @@ IPC_HANDLER(get_marks) {
     y(array_close);
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_MARKS, payload);
-    y(free);
 }
 
 /*
@@ -525,29 +1097,64 @@ IPC_HANDLER(get_marks) {
  *
  */
 IPC_HANDLER(get_version) {
-    yajl_gen gen = ygenalloc();
+    json_writer *gen = reply_writer();
     y(map_open);
 
-    ystr("major");
+    ykey("major");
     y(integer, MAJOR_VERSION);
 
-    ystr("minor");
+    ykey("minor");
     y(integer, MINOR_VERSION);
 
-    ystr("patch");
+    ykey("patch");
     y(integer, PATCH_VERSION);
 
-    ystr("human_readable");
+    ykey("human_readable");
     ystr(I3_VERSION);
 
     y(map_close);
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_VERSION, payload);
-    y(free);
+}
+
+/*
+ * Formats the reply message for a GET_STATS request (internal statistics of
+ * i3: the slab pools, latency histograms and X11 request accounting) and sends
+ * it to the client. If the payload is "reset", the latency histograms and X11
+ * statistics are emptied after the reply was generated.
+ *
+ */
+IPC_HANDLER(get_stats) {
+    json_writer *gen = reply_writer();
+    y(map_open);
+
+    ykey("allocators");
+    pool_dump_stats(gen);
+
+    ykey("latency");
+    latency_dump_stats(gen);
+
+    ykey("x11");
+    x_stats_dump(gen);
+
+    y(map_close);
+
+    const unsigned char *payload;
+    size_t length;
+    y(get_buf, &payload, &length);
+
+    ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_STATS, payload);
+
+    if (message_size == strlen("reset") &&
+        strncmp((const char*)message, "reset", message_size) == 0) {
+        DLOG("Resetting the latency and X11 statistics\n");
+        latency_reset_stats();
+        x_stats_reset();
+    }
 }
 
 /*
@@ -556,7 +1163,7 @@ IPC_HANDLER(get_version) {
  *
  */
 IPC_HANDLER(get_bar_config) {
-    yajl_gen gen = ygenalloc();
+    json_writer *gen = reply_writer();
 
     /* If no ID was passed, we return a JSON array with all IDs */
     if (message_size == 0) {
@@ -568,11 +1175,10 @@ IPC_HANDLER(get_bar_config) {
         y(array_close);
 
         const unsigned char *payload;
-        ylength length;
+        size_t length;
         y(get_buf, &payload, &length);
 
         ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_BAR_CONFIG, payload);
-        y(free);
         return;
     }
 
@@ -663,6 +1269,9 @@ IPC_HANDLER(get_bar_config) {
         YSTR_IF_SET(status_command);
         YSTR_IF_SET(font);
 
+        ystr("status_interval");
+        y(integer, config->status_interval);
+
         ystr("workspace_buttons");
         y(bool, !config->hide_workspace_buttons);
 
@@ -703,11 +1312,10 @@ IPC_HANDLER(get_bar_config) {
     y(map_close);
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_message(fd, length, I3_IPC_REPLY_TYPE_BAR_CONFIG, payload);
-    y(free);
 }
 
 /*
@@ -786,7 +1394,7 @@ IPC_HANDLER(subscribe) {
 
 /* The index of each callback function corresponds to the numeric
  * value of the message type (see include/i3/ipc.h) */
-handler_t handlers[8] = {
+handler_t handlers[10] = {
     handle_command,
     handle_get_workspaces,
     handle_subscribe,
@@ -795,6 +1403,8 @@ handler_t handlers[8] = {
     handle_get_marks,
     handle_get_bar_config,
     handle_get_version,
+    handle_get_stats,
+    handle_command_batch,
 };
 
 /*
@@ -849,7 +1459,9 @@ static void ipc_receive_message(EV_P_ struct ev_io *w, int revents) {
         DLOG("Unhandled message type: %d\n", message_type);
     else {
         handler_t h = handlers[message_type];
+        const uint64_t start = latency_now();
         h(w->fd, message, 0, message_length, message_type);
+        latency_record_ipc(message_type, start);
     }
 }
 
@@ -122,16 +122,15 @@ void handle_key_press(xcb_key_press_event_t *event) {
     /* We parse the JSON reply to figure out whether there was an error
      * ("success" being false in on of the returned dictionaries). */
     const unsigned char *reply;
-#if YAJL_MAJOR >= 2
     size_t length;
+#if YAJL_MAJOR >= 2
     yajl_handle handle = yajl_alloc(&command_error_callbacks, NULL, NULL);
 #else
-    unsigned int length;
     yajl_parser_config parse_conf = { 0, 0 };
 
     yajl_handle handle = yajl_alloc(&command_error_callbacks, &parse_conf, NULL, NULL);
 #endif
-    yajl_gen_get_buf(command_output->json_gen, &reply, &length);
+    json_writer_get_buf(command_output->json_gen, &reply, &length);
 
     current_nesting_level = 0;
     parse_error_key = false;
@@ -162,6 +161,4 @@ void handle_key_press(xcb_key_press_event_t *event) {
     }
 
     yajl_free(handle);
-
-    yajl_gen_free(command_output->json_gen);
 }
@@ -0,0 +1,160 @@
+#undef I3__FILE__
+#define I3__FILE__ "latency.c"
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * latency.c: Latency histograms of the main pipeline stages (rendering, event
+ *            handling, IPC), reported by GET_STATS.
+ *
+ */
+#include "all.h"
+#include "json_utils.h"
+
+latency_histogram latency_stages[LATENCY_STAGES] = {
+    [LATENCY_PARSE_COMMAND] = { .name = "parse_command" },
+    [LATENCY_RENDER_CON] = { .name = "render_con" },
+    [LATENCY_X_PUSH_CHANGES] = { .name = "x_push_changes" },
+    [LATENCY_X_DECO_RECURSE] = { .name = "x_deco_recurse" },
+    [LATENCY_MANAGE_WINDOW] = { .name = "manage_window" },
+};
+
+/* One histogram per event type (without the "generated" bit), named when the
+ * statistics are generated (extension events have dynamic types). */
+static latency_histogram event_latency[128];
+
+static const char *core_event_names[] = {
+    [XCB_KEY_PRESS] = "KeyPress",
+    [XCB_KEY_RELEASE] = "KeyRelease",
+    [XCB_BUTTON_PRESS] = "ButtonPress",
+    [XCB_BUTTON_RELEASE] = "ButtonRelease",
+    [XCB_MOTION_NOTIFY] = "MotionNotify",
+    [XCB_ENTER_NOTIFY] = "EnterNotify",
+    [XCB_LEAVE_NOTIFY] = "LeaveNotify",
+    [XCB_FOCUS_IN] = "FocusIn",
+    [XCB_FOCUS_OUT] = "FocusOut",
+    [XCB_KEYMAP_NOTIFY] = "KeymapNotify",
+    [XCB_EXPOSE] = "Expose",
+    [XCB_GRAPHICS_EXPOSURE] = "GraphicsExposure",
+    [XCB_NO_EXPOSURE] = "NoExposure",
+    [XCB_VISIBILITY_NOTIFY] = "VisibilityNotify",
+    [XCB_CREATE_NOTIFY] = "CreateNotify",
+    [XCB_DESTROY_NOTIFY] = "DestroyNotify",
+    [XCB_UNMAP_NOTIFY] = "UnmapNotify",
+    [XCB_MAP_NOTIFY] = "MapNotify",
+    [XCB_MAP_REQUEST] = "MapRequest",
+    [XCB_REPARENT_NOTIFY] = "ReparentNotify",
+    [XCB_CONFIGURE_NOTIFY] = "ConfigureNotify",
+    [XCB_CONFIGURE_REQUEST] = "ConfigureRequest",
+    [XCB_GRAVITY_NOTIFY] = "GravityNotify",
+    [XCB_RESIZE_REQUEST] = "ResizeRequest",
+    [XCB_CIRCULATE_NOTIFY] = "CirculateNotify",
+    [XCB_CIRCULATE_REQUEST] = "CirculateRequest",
+    [XCB_PROPERTY_NOTIFY] = "PropertyNotify",
+    [XCB_SELECTION_CLEAR] = "SelectionClear",
+    [XCB_SELECTION_REQUEST] = "SelectionRequest",
+    [XCB_SELECTION_NOTIFY] = "SelectionNotify",
+    [XCB_COLORMAP_NOTIFY] = "ColormapNotify",
+    [XCB_CLIENT_MESSAGE] = "ClientMessage",
+    [XCB_MAPPING_NOTIFY] = "MappingNotify",
+};
+
+/* The index corresponds to the numeric value of the message type (see
+ * include/i3/ipc.h), just like the handlers in ipc.c. */
+static latency_histogram ipc_latency[] = {
+    { .name = "command" },
+    { .name = "get_workspaces" },
+    { .name = "subscribe" },
+    { .name = "get_outputs" },
+    { .name = "get_tree" },
+    { .name = "get_marks" },
+    { .name = "get_bar_config" },
+    { .name = "get_version" },
+    { .name = "get_stats" },
+    { .name = "command_batch" },
+};
+
+#define NUM_IPC_TYPES (sizeof(ipc_latency) / sizeof(latency_histogram))
+
+/*
+ * Records how long handle_event() took for an X11 event of the given type.
+ *
+ */
+void latency_record_event(int type, uint64_t start) {
+    latency_record(&event_latency[type & 0x7F], start);
+}
+
+/*
+ * Records how long the IPC handler for the given message type took.
+ *
+ */
+void latency_record_ipc(uint32_t message_type, uint64_t start) {
+    if (message_type < NUM_IPC_TYPES)
+        latency_record(&ipc_latency[message_type], start);
+}
+
+/*
+ * Returns the name of the given X11 event type (without the "generated" bit),
+ * like "MapRequest". Unknown (extension) events are formatted into buffer.
+ *
+ */
+const char *event_type_name(int type, char *buffer, size_t size) {
+    if (type < (int)(sizeof(core_event_names) / sizeof(char*)) && core_event_names[type] != NULL)
+        return core_event_names[type];
+    if (randr_base > -1 && type == randr_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY)
+        return "RandrScreenChangeNotify";
+    snprintf(buffer, size, "event_%d", type);
+    return buffer;
+}
+
+/*
+ * Generates the latency statistics as a JSON map with the keys "stages",
+ * "events" and "ipc".
+ *
+ */
+void latency_dump_stats(json_writer *gen) {
+    y(map_open);
+
+    ykey("stages");
+    y(array_open);
+    for (int i = 0; i < LATENCY_STAGES; i++)
+        latency_dump(gen, &latency_stages[i], NULL);
+    y(array_close);
+
+    /* Events and IPC messages which did not occur are left out, most of
+     * them never will. */
+    ykey("events");
+    y(array_open);
+    for (int type = 0; type < 128; type++) {
+        if (event_latency[type].count == 0)
+            continue;
+        char buffer[32];
+        latency_dump(gen, &event_latency[type], event_type_name(type, buffer, sizeof(buffer)));
+    }
+    y(array_close);
+
+    ykey("ipc");
+    y(array_open);
+    for (size_t i = 0; i < NUM_IPC_TYPES; i++) {
+        if (ipc_latency[i].count > 0)
+            latency_dump(gen, &ipc_latency[i], NULL);
+    }
+    y(array_close);
+
+    y(map_close);
+}
+
+/*
+ * Empties all histograms.
+ *
+ */
+void latency_reset_stats(void) {
+    for (int i = 0; i < LATENCY_STAGES; i++)
+        latency_reset(&latency_stages[i]);
+    for (int type = 0; type < 128; type++)
+        latency_reset(&event_latency[type]);
+    for (size_t i = 0; i < NUM_IPC_TYPES; i++)
+        latency_reset(&ipc_latency[i]);
+}
@@ -12,14 +12,140 @@
  */
 #include "all.h"
 
+#include <ctype.h>
+
 #include <yajl/yajl_common.h>
 #include <yajl/yajl_gen.h>
 #include <yajl/yajl_parse.h>
 #include <yajl/yajl_version.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+
 /* TODO: refactor the whole parsing thing */
 
-static char *last_key;
+/* All the keys the loader knows about. Keys are resolved once (in json_key())
+ * instead of being compared by name for every value. */
+enum json_key {
+    JK_UNKNOWN = 0,
+    JK_SWALLOWS,
+    JK_RECT,
+    JK_WINDOW_RECT,
+    JK_GEOMETRY,
+    JK_FOCUS,
+    JK_CLASS,
+    JK_NAME,
+    JK_STICKY_GROUP,
+    JK_ORIENTATION,
+    JK_BORDER,
+    JK_LAYOUT,
+    JK_WORKSPACE_LAYOUT,
+    JK_LAST_SPLIT_LAYOUT,
+    JK_MARK,
+    JK_FLOATING,
+    JK_SCRATCHPAD_STATE,
+    JK_TYPE,
+    JK_FULLSCREEN_MODE,
+    JK_NUM,
+    JK_CURRENT_BORDER_WIDTH,
+    JK_DEPTH,
+    JK_ID,
+    JK_X,
+    JK_Y,
+    JK_WIDTH,
+    JK_HEIGHT,
+    JK_DOCK,
+    JK_INSERT_WHERE,
+    JK_FOCUSED,
+    JK_RESTART_MODE,
+    JK_PERCENT,
+    JK_FLOATING_NODES,
+    JK_MAX
+};
+
+static const char *json_key_names[JK_MAX] = {
+    [JK_UNKNOWN] = "(unknown)",
+    [JK_SWALLOWS] = "swallows",
+    [JK_RECT] = "rect",
+    [JK_WINDOW_RECT] = "window_rect",
+    [JK_GEOMETRY] = "geometry",
+    [JK_FOCUS] = "focus",
+    [JK_CLASS] = "class",
+    [JK_NAME] = "name",
+    [JK_STICKY_GROUP] = "sticky_group",
+    [JK_ORIENTATION] = "orientation",
+    [JK_BORDER] = "border",
+    [JK_LAYOUT] = "layout",
+    [JK_WORKSPACE_LAYOUT] = "workspace_layout",
+    [JK_LAST_SPLIT_LAYOUT] = "last_split_layout",
+    [JK_MARK] = "mark",
+    [JK_FLOATING] = "floating",
+    [JK_SCRATCHPAD_STATE] = "scratchpad_state",
+    [JK_TYPE] = "type",
+    [JK_FULLSCREEN_MODE] = "fullscreen_mode",
+    [JK_NUM] = "num",
+    [JK_CURRENT_BORDER_WIDTH] = "current_border_width",
+    [JK_DEPTH] = "depth",
+    [JK_ID] = "id",
+    [JK_X] = "x",
+    [JK_Y] = "y",
+    [JK_WIDTH] = "width",
+    [JK_HEIGHT] = "height",
+    [JK_DOCK] = "dock",
+    [JK_INSERT_WHERE] = "insert_where",
+    [JK_FOCUSED] = "focused",
+    [JK_RESTART_MODE] = "restart_mode",
+    [JK_PERCENT] = "percent",
+    [JK_FLOATING_NODES] = "floating_nodes",
+};
+
+/* The hash function below is perfect (collision-free) for the keys above, so
+ * every key is found with a single comparison. It only looks at the length and
+ * the (case-folded) first and last character of the key. When adding keys,
+ * json_key_table_init() asserts that this still holds. */
+#define JSON_KEY_TABLE_SIZE 64
+#define JSON_KEY_HASH(len, first, last) \
+    ((((len) * 41) + tolower(first) + (tolower(last) * 8)) & (JSON_KEY_TABLE_SIZE - 1))
+
+static uint8_t json_key_table[JSON_KEY_TABLE_SIZE];
+
+static void json_key_table_init(void) {
+    static bool initialized = false;
+    if (initialized)
+        return;
+
+    for (int key = JK_UNKNOWN + 1; key < JK_MAX; key++) {
+        const char *name = json_key_names[key];
+        const size_t len = strlen(name);
+        const int hash = JSON_KEY_HASH(len, name[0], name[len - 1]);
+        assert(json_key_table[hash] == JK_UNKNOWN);
+        json_key_table[hash] = key;
+    }
+    initialized = true;
+}
+
+static enum json_key json_key_lookup(const unsigned char *val, size_t len) {
+    if (len == 0)
+        return JK_UNKNOWN;
+
+    const enum json_key key = json_key_table[JSON_KEY_HASH(len, val[0], val[len - 1])];
+    const char *name = json_key_names[key];
+    if (key == JK_UNKNOWN || strlen(name) != len ||
+        strncasecmp((const char *)val, name, len) != 0)
+        return JK_UNKNOWN;
+    return key;
+}
+
+/*
+ * Returns true if the (not NUL-terminated) JSON value equals the given
+ * string, ignoring case.
+ *
+ */
+static bool json_value_is(const unsigned char *val, size_t len, const char *str) {
+    return (strlen(str) == len && strncasecmp((const char *)val, str, len) == 0);
+}
+
+static enum json_key last_key;
 static Con *json_node;
 static Con *to_focus;
 static bool parsing_swallows;
@@ -40,7 +166,7 @@ static TAILQ_HEAD(focus_mappings_head, focus_mapping) focus_mappings =
   TAILQ_HEAD_INITIALIZER(focus_mappings);
 
 static int json_start_map(void *ctx) {
-    LOG("start of map, last_key = %s\n", last_key);
+    DLOG("start of map, last_key = %s\n", json_key_names[last_key]);
     if (parsing_swallows) {
         LOG("creating new swallow\n");
         current_swallow = smalloc(sizeof(Match));
@@ -48,7 +174,7 @@ static int json_start_map(void *ctx) {
         TAILQ_INSERT_TAIL(&(json_node->swallow_head), current_swallow, matches);
     } else {
         if (!parsing_rect && !parsing_window_rect && !parsing_geometry) {
-            if (last_key && strcasecmp(last_key, "floating_nodes") == 0) {
+            if (last_key == JK_FLOATING_NODES) {
                 DLOG("New floating_node\n");
                 Con *ws = con_get_workspace(json_node);
                 json_node = con_new_skeleton(NULL, NULL);
@@ -65,11 +191,11 @@ static int json_start_map(void *ctx) {
 }
 
 static int json_end_map(void *ctx) {
-    LOG("end of map\n");
+    DLOG("end of map\n");
     if (!parsing_swallows && !parsing_rect && !parsing_window_rect && !parsing_geometry) {
-        LOG("attaching\n");
+        DLOG("attaching\n");
         con_attach(json_node, json_node->parent, true);
-        LOG("Creating window\n");
+        DLOG("Creating window\n");
         x_con_init(json_node, json_node->depth);
         json_node = json_node->parent;
     }
@@ -83,18 +209,18 @@ static int json_end_map(void *ctx) {
 }
 
 static int json_end_array(void *ctx) {
-    LOG("end of array\n");
+    DLOG("end of array\n");
     parsing_swallows = false;
     if (parsing_focus) {
         /* Clear the list of focus mappings */
         struct focus_mapping *mapping;
         TAILQ_FOREACH_REVERSE(mapping, &focus_mappings, focus_mappings_head, focus_mappings) {
-            LOG("focus (reverse) %d\n", mapping->old_id);
+            DLOG("focus (reverse) %d\n", mapping->old_id);
             Con *con;
             TAILQ_FOREACH(con, &(json_node->focus_head), focused) {
                 if (con->old_id != mapping->old_id)
                     continue;
-                LOG("got it! %p\n", con);
+                DLOG("got it! %p\n", con);
                 /* Move this entry to the top of the focus list. */
                 TAILQ_REMOVE(&(json_node->focus_head), con, focused);
                 TAILQ_INSERT_HEAD(&(json_node->focus_head), con, focused);
@@ -116,24 +242,27 @@ static int json_key(void *ctx, const unsigned char *val, unsigned int len) {
 #else
 static int json_key(void *ctx, const unsigned char *val, size_t len) {
 #endif
-    LOG("key: %.*s\n", (int)len, val);
-    FREE(last_key);
-    last_key = scalloc((len+1) * sizeof(char));
-    memcpy(last_key, val, len);
-    if (strcasecmp(last_key, "swallows") == 0)
-        parsing_swallows = true;
-
-    if (strcasecmp(last_key, "rect") == 0)
-        parsing_rect = true;
-
-    if (strcasecmp(last_key, "window_rect") == 0)
-        parsing_window_rect = true;
-
-    if (strcasecmp(last_key, "geometry") == 0)
-        parsing_geometry = true;
-
-    if (strcasecmp(last_key, "focus") == 0)
-        parsing_focus = true;
+    DLOG("key: %.*s\n", (int)len, val);
+    last_key = json_key_lookup(val, len);
+    switch (last_key) {
+        case JK_SWALLOWS:
+            parsing_swallows = true;
+            break;
+        case JK_RECT:
+            parsing_rect = true;
+            break;
+        case JK_WINDOW_RECT:
+            parsing_window_rect = true;
+            break;
+        case JK_GEOMETRY:
+            parsing_geometry = true;
+            break;
+        case JK_FOCUS:
+            parsing_focus = true;
+            break;
+        default:
+            break;
+    }
 
     return 1;
 }
@@ -143,148 +272,123 @@ static int json_string(void *ctx, const unsigned char *val, size_t len) {
 #else
 static int json_string(void *ctx, const unsigned char *val, unsigned int len) {
 #endif
-    LOG("string: %.*s for key %s\n", (int)len, val, last_key);
+    DLOG("string: %.*s for key %s\n", (int)len, val, json_key_names[last_key]);
     if (parsing_swallows) {
         /* TODO: the other swallowing keys */
-        if (strcasecmp(last_key, "class") == 0) {
+        if (last_key == JK_CLASS) {
             current_swallow->class = scalloc((len+1) * sizeof(char));
             memcpy(current_swallow->class, val, len);
         }
         LOG("unhandled yet: swallow\n");
-    } else {
-        if (strcasecmp(last_key, "name") == 0) {
+        return 1;
+    }
+
+    switch (last_key) {
+        case JK_NAME:
+            FREE(json_node->name);
             json_node->name = scalloc((len+1) * sizeof(char));
             memcpy(json_node->name, val, len);
-        } else if (strcasecmp(last_key, "sticky_group") == 0) {
+            break;
+        case JK_STICKY_GROUP:
             json_node->sticky_group = scalloc((len+1) * sizeof(char));
             memcpy(json_node->sticky_group, val, len);
             LOG("sticky_group of this container is %s\n", json_node->sticky_group);
-        } else if (strcasecmp(last_key, "orientation") == 0) {
+            break;
+        case JK_ORIENTATION:
             /* Upgrade path from older versions of i3 (doing an inplace restart
              * to a newer version):
              * "orientation" is dumped before "layout". Therefore, we store
              * whether the orientation was horizontal or vertical in the
              * last_split_layout. When we then encounter layout == "default",
              * we will use the last_split_layout as layout instead. */
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            if (strcasecmp(buf, "none") == 0 ||
-                strcasecmp(buf, "horizontal") == 0)
+            if (json_value_is(val, len, "none") ||
+                json_value_is(val, len, "horizontal"))
                 json_node->last_split_layout = L_SPLITH;
-            else if (strcasecmp(buf, "vertical") == 0)
+            else if (json_value_is(val, len, "vertical"))
                 json_node->last_split_layout = L_SPLITV;
-            else LOG("Unhandled orientation: %s\n", buf);
-            free(buf);
-        } else if (strcasecmp(last_key, "border") == 0) {
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            if (strcasecmp(buf, "none") == 0)
+            else LOG("Unhandled orientation: %.*s\n", (int)len, val);
+            break;
+        case JK_BORDER:
+            if (json_value_is(val, len, "none"))
                 json_node->border_style = BS_NONE;
-            else if (strcasecmp(buf, "1pixel") == 0) {
+            else if (json_value_is(val, len, "1pixel")) {
                 json_node->border_style = BS_PIXEL;
                 json_node->current_border_width = 1;
-            } else if (strcasecmp(buf, "pixel") == 0)
+            } else if (json_value_is(val, len, "pixel"))
                 json_node->border_style = BS_PIXEL;
-            else if (strcasecmp(buf, "normal") == 0)
+            else if (json_value_is(val, len, "normal"))
                 json_node->border_style = BS_NORMAL;
-            else LOG("Unhandled \"border\": %s\n", buf);
-            free(buf);
-        } else if (strcasecmp(last_key, "layout") == 0) {
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            if (strcasecmp(buf, "default") == 0)
+            else LOG("Unhandled \"border\": %.*s\n", (int)len, val);
+            break;
+        case JK_LAYOUT:
+            if (json_value_is(val, len, "default"))
                 /* This set above when we read "orientation". */
                 json_node->layout = json_node->last_split_layout;
-            else if (strcasecmp(buf, "stacked") == 0)
+            else if (json_value_is(val, len, "stacked"))
                 json_node->layout = L_STACKED;
-            else if (strcasecmp(buf, "tabbed") == 0)
+            else if (json_value_is(val, len, "tabbed"))
                 json_node->layout = L_TABBED;
-            else if (strcasecmp(buf, "dockarea") == 0)
+            else if (json_value_is(val, len, "dockarea"))
                 json_node->layout = L_DOCKAREA;
-            else if (strcasecmp(buf, "output") == 0)
+            else if (json_value_is(val, len, "output"))
                 json_node->layout = L_OUTPUT;
-            else if (strcasecmp(buf, "splith") == 0)
+            else if (json_value_is(val, len, "splith"))
                 json_node->layout = L_SPLITH;
-            else if (strcasecmp(buf, "splitv") == 0)
+            else if (json_value_is(val, len, "splitv"))
                 json_node->layout = L_SPLITV;
-            else LOG("Unhandled \"layout\": %s\n", buf);
-            free(buf);
-        } else if (strcasecmp(last_key, "workspace_layout") == 0) {
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            if (strcasecmp(buf, "default") == 0)
+            else LOG("Unhandled \"layout\": %.*s\n", (int)len, val);
+            break;
+        case JK_WORKSPACE_LAYOUT:
+            if (json_value_is(val, len, "default"))
                 json_node->workspace_layout = L_DEFAULT;
-            else if (strcasecmp(buf, "stacked") == 0)
+            else if (json_value_is(val, len, "stacked"))
                 json_node->workspace_layout = L_STACKED;
-            else if (strcasecmp(buf, "tabbed") == 0)
+            else if (json_value_is(val, len, "tabbed"))
                 json_node->workspace_layout = L_TABBED;
-            else LOG("Unhandled \"workspace_layout\": %s\n", buf);
-            free(buf);
-        } else if (strcasecmp(last_key, "last_split_layout") == 0) {
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            if (strcasecmp(buf, "splith") == 0)
+            else LOG("Unhandled \"workspace_layout\": %.*s\n", (int)len, val);
+            break;
+        case JK_LAST_SPLIT_LAYOUT:
+            if (json_value_is(val, len, "splith"))
                 json_node->last_split_layout = L_SPLITH;
-            else if (strcasecmp(buf, "splitv") == 0)
+            else if (json_value_is(val, len, "splitv"))
                 json_node->last_split_layout = L_SPLITV;
-            else LOG("Unhandled \"last_splitlayout\": %s\n", buf);
-            free(buf);
-        } else if (strcasecmp(last_key, "mark") == 0) {
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            json_node->mark = buf;
-        } else if (strcasecmp(last_key, "floating") == 0) {
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            if (strcasecmp(buf, "auto_off") == 0)
+            else LOG("Unhandled \"last_splitlayout\": %.*s\n", (int)len, val);
+            break;
+        case JK_MARK:
+            json_node->mark = scalloc((len+1) * sizeof(char));
+            memcpy(json_node->mark, val, len);
+            break;
+        case JK_FLOATING:
+            if (json_value_is(val, len, "auto_off"))
                 json_node->floating = FLOATING_AUTO_OFF;
-            else if (strcasecmp(buf, "auto_on") == 0)
+            else if (json_value_is(val, len, "auto_on"))
                 json_node->floating = FLOATING_AUTO_ON;
-            else if (strcasecmp(buf, "user_off") == 0)
+            else if (json_value_is(val, len, "user_off"))
                 json_node->floating = FLOATING_USER_OFF;
-            else if (strcasecmp(buf, "user_on") == 0)
+            else if (json_value_is(val, len, "user_on"))
                 json_node->floating = FLOATING_USER_ON;
-            free(buf);
-        } else if (strcasecmp(last_key, "scratchpad_state") == 0) {
-            char *buf = NULL;
-            sasprintf(&buf, "%.*s", (int)len, val);
-            if (strcasecmp(buf, "none") == 0)
+            break;
+        case JK_SCRATCHPAD_STATE:
+            if (json_value_is(val, len, "none"))
                 json_node->scratchpad_state = SCRATCHPAD_NONE;
-            else if (strcasecmp(buf, "fresh") == 0)
+            else if (json_value_is(val, len, "fresh"))
                 json_node->scratchpad_state = SCRATCHPAD_FRESH;
-            else if (strcasecmp(buf, "changed") == 0)
+            else if (json_value_is(val, len, "changed"))
                 json_node->scratchpad_state = SCRATCHPAD_CHANGED;
-            free(buf);
-        }
+            break;
+        default:
+            break;
     }
     return 1;
 }
 
 #if YAJL_MAJOR >= 2
 static int json_int(void *ctx, long long val) {
-    LOG("int %lld for key %s\n", val, last_key);
+    DLOG("int %lld for key %s\n", val, json_key_names[last_key]);
 #else
 static int json_int(void *ctx, long val) {
-    LOG("int %ld for key %s\n", val, last_key);
+    DLOG("int %ld for key %s\n", val, json_key_names[last_key]);
 #endif
-    if (strcasecmp(last_key, "type") == 0)
-        json_node->type = val;
-
-    if (strcasecmp(last_key, "fullscreen_mode") == 0)
-        json_node->fullscreen_mode = val;
-
-    if (strcasecmp(last_key, "num") == 0)
-        json_node->num = val;
-
-    if (strcasecmp(last_key, "current_border_width") == 0)
-        json_node->current_border_width = val;
-
-    if (strcasecmp(last_key, "depth") == 0)
-        json_node->depth = val;
-
-    if (!parsing_swallows && strcasecmp(last_key, "id") == 0)
-        json_node->old_id = val;
-
     if (parsing_focus) {
         struct focus_mapping *focus_mapping = scalloc(sizeof(struct focus_mapping));
         focus_mapping->old_id = val;
@@ -298,41 +402,63 @@ static int json_int(void *ctx, long val) {
         else if (parsing_window_rect)
             r = &(json_node->window_rect);
         else r = &(json_node->geometry);
-        if (strcasecmp(last_key, "x") == 0)
+        if (last_key == JK_X)
             r->x = val;
-        else if (strcasecmp(last_key, "y") == 0)
+        else if (last_key == JK_Y)
             r->y = val;
-        else if (strcasecmp(last_key, "width") == 0)
+        else if (last_key == JK_WIDTH)
             r->width = val;
-        else if (strcasecmp(last_key, "height") == 0)
+        else if (last_key == JK_HEIGHT)
             r->height = val;
-        else printf("WARNING: unknown key %s in rect\n", last_key);
-        printf("rect now: (%d, %d, %d, %d)\n",
-                r->x, r->y, r->width, r->height);
+        else ELOG("WARNING: unknown key %s in rect\n", json_key_names[last_key]);
+        DLOG("rect now: (%d, %d, %d, %d)\n",
+             r->x, r->y, r->width, r->height);
     }
+
     if (parsing_swallows) {
-        if (strcasecmp(last_key, "id") == 0) {
+        if (last_key == JK_ID)
             current_swallow->id = val;
-        }
-        if (strcasecmp(last_key, "dock") == 0) {
+        else if (last_key == JK_DOCK)
             current_swallow->dock = val;
-        }
-        if (strcasecmp(last_key, "insert_where") == 0) {
+        else if (last_key == JK_INSERT_WHERE)
             current_swallow->insert_where = val;
-        }
+        return 1;
+    }
+
+    switch (last_key) {
+        case JK_TYPE:
+            json_node->type = val;
+            break;
+        case JK_FULLSCREEN_MODE:
+            json_node->fullscreen_mode = val;
+            break;
+        case JK_NUM:
+            json_node->num = val;
+            break;
+        case JK_CURRENT_BORDER_WIDTH:
+            json_node->current_border_width = val;
+            break;
+        case JK_DEPTH:
+            json_node->depth = val;
+            break;
+        case JK_ID:
+            json_node->old_id = val;
+            break;
+        default:
+            break;
     }
 
     return 1;
 }
 
 static int json_bool(void *ctx, int val) {
-    LOG("bool %d for key %s\n", val, last_key);
-    if (strcasecmp(last_key, "focused") == 0 && val) {
+    DLOG("bool %d for key %s\n", val, json_key_names[last_key]);
+    if (last_key == JK_FOCUSED && val) {
         to_focus = json_node;
     }
 
     if (parsing_swallows) {
-        if (strcasecmp(last_key, "restart_mode") == 0)
+        if (last_key == JK_RESTART_MODE)
             current_swallow->restart_mode = val;
     }
 
@@ -340,8 +466,8 @@ static int json_bool(void *ctx, int val) {
 }
 
 static int json_double(void *ctx, double val) {
-    LOG("double %f for key %s\n", val, last_key);
-    if (strcasecmp(last_key, "percent") == 0) {
+    DLOG("double %f for key %s\n", val, json_key_names[last_key]);
+    if (last_key == JK_PERCENT) {
         json_node->percent = val;
     }
     return 1;
@@ -349,26 +475,34 @@ static int json_double(void *ctx, double val) {
 
 void tree_append_json(const char *filename) {
     /* TODO: percent of other windows are not correctly fixed at the moment */
-    FILE *f;
-    if ((f = fopen(filename, "r")) == NULL) {
+    int fd;
+    if ((fd = open(filename, O_RDONLY)) == -1) {
         LOG("Cannot open file \"%s\"\n", filename);
         return;
     }
     struct stat stbuf;
-    if (fstat(fileno(f), &stbuf) != 0) {
+    if (fstat(fd, &stbuf) != 0) {
         LOG("Cannot fstat() the file\n");
-        fclose(f);
+        close(fd);
+        return;
+    }
+    if (stbuf.st_size == 0) {
+        LOG("File \"%s\" is empty, not loading.\n", filename);
+        close(fd);
         return;
     }
-    char *buf = smalloc(stbuf.st_size);
-    int n = fread(buf, 1, stbuf.st_size, f);
-    if (n != stbuf.st_size) {
-        LOG("File \"%s\" could not be read entirely, not loading.\n", filename);
-        fclose(f);
+    /* Map the file instead of copying it into a buffer: the parser only reads
+     * it once, from start to end. */
+    const size_t n = stbuf.st_size;
+    unsigned char *buf = mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (buf == MAP_FAILED) {
+        LOG("File \"%s\" could not be mapped, not loading: %s\n", filename, strerror(errno));
+        close(fd);
         return;
     }
-    LOG("read %d bytes\n", n);
-    yajl_gen g;
+    madvise(buf, n, MADV_SEQUENTIAL);
+    LOG("mapped %zu bytes\n", n);
+    json_key_table_init();
     yajl_handle hand;
     yajl_callbacks callbacks;
     memset(&callbacks, '\0', sizeof(yajl_callbacks));
@@ -381,35 +515,36 @@ void tree_append_json(const char *filename) {
     callbacks.yajl_double = json_double;
     callbacks.yajl_boolean = json_bool;
 #if YAJL_MAJOR >= 2
-    g = yajl_gen_alloc(NULL);
-    hand = yajl_alloc(&callbacks, NULL, (void*)g);
+    hand = yajl_alloc(&callbacks, NULL, NULL);
 #else
-    g = yajl_gen_alloc(NULL, NULL);
-    hand = yajl_alloc(&callbacks, NULL, NULL, (void*)g);
+    hand = yajl_alloc(&callbacks, NULL, NULL, NULL);
 #endif
     yajl_status stat;
     json_node = focused;
     to_focus = NULL;
+    last_key = JK_UNKNOWN;
     parsing_rect = false;
     parsing_window_rect = false;
     parsing_geometry = false;
     setlocale(LC_NUMERIC, "C");
-    stat = yajl_parse(hand, (const unsigned char*)buf, n);
+    stat = yajl_parse(hand, buf, n);
     if (stat != yajl_status_ok)
     {
-        unsigned char * str = yajl_get_error(hand, 1, (const unsigned char*)buf, n);
+        unsigned char * str = yajl_get_error(hand, 1, buf, n);
         fprintf(stderr, "%s\n", (const char *) str);
         yajl_free_error(hand, str);
     }
 
-    setlocale(LC_NUMERIC, "");
 #if YAJL_MAJOR >= 2
     yajl_complete_parse(hand);
 #else
     yajl_parse_complete(hand);
 #endif
+    setlocale(LC_NUMERIC, "");
 
-    fclose(f);
+    yajl_free(hand);
+    munmap(buf, n);
+    close(fd);
     if (to_focus)
         con_focus(to_focus);
 }
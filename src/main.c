@@ -224,6 +224,7 @@ static void i3_exit(void) {
         fflush(stderr);
         shm_unlink(shmlogname);
     }
+    tree_snapshot_unlink();
 }
 
 /*
@@ -236,6 +237,7 @@ static void handle_signal(int sig, siginfo_t *info, void *data) {
     if (*shmlogname != '\0') {
         shm_unlink(shmlogname);
     }
+    tree_snapshot_unlink();
     raise(sig);
 }
 
@@ -504,6 +506,9 @@ int main(int argc, char *argv[]) {
     if (xcb_connection_has_error(conn))
         errx(EXIT_FAILURE, "Cannot open display\n");
 
+    /* Account the X_WAIT() round-trips of i3 and libi3 for GET_STATS. */
+    x_wait_hook = x_stats_record_wait;
+
     sndisplay = sn_xcb_display_new(conn, NULL, NULL);
 
     /* Initialize the libev event loop. This needs to be done before loading
@@ -681,6 +686,8 @@ int main(int argc, char *argv[]) {
         con_focus(con_descend_focused(output_get_content(output->con)));
     }
 
+    tree_snapshot_init();
+
     tree_render();
 
     /* Create the UNIX domain socket for IPC */
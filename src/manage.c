@@ -10,37 +10,174 @@
  *
  */
 #include "all.h"
-#include "yajl_utils.h"
+#include "json_utils.h"
 
-#include <yajl/yajl_gen.h>
+/*
+ * All the requests which are sent for a window before it gets managed. The
+ * replies are only waited for in manage_window_finish(), so that the requests
+ * for many windows can be in flight at the same time.
+ *
+ */
+struct manage_cookies {
+    xcb_window_t window;
+    xcb_get_geometry_cookie_t geometry;
+    xcb_void_cookie_t event_mask;
+    xcb_get_property_cookie_t wm_type, strut, state, utf8_title, title,
+                              class, leader, transient, role, startup_id,
+                              wm_hints, protocols;
+};
+
+/*
+ * Checks the attributes of a window and returns whether it should be managed.
+ *
+ */
+static bool manage_window_wanted(xcb_window_t window, xcb_get_window_attributes_reply_t *attr,
+                                 bool needs_to_be_mapped) {
+    /* Check if the window is mapped (it could be not mapped when intializing and
+       calling manage_window() for every window) */
+    if (needs_to_be_mapped && attr->map_state != XCB_MAP_STATE_VIEWABLE)
+        return false;
+
+    /* Don’t manage clients with the override_redirect flag */
+    if (attr->override_redirect)
+        return false;
+
+    /* Check if the window is already managed */
+    if (con_by_window_id(window) != NULL) {
+        DLOG("already managed (by con %p)\n", con_by_window_id(window));
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Sets the temporary event mask and requests all the properties we need to
+ * manage the window. Nothing is waited for.
+ *
+ */
+static void manage_window_request(struct manage_cookies *cookies) {
+    const xcb_window_t window = cookies->window;
+
+    /* Set a temporary event mask for the new window, consisting only of
+     * PropertyChange and StructureNotify. We need to be notified of
+     * PropertyChanges because the client can change its properties *after* we
+     * requested them but *before* we actually reparented it and have set our
+     * final event mask.
+     * We need StructureNotify because the client may unmap the window before
+     * we get to re-parent it.
+     * If this request fails, we assume the client has already unmapped the
+     * window between the MapRequest and our event mask change. Since the
+     * server processes requests in order, the event mask is in place before
+     * any of the properties below are read. The request is only checked in
+     * manage_window_finish(): by then, the replies to the later requests have
+     * arrived, so checking does not need an additional round-trip. */
+    uint32_t values[] = { XCB_EVENT_MASK_PROPERTY_CHANGE | XCB_EVENT_MASK_STRUCTURE_NOTIFY };
+    cookies->event_mask = xcb_change_window_attributes_checked(conn, window, XCB_CW_EVENT_MASK, values);
+
+#define GET_PROPERTY(atom, len) xcb_get_property(conn, false, window, atom, XCB_GET_PROPERTY_TYPE_ANY, 0, len)
+
+    cookies->wm_type = GET_PROPERTY(A__NET_WM_WINDOW_TYPE, UINT32_MAX);
+    cookies->strut = GET_PROPERTY(A__NET_WM_STRUT_PARTIAL, UINT32_MAX);
+    cookies->state = GET_PROPERTY(A__NET_WM_STATE, UINT32_MAX);
+    cookies->utf8_title = GET_PROPERTY(A__NET_WM_NAME, 128);
+    cookies->leader = GET_PROPERTY(A_WM_CLIENT_LEADER, UINT32_MAX);
+    cookies->transient = GET_PROPERTY(XCB_ATOM_WM_TRANSIENT_FOR, UINT32_MAX);
+    cookies->title = GET_PROPERTY(XCB_ATOM_WM_NAME, 128);
+    cookies->class = GET_PROPERTY(XCB_ATOM_WM_CLASS, 128);
+    cookies->role = GET_PROPERTY(A_WM_WINDOW_ROLE, 128);
+    cookies->startup_id = GET_PROPERTY(A__NET_STARTUP_ID, 512);
+    cookies->wm_hints = xcb_icccm_get_wm_hints(conn, window);
+    cookies->protocols = xcb_icccm_get_wm_protocols(conn, window, A_WM_PROTOCOLS);
+    /* TODO: also get wm_normal_hints here. implement after we got rid of xcb-event */
+
+#undef GET_PROPERTY
+}
+
+/*
+ * Throws away the replies to all requests of manage_window_request(), for
+ * windows which we do not manage after all.
+ *
+ */
+static void manage_window_discard(struct manage_cookies *cookies) {
+    xcb_get_property_cookie_t *props[] = {
+        &cookies->wm_type, &cookies->strut, &cookies->state, &cookies->utf8_title,
+        &cookies->title, &cookies->class, &cookies->leader, &cookies->transient,
+        &cookies->role, &cookies->startup_id, &cookies->wm_hints, &cookies->protocols
+    };
+    for (size_t i = 0; i < sizeof(props) / sizeof(props[0]); i++)
+        xcb_discard_reply(conn, props[i]->sequence);
+}
+
+static void manage_window_finish(struct manage_cookies *cookies,
+                                 xcb_get_window_attributes_reply_t *attr,
+                                 bool check_reparent);
 
 /*
  * Go through all existing windows (if the window manager is restarted) and manage them
  *
+ * This happens in stages, so that we only wait for the X server a handful of
+ * times instead of once (or more) per window and property: First, the
+ * attributes and geometry of all windows are requested. Then, for every
+ * window we want to manage, the event mask is set and all properties are
+ * requested. Only then are the replies consumed, in the original order.
+ *
+ * The caller grabs the server, so no window can disappear in between.
+ *
  */
 void manage_existing_windows(xcb_window_t root) {
     xcb_query_tree_reply_t *reply;
     int i, len;
     xcb_window_t *children;
-    xcb_get_window_attributes_cookie_t *cookies;
+    xcb_get_window_attributes_cookie_t *attr_cookies;
+    xcb_get_window_attributes_reply_t **attrs;
+    struct manage_cookies *cookies;
 
     /* Get the tree of windows whose parent is the root window (= all) */
-    if ((reply = xcb_query_tree_reply(conn, xcb_query_tree(conn, root), 0)) == NULL)
+    if ((reply = X_WAIT(xcb_query_tree_reply, conn, xcb_query_tree(conn, root), 0)) == NULL)
         return;
 
     len = xcb_query_tree_children_length(reply);
-    cookies = smalloc(len * sizeof(*cookies));
+    attr_cookies = smalloc(len * sizeof(*attr_cookies));
+    attrs = scalloc(len * sizeof(*attrs));
+    cookies = scalloc(len * sizeof(*cookies));
 
-    /* Request the window attributes for every window */
+    /* Request the window attributes and geometry for every window */
     children = xcb_query_tree_children(reply);
-    for (i = 0; i < len; ++i)
-        cookies[i] = xcb_get_window_attributes(conn, children[i]);
+    for (i = 0; i < len; ++i) {
+        cookies[i].window = children[i];
+        attr_cookies[i] = xcb_get_window_attributes(conn, children[i]);
+        cookies[i].geometry = xcb_get_geometry(conn, children[i]);
+    }
 
-    /* Call manage_window with the attributes for every window */
-    for (i = 0; i < len; ++i)
-        manage_window(children[i], cookies[i], true);
+    /* Request the properties of every window we are going to manage */
+    for (i = 0; i < len; ++i) {
+        attrs[i] = X_WAIT(xcb_get_window_attributes_reply, conn, attr_cookies[i], 0);
+        if (attrs[i] == NULL) {
+            DLOG("Could not get attributes of window 0x%08x\n", children[i]);
+        } else if (manage_window_wanted(children[i], attrs[i], true)) {
+            manage_window_request(&cookies[i]);
+            continue;
+        }
+        xcb_discard_reply(conn, cookies[i].geometry.sequence);
+        FREE(attrs[i]);
+    }
+
+    /* Manage them. The requests were sent for all windows at once above, so
+     * only finishing is measured per window (the first one includes waiting
+     * for the replies). */
+    for (i = 0; i < len; ++i) {
+        if (attrs[i] == NULL)
+            continue;
+        const uint64_t start = latency_now();
+        manage_window_finish(&cookies[i], attrs[i], false);
+        LATENCY_RECORD(LATENCY_MANAGE_WINDOW, start);
+        free(attrs[i]);
+    }
 
     free(reply);
+    free(attr_cookies);
+    free(attrs);
     free(cookies);
 }
 
@@ -78,30 +215,32 @@ void restore_geometry(void) {
 /*
  * The following function sends a new window event, which consists
  * of fields "change" and "container", the latter containing a dump
- * of the window's container.
+ * of the window's container (without children).
  *
  */
 static void ipc_send_window_new_event(Con *con) {
-    setlocale(LC_NUMERIC, "C");
-    yajl_gen gen = ygenalloc();
+    if (!ipc_has_subscribers("window"))
+        return;
+
+    static json_writer writer;
+    json_writer *gen = &writer;
+    json_writer_reset(gen);
 
     y(map_open);
 
-    ystr("change");
+    ykey("change");
     ystr("new");
 
-    ystr("container");
-    dump_node(gen, con, false);
+    ykey("container");
+    dump_event_node(gen, con);
 
     y(map_close);
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_event("window", I3_IPC_EVENT_WINDOW, (const char *)payload);
-    y(free);
-    setlocale(LC_NUMERIC, "");
 }
 
 /*
@@ -110,93 +249,66 @@ static void ipc_send_window_new_event(Con *con) {
  */
 void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cookie,
                    bool needs_to_be_mapped) {
-    xcb_drawable_t d = { window };
-    xcb_get_geometry_cookie_t geomc;
-    xcb_get_geometry_reply_t *geom;
-    xcb_get_window_attributes_reply_t *attr = NULL;
-
-    xcb_get_property_cookie_t wm_type_cookie, strut_cookie, state_cookie,
-                              utf8_title_cookie, title_cookie,
-                              class_cookie, leader_cookie, transient_cookie,
-                              role_cookie, startup_id_cookie, wm_hints_cookie;
-
+    struct manage_cookies cookies = { .window = window };
+    xcb_get_window_attributes_reply_t *attr;
 
-    geomc = xcb_get_geometry(conn, d);
-#define FREE_GEOMETRY() do { \
-    if ((geom = xcb_get_geometry_reply(conn, geomc, 0)) != NULL) \
-        free(geom); \
-} while (0)
+    cookies.geometry = xcb_get_geometry(conn, window);
 
-    /* Check if the window is mapped (it could be not mapped when intializing and
-       calling manage_window() for every window) */
-    if ((attr = xcb_get_window_attributes_reply(conn, cookie, 0)) == NULL) {
+    if ((attr = X_WAIT(xcb_get_window_attributes_reply, conn, cookie, 0)) == NULL) {
         DLOG("Could not get attributes\n");
-        FREE_GEOMETRY();
+        xcb_discard_reply(conn, cookies.geometry.sequence);
         return;
     }
 
-    if (needs_to_be_mapped && attr->map_state != XCB_MAP_STATE_VIEWABLE) {
-        FREE_GEOMETRY();
-        goto out;
+    if (!manage_window_wanted(window, attr, needs_to_be_mapped)) {
+        xcb_discard_reply(conn, cookies.geometry.sequence);
+        free(attr);
+        return;
     }
 
-    /* Don’t manage clients with the override_redirect flag */
-    if (attr->override_redirect) {
-        FREE_GEOMETRY();
-        goto out;
-    }
+    const uint64_t start = latency_now();
+    manage_window_request(&cookies);
+    manage_window_finish(&cookies, attr, true);
+    LATENCY_RECORD(LATENCY_MANAGE_WINDOW, start);
+    free(attr);
+}
 
-    /* Check if the window is already managed */
-    if (con_by_window_id(window) != NULL) {
-        DLOG("already managed (by con %p)\n", con_by_window_id(window));
-        FREE_GEOMETRY();
-        goto out;
-    }
+/*
+ * Waits for the replies to the requests of manage_window_request() and
+ * actually manages the window: places it in the tree, reparents it and so on.
+ *
+ * check_reparent can be set to false while the server is grabbed: once the
+ * event mask could be set, the window cannot vanish anymore, so there is no
+ * need to wait for the reparenting to be acknowledged.
+ *
+ */
+static void manage_window_finish(struct manage_cookies *cookies,
+                                 xcb_get_window_attributes_reply_t *attr,
+                                 bool check_reparent) {
+    const xcb_window_t window = cookies->window;
+    xcb_get_geometry_reply_t *geom;
+    xcb_generic_error_t *error;
 
     /* Get the initial geometry (position, size, …) */
-    if ((geom = xcb_get_geometry_reply(conn, geomc, 0)) == NULL) {
+    if ((geom = X_WAIT(xcb_get_geometry_reply, conn, cookies->geometry, 0)) == NULL) {
         DLOG("could not get geometry\n");
-        goto out;
+        manage_window_discard(cookies);
+        xcb_discard_reply(conn, cookies->event_mask.sequence);
+        return;
     }
 
-    uint32_t values[1];
-
-    /* Set a temporary event mask for the new window, consisting only of
-     * PropertyChange and StructureNotify. We need to be notified of
-     * PropertyChanges because the client can change its properties *after* we
-     * requested them but *before* we actually reparented it and have set our
-     * final event mask.
-     * We need StructureNotify because the client may unmap the window before
-     * we get to re-parent it.
-     * If this request fails, we assume the client has already unmapped the
-     * window between the MapRequest and our event mask change. */
-    values[0] = XCB_EVENT_MASK_PROPERTY_CHANGE |
-                XCB_EVENT_MASK_STRUCTURE_NOTIFY;
-    xcb_void_cookie_t event_mask_cookie =
-        xcb_change_window_attributes_checked(conn, window, XCB_CW_EVENT_MASK, values);
-    if (xcb_request_check(conn, event_mask_cookie) != NULL) {
+    if ((error = X_WAIT(xcb_request_check, conn, cookies->event_mask)) != NULL) {
         LOG("Could not change event mask, the window probably already disappeared.\n");
-        goto out;
+        free(error);
+        manage_window_discard(cookies);
+        goto geom_out;
     }
 
-#define GET_PROPERTY(atom, len) xcb_get_property(conn, false, window, atom, XCB_GET_PROPERTY_TYPE_ANY, 0, len)
-
-    wm_type_cookie = GET_PROPERTY(A__NET_WM_WINDOW_TYPE, UINT32_MAX);
-    strut_cookie = GET_PROPERTY(A__NET_WM_STRUT_PARTIAL, UINT32_MAX);
-    state_cookie = GET_PROPERTY(A__NET_WM_STATE, UINT32_MAX);
-    utf8_title_cookie = GET_PROPERTY(A__NET_WM_NAME, 128);
-    leader_cookie = GET_PROPERTY(A_WM_CLIENT_LEADER, UINT32_MAX);
-    transient_cookie = GET_PROPERTY(XCB_ATOM_WM_TRANSIENT_FOR, UINT32_MAX);
-    title_cookie = GET_PROPERTY(XCB_ATOM_WM_NAME, 128);
-    class_cookie = GET_PROPERTY(XCB_ATOM_WM_CLASS, 128);
-    role_cookie = GET_PROPERTY(A_WM_WINDOW_ROLE, 128);
-    startup_id_cookie = GET_PROPERTY(A__NET_STARTUP_ID, 512);
-    wm_hints_cookie = xcb_icccm_get_wm_hints(conn, window);
-    /* TODO: also get wm_normal_hints here. implement after we got rid of xcb-event */
+    uint32_t values[1];
 
     DLOG("Managing window 0x%08x\n", window);
 
-    i3Window *cwindow = scalloc(sizeof(i3Window));
+    i3Window *cwindow = pool_alloc(&window_pool);
     cwindow->id = window;
     cwindow->depth = get_visual_depth(attr->visual);
 
@@ -217,27 +329,33 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
                     XCB_BUTTON_MASK_ANY /* don’t filter for any modifiers */);
 
     /* update as much information as possible so far (some replies may be NULL) */
-    window_update_class(cwindow, xcb_get_property_reply(conn, class_cookie, NULL), true);
-    window_update_name_legacy(cwindow, xcb_get_property_reply(conn, title_cookie, NULL), true);
-    window_update_name(cwindow, xcb_get_property_reply(conn, utf8_title_cookie, NULL), true);
-    window_update_leader(cwindow, xcb_get_property_reply(conn, leader_cookie, NULL));
-    window_update_transient_for(cwindow, xcb_get_property_reply(conn, transient_cookie, NULL));
-    window_update_strut_partial(cwindow, xcb_get_property_reply(conn, strut_cookie, NULL));
-    window_update_role(cwindow, xcb_get_property_reply(conn, role_cookie, NULL), true);
-    window_update_hints(cwindow, xcb_get_property_reply(conn, wm_hints_cookie, NULL));
+    window_update_class(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->class, NULL), true);
+    window_update_name_legacy(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->title, NULL), true);
+    window_update_name(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->utf8_title, NULL), true);
+    window_update_leader(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->leader, NULL));
+    window_update_transient_for(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->transient, NULL));
+    window_update_strut_partial(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->strut, NULL));
+    window_update_role(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->role, NULL), true);
+    window_update_hints(cwindow, X_WAIT(xcb_get_property_reply, conn, cookies->wm_hints, NULL));
 
     xcb_get_property_reply_t *startup_id_reply;
-    startup_id_reply = xcb_get_property_reply(conn, startup_id_cookie, NULL);
+    startup_id_reply = X_WAIT(xcb_get_property_reply, conn, cookies->startup_id, NULL);
     char *startup_ws = startup_workspace_for_window(cwindow, startup_id_reply);
     DLOG("startup workspace = %s\n", startup_ws);
 
     /* check if the window needs WM_TAKE_FOCUS */
-    cwindow->needs_take_focus = window_supports_protocol(cwindow->id, A_WM_TAKE_FOCUS);
+    xcb_icccm_get_wm_protocols_reply_t protocols;
+    if (X_WAIT(xcb_icccm_get_wm_protocols_reply, conn, cookies->protocols, &protocols, NULL) == 1) {
+        for (uint32_t i = 0; i < protocols.atoms_len; i++)
+            if (protocols.atoms[i] == A_WM_TAKE_FOCUS)
+                cwindow->needs_take_focus = true;
+        xcb_icccm_get_wm_protocols_reply_wipe(&protocols);
+    }
 
     /* Where to start searching for a container that swallows the new one? */
     Con *search_at = croot;
 
-    xcb_get_property_reply_t *reply = xcb_get_property_reply(conn, wm_type_cookie, NULL);
+    xcb_get_property_reply_t *reply = X_WAIT(xcb_get_property_reply, conn, cookies->wm_type, NULL);
     if (xcb_reply_contains_atom(reply, A__NET_WM_WINDOW_TYPE_DOCK)) {
         LOG("This window is of type dock\n");
         Output *output = get_output_containing(geom->x, geom->y);
@@ -315,7 +433,7 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
     }
 
     DLOG("new container = %p\n", nc);
-    nc->window = cwindow;
+    con_set_window(nc, cwindow);
     x_reinit(nc);
 
     nc->border_width = geom->border_width;
@@ -423,17 +541,21 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
     values[0] = XCB_NONE;
     xcb_change_window_attributes(conn, window, XCB_CW_EVENT_MASK, values);
 
-    xcb_void_cookie_t rcookie = xcb_reparent_window_checked(conn, window, nc->frame, 0, 0);
-    if (xcb_request_check(conn, rcookie) != NULL) {
-        LOG("Could not reparent the window, aborting\n");
-        goto geom_out;
-    }
+    if (check_reparent) {
+        xcb_void_cookie_t rcookie = xcb_reparent_window_checked(conn, window, nc->frame, 0, 0);
+        if ((error = X_WAIT(xcb_request_check, conn, rcookie)) != NULL) {
+            LOG("Could not reparent the window, aborting\n");
+            free(error);
+            xcb_discard_reply(conn, cookies->state.sequence);
+            goto geom_out;
+        }
+    } else xcb_reparent_window(conn, window, nc->frame, 0, 0);
 
     values[0] = CHILD_EVENT_MASK & ~XCB_EVENT_MASK_ENTER_WINDOW;
     xcb_change_window_attributes(conn, window, XCB_CW_EVENT_MASK, values);
     xcb_flush(conn);
 
-    reply = xcb_get_property_reply(conn, state_cookie, NULL);
+    reply = X_WAIT(xcb_get_property_reply, conn, cookies->state, NULL);
     if (xcb_reply_contains_atom(reply, A__NET_WM_STATE_FULLSCREEN))
         con_toggle_fullscreen(nc, CF_OUTPUT);
 
@@ -475,7 +597,4 @@ void manage_window(xcb_window_t window, xcb_get_window_attributes_cookie_t cooki
 
 geom_out:
     free(geom);
-out:
-    free(attr);
-    return;
 }
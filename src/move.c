@@ -54,12 +54,14 @@ static void insert_con_into(Con *con, Con *target, position_t position) {
         TAILQ_INSERT_AFTER(&(parent->nodes_head), target, con, nodes);
         TAILQ_INSERT_HEAD(&(parent->focus_head), con, focused);
     }
+    con_aggregates_attach(con);
 
     /* Pretend the con was just opened with regards to size percent values.
      * Since the con is moved to a completely different con, the old value
      * does not make sense anyways. */
     con->percent = 0.0;
     con_fix_percent(parent);
+    con_invalidate_fullscreen_con(con);
 
     CALL(old_parent, on_remove_child);
 }
@@ -79,12 +81,14 @@ static void attach_to_workspace(Con *con, Con *ws) {
 
     TAILQ_INSERT_TAIL(&(ws->nodes_head), con, nodes);
     TAILQ_INSERT_TAIL(&(ws->focus_head), con, focused);
+    con_aggregates_attach(con);
 
     /* Pretend the con was just opened with regards to size percent values.
      * Since the con is moved to a completely different con, the old value
      * does not make sense anyways. */
     con->percent = 0.0;
     con_fix_percent(ws);
+    con_invalidate_fullscreen_con(con);
 }
 
 /*
@@ -202,7 +206,7 @@ end:
     con_focus(con);
 
     /* force re-painting the indicators */
-    FREE(con->deco_render_params);
+    POOL_FREE(&deco_render_params_pool, con->deco_render_params);
 
     tree_flatten(croot);
 }
@@ -0,0 +1,145 @@
+#undef I3__FILE__
+#define I3__FILE__ "pool.c"
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * pool.c: Typed slab pools for the structures which are allocated and freed
+ *         all the time (containers, windows, X11 states, decoration caches).
+ *
+ * Slabs are never given back to the system: the number of objects i3 needs is
+ * bounded by the number of windows, so the pools just keep the peak around and
+ * re-use it, instead of scattering small allocations over the heap.
+ *
+ */
+#include "all.h"
+#include "json_utils.h"
+
+#include <stddef.h>
+
+/* The size of one slab in bytes (pools with big objects get at least one
+ * object per slab, of course). */
+#define SLAB_SIZE 16384
+
+/* The alignment of all objects, enough for every type we store. */
+#define POOL_ALIGNMENT (sizeof(union { long double d; void *p; uint64_t i; }))
+
+struct pool con_pool = POOL_INITIALIZER("con", Con);
+struct pool window_pool = POOL_INITIALIZER("window", i3Window);
+/* con_state_pool is defined in x.c, which is the only place where the
+ * definition of struct con_state is known. */
+struct pool deco_render_params_pool = POOL_INITIALIZER("deco_render_params", struct deco_render_params);
+
+/* All pools which were used at least once, for the statistics. */
+static SLIST_HEAD(pools_head, pool) pools = SLIST_HEAD_INITIALIZER(pools);
+
+static size_t pool_stride(struct pool *pool) {
+    size_t size = pool->object_size;
+    if (size < sizeof(void*))
+        size = sizeof(void*);
+    return (size + POOL_ALIGNMENT - 1) & ~(POOL_ALIGNMENT - 1);
+}
+
+/*
+ * Allocates a new slab and puts all of its objects on the free list.
+ *
+ */
+static void pool_grow(struct pool *pool) {
+    const size_t stride = pool_stride(pool);
+
+    if (pool->objects_per_slab == 0) {
+        pool->objects_per_slab = (stride < SLAB_SIZE ? SLAB_SIZE / stride : 1);
+        SLIST_INSERT_HEAD(&pools, pool, pools);
+    }
+
+    char *slab = smalloc(stride * pool->objects_per_slab);
+    /* Link the objects in reverse, so that they are handed out in address
+     * order. */
+    for (uint32_t c = pool->objects_per_slab; c > 0; c--) {
+        void *object = slab + (c - 1) * stride;
+        *(void**)object = pool->free_list;
+        pool->free_list = object;
+    }
+    pool->slabs++;
+    DLOG("pool %s: new slab of %u objects (%zu bytes each)\n",
+         pool->name, pool->objects_per_slab, stride);
+}
+
+/*
+ * Returns a zeroed object from the given pool. Like scalloc(), this exits i3
+ * when no memory can be allocated.
+ *
+ */
+void *pool_alloc(struct pool *pool) {
+    if (pool->free_list == NULL)
+        pool_grow(pool);
+
+    void *object = pool->free_list;
+    pool->free_list = *(void**)object;
+    memset(object, 0, pool->object_size);
+
+    pool->allocations++;
+    if (++(pool->in_use) > pool->peak_in_use)
+        pool->peak_in_use = pool->in_use;
+    return object;
+}
+
+/*
+ * Gives an object which was returned by pool_alloc() back to its pool. The
+ * memory is not returned to the system, it will be re-used by the next
+ * pool_alloc() call.
+ *
+ */
+void pool_free(struct pool *pool, void *object) {
+    if (object == NULL)
+        return;
+
+    assert(pool->in_use > 0);
+    pool->in_use--;
+    *(void**)object = pool->free_list;
+    pool->free_list = object;
+}
+
+/*
+ * Generates the allocator statistics (one map per pool which was used so far)
+ * as a JSON array.
+ *
+ */
+void pool_dump_stats(json_writer *gen) {
+    y(array_open);
+
+    struct pool *pool;
+    SLIST_FOREACH(pool, &pools, pools) {
+        const uint32_t capacity = pool->slabs * pool->objects_per_slab;
+
+        y(map_open);
+        ykey("name");
+        ystr(pool->name);
+
+        ykey("object_size");
+        y(integer, pool_stride(pool));
+
+        ykey("slabs");
+        y(integer, pool->slabs);
+
+        ykey("bytes");
+        y(integer, (long long)capacity * pool_stride(pool));
+
+        ykey("in_use");
+        y(integer, pool->in_use);
+
+        ykey("free");
+        y(integer, capacity - pool->in_use);
+
+        ykey("peak_in_use");
+        y(integer, pool->peak_in_use);
+
+        ykey("allocations");
+        y(integer, pool->allocations);
+        y(map_close);
+    }
+
+    y(array_close);
+}
@@ -361,10 +361,7 @@ void init_ws_for_output(Output *output, Con *content) {
             continue;
 
         /* check if this workspace actually exists */
-        Con *workspace = NULL, *out;
-        TAILQ_FOREACH(out, &(croot->nodes_head), nodes)
-            GREP_FIRST(workspace, output_get_content(out),
-                       !strcasecmp(child->name, assignment->name));
+        Con *workspace = workspace_by_name(assignment->name);
         if (workspace == NULL)
             continue;
 
@@ -548,7 +545,7 @@ static void handle_output(xcb_connection_t *conn, xcb_randr_output_t id,
 
     xcb_randr_get_crtc_info_cookie_t icookie;
     icookie = xcb_randr_get_crtc_info(conn, output->crtc, cts);
-    if ((crtc = xcb_randr_get_crtc_info_reply(conn, icookie, NULL)) == NULL) {
+    if ((crtc = X_WAIT(xcb_randr_get_crtc_info_reply, conn, icookie, NULL)) == NULL) {
         DLOG("Skipping output %s: could not get CRTC (%p)\n",
              new->name, crtc);
         free(new);
@@ -608,10 +605,10 @@ void randr_query_outputs(void) {
     rcookie = xcb_randr_get_screen_resources_current(conn, root);
     pcookie = xcb_randr_get_output_primary(conn, root);
 
-    if ((primary = xcb_randr_get_output_primary_reply(conn, pcookie, NULL)) == NULL)
+    if ((primary = X_WAIT(xcb_randr_get_output_primary_reply, conn, pcookie, NULL)) == NULL)
         ELOG("Could not get RandR primary output\n");
     else DLOG("primary output is %08x\n", primary->output);
-    if ((res = xcb_randr_get_screen_resources_current_reply(conn, rcookie, NULL)) == NULL) {
+    if ((res = X_WAIT(xcb_randr_get_screen_resources_current_reply, conn, rcookie, NULL)) == NULL) {
         disable_randr(conn);
         return;
     }
@@ -629,7 +626,7 @@ void randr_query_outputs(void) {
     for (int i = 0; i < len; i++) {
         xcb_randr_get_output_info_reply_t *output;
 
-        if ((output = xcb_randr_get_output_info_reply(conn, ocookie[i], NULL)) == NULL)
+        if ((output = X_WAIT(xcb_randr_get_output_info_reply, conn, ocookie[i], NULL)) == NULL)
             continue;
 
         handle_output(conn, randr_outputs[i], output, cts, res);
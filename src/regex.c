@@ -9,13 +9,106 @@
  * regex.c: Interface to libPCRE (perl compatible regular expressions).
  *
  */
+#include <ctype.h>
+
 #include "all.h"
 
+/*
+ * Checks whether the given pattern is just a (possibly anchored) literal
+ * string, like "Firefox", "^urxvt" or "^Gimp$". Backslash-escaped punctuation
+ * (like "\." or "\$") stands for itself. If so, the literal is stored in the
+ * regex, so that regex_matches() can use plain string comparisons.
+ *
+ */
+static void regex_detect_literal(struct regex *re) {
+    const char *walk = re->pattern;
+    bool anchored_start = false,
+         anchored_end = false;
+
+    if (*walk == '^') {
+        anchored_start = true;
+        walk++;
+    }
+
+    char *literal = smalloc(strlen(walk) + 1);
+    size_t len = 0;
+    for (; *walk != '\0'; walk++) {
+        if (*walk == '\\') {
+            /* Escaped alphanumerics are character classes or assertions
+             * (like \d or \b), escaped punctuation is a literal character. */
+            const unsigned char next = walk[1];
+            if (next <= ' ' || next >= 0x7f || isalnum(next)) {
+                free(literal);
+                return;
+            }
+            literal[len++] = next;
+            walk++;
+            continue;
+        }
+        if (*walk == '$' && walk[1] == '\0') {
+            anchored_end = true;
+            break;
+        }
+        if (strchr("^$.[|()?*+{", *walk) != NULL) {
+            free(literal);
+            return;
+        }
+        literal[len++] = *walk;
+    }
+    literal[len] = '\0';
+
+    re->literal = literal;
+    re->literal_len = len;
+    if (anchored_start && anchored_end)
+        re->literal_type = RL_EXACT;
+    else if (anchored_start)
+        re->literal_type = RL_PREFIX;
+    else if (anchored_end)
+        re->literal_type = RL_SUFFIX;
+    else re->literal_type = RL_SUBSTRING;
+}
+
+/*
+ * Matches the input against a literal pattern. Note that (without
+ * PCRE_MULTILINE) $ also matches right before a newline at the very end of the
+ * subject, so we need to allow for that as well.
+ *
+ */
+static bool regex_literal_matches(struct regex *re, const char *input) {
+    size_t len;
+
+    switch (re->literal_type) {
+        case RL_SUBSTRING:
+            return (strstr(input, re->literal) != NULL);
+        case RL_PREFIX:
+            return (strncmp(input, re->literal, re->literal_len) == 0);
+        case RL_EXACT:
+            if (strncmp(input, re->literal, re->literal_len) != 0)
+                return false;
+            input += re->literal_len;
+            return (input[0] == '\0' || (input[0] == '\n' && input[1] == '\0'));
+        case RL_SUFFIX:
+            len = strlen(input);
+            if (len > 0 && input[len - 1] == '\n' &&
+                len - 1 >= re->literal_len &&
+                memcmp(input + len - 1 - re->literal_len, re->literal, re->literal_len) == 0)
+                return true;
+            return (len >= re->literal_len &&
+                    memcmp(input + len - re->literal_len, re->literal, re->literal_len) == 0);
+        default:
+            return false;
+    }
+}
+
 /*
  * Creates a new 'regex' struct containing the given pattern and a PCRE
  * compiled regular expression. Also, calls pcre_study because this regex will
  * most likely be used often (like for every new window and on every relevant
- * property change of existing windows).
+ * property change of existing windows). When PCRE supports it, the regular
+ * expression is JIT compiled.
+ *
+ * Patterns which turn out to be plain literals are not compiled at all, they
+ * are matched using string comparisons.
  *
  * Returns NULL if the pattern could not be compiled into a regular expression
  * (and ELOGs an appropriate error message).
@@ -27,6 +120,13 @@ struct regex *regex_new(const char *pattern) {
 
     struct regex *re = scalloc(sizeof(struct regex));
     re->pattern = sstrdup(pattern);
+
+    regex_detect_literal(re);
+    if (re->literal_type != RL_NONE) {
+        DLOG("Regular expression \"%s\" is a literal, not compiling it\n", pattern);
+        return re;
+    }
+
     int options = PCRE_UTF8;
 #ifdef PCRE_HAS_UCP
     /* We use PCRE_UCP so that \B, \b, \D, \d, \S, \s, \W, \w and some POSIX
@@ -44,7 +144,13 @@ struct regex *regex_new(const char *pattern) {
              offset, error);
         return NULL;
     }
-    re->extra = pcre_study(re->regex, 0, &error);
+    int study_options = 0;
+#ifdef PCRE_STUDY_JIT_COMPILE
+    /* PCRE ≥ 8.20 can compile the pattern to machine code. If the library was
+     * built without JIT support, the flag is silently ignored. */
+    study_options |= PCRE_STUDY_JIT_COMPILE;
+#endif
+    re->extra = pcre_study(re->regex, study_options, &error);
     /* If an error happened, we print the error message, but continue.
      * Studying the regular expression leads to faster matching, but it’s not
      * absolutely necessary. */
@@ -63,33 +169,173 @@ void regex_free(struct regex *regex) {
         return;
     FREE(regex->pattern);
     FREE(regex->regex);
+#ifdef PCRE_STUDY_JIT_COMPILE
+    /* The JIT compiled code must be released with pcre_free_study(). */
+    if (regex->extra != NULL)
+        pcre_free_study(regex->extra);
+    regex->extra = NULL;
+#else
     FREE(regex->extra);
+#endif
+    FREE(regex->literal);
+    for (int i = 0; i < REGEX_MEMO_SIZE; i++) {
+        release_interned_string(regex->memo[i].input);
+        regex->memo[i].input = NULL;
+    }
 }
 
 /*
  * Checks if the given regular expression matches the given input and returns
- * true if it does. In either case, it logs the outcome using LOG(), so it will
- * be visible without debug logging.
+ * true if it does. The outcome is logged using DLOG(), only errors are
+ * visible without debug logging.
  *
  */
 bool regex_matches(struct regex *regex, const char *input) {
     int rc;
 
-    /* We use strlen() because pcre_exec() expects the length of the input
-     * string in bytes */
-    if ((rc = pcre_exec(regex->regex, regex->extra, input, strlen(input), 0, 0, NULL, 0)) == 0) {
-        LOG("Regular expression \"%s\" matches \"%s\"\n",
-            regex->pattern, input);
-        return true;
+    if (regex->literal_type != RL_NONE) {
+        const bool matches = regex_literal_matches(regex, input);
+        DLOG("Literal \"%s\" %s \"%s\"\n",
+             regex->pattern, (matches ? "matches" : "does not match"), input);
+        return matches;
+    }
+
+    /* The memo holds a reference to each of its (interned) inputs, so if the
+     * caller passes one of them, it is the same string. */
+    struct regex_memo *memo;
+    for (memo = regex->memo; memo < regex->memo + REGEX_MEMO_SIZE; memo++) {
+        if (memo->input != input)
+            continue;
+        DLOG("Regular expression \"%s\" %s \"%s\" (cached)\n",
+             regex->pattern, (memo->matches ? "matches" : "does not match"), input);
+        return memo->matches;
+    }
+
+    /* FNV-1a. We also need the length of the input string in bytes for
+     * pcre_exec(), so this replaces the strlen() call. */
+    uint32_t hash = 2166136261u;
+    const char *walk;
+    for (walk = input; *walk != '\0'; walk++)
+        hash = (hash ^ (unsigned char)*walk) * 16777619u;
+    const size_t len = walk - input;
+
+    memo = &(regex->memo[hash % REGEX_MEMO_SIZE]);
+    if (memo->input != NULL && memo->hash == hash && strcmp(memo->input, input) == 0) {
+        DLOG("Regular expression \"%s\" %s \"%s\" (cached)\n",
+             regex->pattern, (memo->matches ? "matches" : "does not match"), input);
+        return memo->matches;
     }
 
-    if (rc == PCRE_ERROR_NOMATCH) {
-        LOG("Regular expression \"%s\" does not match \"%s\"\n",
-            regex->pattern, input);
-        return false;
+    if ((rc = pcre_exec(regex->regex, regex->extra, input, len, 0, 0, NULL, 0)) == 0 ||
+        rc == PCRE_ERROR_NOMATCH) {
+        const bool matches = (rc == 0);
+        DLOG("Regular expression \"%s\" %s \"%s\"\n",
+             regex->pattern, (matches ? "matches" : "does not match"), input);
+        release_interned_string(memo->input);
+        memo->input = intern_string_with_length(input, len);
+        memo->hash = hash;
+        memo->matches = matches;
+        return matches;
     }
 
     ELOG("PCRE error %d while trying to use regular expression \"%s\" on input \"%s\", see pcreapi(3)\n",
          rc, regex->pattern, input);
     return false;
 }
+
+/*******************************************************************************
+ * Code for building the stand-alone binary test.regex which is used by
+ * t/206-regex.t and doubles as a microbenchmark for the matching throughput.
+ ******************************************************************************/
+
+#ifdef TEST_REGEX
+
+#include <time.h>
+
+void debuglog(char *fmt, ...) {
+}
+
+void errorlog(char *fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+/*
+ * Syntax: test.regex <pattern> <input>…
+ *
+ * Prints one line per input: "match" or "no match". Every result is
+ * cross-checked against a plain pcre_exec() call, so that the literal fast
+ * path and the memo can be verified to behave exactly like PCRE.
+ *
+ * If the environment variable REGEX_BENCH_ITERATIONS is set, all inputs are
+ * matched that many times and the throughput of regex_matches() and of a
+ * plain pcre_exec() is printed to stderr.
+ *
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Syntax: %s <pattern> <input>…\n", argv[0]);
+        return 1;
+    }
+
+    struct regex *re = regex_new(argv[1]);
+    if (re == NULL)
+        return 1;
+
+    /* The reference: the same pattern, always compiled by PCRE. */
+    const char *error;
+    int errorcode, offset;
+    pcre *reference = pcre_compile2(argv[1], PCRE_UTF8, &errorcode, &error, &offset, NULL);
+    if (reference == NULL) {
+        fprintf(stderr, "PCRE compilation failed at %d: %s\n", offset, error);
+        return 1;
+    }
+    pcre_extra *reference_extra = pcre_study(reference, 0, &error);
+
+    int result = 0;
+    for (int c = 2; c < argc; c++) {
+        const bool matches = regex_matches(re, argv[c]);
+        const bool expected = (pcre_exec(reference, reference_extra, argv[c], strlen(argv[c]), 0, 0, NULL, 0) == 0);
+        /* Ask a second time to exercise the memo. */
+        if (regex_matches(re, argv[c]) != matches || matches != expected) {
+            fprintf(stderr, "MISMATCH: \"%s\" on \"%s\": got %d, PCRE says %d\n",
+                    argv[1], argv[c], matches, expected);
+            result = 1;
+        }
+        printf("%s\n", (matches ? "match" : "no match"));
+    }
+
+    const char *iterations_str = getenv("REGEX_BENCH_ITERATIONS");
+    if (iterations_str == NULL)
+        return result;
+
+    const long iterations = atol(iterations_str);
+    const long total = iterations * (argc - 2);
+    double start = now();
+    for (long i = 0; i < iterations; i++)
+        for (int c = 2; c < argc; c++)
+            regex_matches(re, argv[c]);
+    const double fast = now() - start;
+
+    start = now();
+    for (long i = 0; i < iterations; i++)
+        for (int c = 2; c < argc; c++)
+            pcre_exec(reference, reference_extra, argv[c], strlen(argv[c]), 0, 0, NULL, 0);
+    const double plain = now() - start;
+
+    fprintf(stderr, "%ld matches (%s)\n", total,
+            (re->literal_type != RL_NONE ? "literal" : "pcre"));
+    fprintf(stderr, "regex_matches(): %.0f matches/s\n", total / fast);
+    fprintf(stderr, "pcre_exec():     %.0f matches/s\n", total / plain);
+    return result;
+}
+#endif
@@ -115,6 +115,209 @@ static void render_l_output(Con *con) {
     }
 }
 
+/*
+ * The layout inputs and results of one child of the container which is being
+ * rendered. The children are gathered into one contiguous array, so that the
+ * geometry can be computed in tight loops instead of chasing pointers into the
+ * (big, scattered) Cons for every field.
+ *
+ */
+struct layout_node {
+    Con *con;
+    double percent;
+    uint32_t geometry_height;
+    border_style_t border_style;
+    bool leaf;
+
+    Rect rect;
+    Rect deco_rect;
+};
+
+/* The array is shared by all containers: each container is done with it
+ * before its children are rendered. */
+static struct layout_node *layout_nodes = NULL;
+static int layout_nodes_size = 0;
+
+/*
+ * Copies the inputs of all children of the given container into the
+ * layout_nodes array. The rects are initialized with the current ones, so that
+ * the layout functions only need to set what they change.
+ *
+ * *children is the number of children according to con_num_children(). It is
+ * only used to size the array and is set to the number of children which were
+ * actually gathered.
+ *
+ */
+static struct layout_node *gather_children(Con *con, int *children) {
+    if (*children > layout_nodes_size) {
+        layout_nodes_size = *children * 2;
+        layout_nodes = srealloc(layout_nodes, layout_nodes_size * sizeof(struct layout_node));
+    }
+
+    int gathered = 0;
+    Con *child;
+    TAILQ_FOREACH(child, &(con->nodes_head), nodes) {
+        if (gathered == layout_nodes_size) {
+            layout_nodes_size = (gathered + 1) * 2;
+            layout_nodes = srealloc(layout_nodes, layout_nodes_size * sizeof(struct layout_node));
+        }
+        struct layout_node *node = &(layout_nodes[gathered++]);
+        node->con = child;
+        node->percent = child->percent;
+        node->geometry_height = child->geometry.height;
+        node->border_style = child->border_style;
+        node->leaf = con_is_leaf(child);
+        node->rect = child->rect;
+        node->deco_rect = child->deco_rect;
+    }
+#ifdef DEBUG_AGGREGATES
+    if (gathered != *children)
+        ELOG("Container %p has %d children, but num_children is %d\n",
+             con, gathered, *children);
+#endif
+    *children = gathered;
+    return layout_nodes;
+}
+
+/*
+ * Default layout (L_SPLITH / L_SPLITV): the children share the space according
+ * to their percentages, leaf nodes with a normal border get a decoration.
+ *
+ */
+static void layout_split(Con *con, Rect rect, int deco_height, struct layout_node *nodes, int children) {
+    if (children == 0)
+        return;
+
+    /* precalculate the sizes to be able to correct rounding errors */
+    int sizes[children];
+    int i, assigned = 0;
+    const bool horizontal = (con->layout == L_SPLITH);
+    const int total = (horizontal ? rect.width : rect.height);
+    for (i = 0; i < children; i++) {
+        double percentage = nodes[i].percent > 0.0 ? nodes[i].percent : 1.0 / children;
+        assigned += sizes[i] = percentage * total;
+    }
+#ifdef DEBUG_AGGREGATES
+    if (abs(assigned - total) > children * 2)
+        ELOG("Container %p: the percentages of its %d children add up to %d px instead of %d px\n",
+             con, children, assigned, total);
+#endif
+    int signal = assigned < total ? 1 : -1;
+    while (assigned != total) {
+        for (i = 0; i < children && assigned != total; ++i) {
+            sizes[i] += signal;
+            assigned += signal;
+        }
+    }
+
+    int x = rect.x;
+    int y = rect.y;
+    for (i = 0; i < children; i++) {
+        Rect *r = &(nodes[i].rect);
+        r->x = x;
+        r->y = y;
+        if (horizontal) {
+            r->width = sizes[i];
+            r->height = rect.height;
+            x += sizes[i];
+        } else {
+            r->width = rect.width;
+            r->height = sizes[i];
+            y += sizes[i];
+        }
+    }
+
+    /* then we have the decoration, if this is a leaf node */
+    for (i = 0; i < children; i++) {
+        if (!nodes[i].leaf)
+            continue;
+
+        Rect *r = &(nodes[i].rect);
+        if (nodes[i].border_style == BS_NORMAL) {
+            /* TODO: make a function for relative coords? */
+            nodes[i].deco_rect = (Rect){
+                r->x - con->rect.x,
+                r->y - con->rect.y,
+                r->width,
+                deco_height
+            };
+            r->y += deco_height;
+            r->height -= deco_height;
+        } else {
+            nodes[i].deco_rect = (Rect){ 0, 0, 0, 0 };
+        }
+    }
+}
+
+/*
+ * Stacked layout: every child gets the whole space, minus one decoration line
+ * per child.
+ *
+ */
+static void layout_stacked(Con *con, Rect rect, int deco_height, struct layout_node *nodes, int children) {
+    for (int i = 0; i < children; i++) {
+        nodes[i].rect = rect;
+        nodes[i].deco_rect = (Rect){
+            rect.x - con->rect.x,
+            rect.y - con->rect.y + (i * deco_height),
+            rect.width,
+            deco_height
+        };
+
+        if (children > 1 || (nodes[i].border_style != BS_PIXEL && nodes[i].border_style != BS_NONE)) {
+            nodes[i].rect.y += (deco_height * children);
+            nodes[i].rect.height -= (deco_height * children);
+        }
+    }
+}
+
+/*
+ * Tabbed layout: every child gets the whole space, minus one decoration line
+ * which is shared by all tabs.
+ *
+ */
+static void layout_tabbed(Con *con, Rect rect, int deco_height, struct layout_node *nodes, int children) {
+    if (children == 0)
+        return;
+
+    const uint32_t tab_width = floor((float)rect.width / children);
+    for (int i = 0; i < children; i++) {
+        nodes[i].rect = rect;
+        Rect *deco = &(nodes[i].deco_rect);
+        deco->width = tab_width;
+        deco->x = rect.x - con->rect.x + i * tab_width;
+        deco->y = rect.y - con->rect.y;
+
+        /* Since the tab width may be something like 31,6 px per tab, we
+         * let the last tab have all the extra space (0,6 * children). */
+        if (i == (children-1)) {
+            deco->width += (rect.width - (deco->x + deco->width));
+        }
+
+        if (children > 1 || (nodes[i].border_style != BS_PIXEL && nodes[i].border_style != BS_NONE)) {
+            nodes[i].rect.y += deco_height;
+            nodes[i].rect.height -= deco_height;
+            deco->height = deco_height;
+        } else {
+            deco->height = (nodes[i].border_style == BS_PIXEL ? 1 : 0);
+        }
+    }
+}
+
+/*
+ * Dockarea layout: the dock clients are stacked vertically, each one with the
+ * height it requested.
+ *
+ */
+static void layout_dockarea(Rect rect, struct layout_node *nodes, int children) {
+    int y = rect.y;
+    for (int i = 0; i < children; i++) {
+        nodes[i].rect = (Rect){ rect.x, y, rect.width, nodes[i].geometry_height };
+        nodes[i].deco_rect = (Rect){ 0, 0, 0, 0 };
+        y += nodes[i].geometry_height;
+    }
+}
+
 /*
  * "Renders" the given container (and its children), meaning that all rects are
  * updated correctly. Note that this function does not call any xcb_*
@@ -142,11 +345,6 @@ void render_con(Con *con, bool render_fullscreen) {
         rect.height -= 2 * 2;
     }
 
-    int x = rect.x;
-    int y = rect.y;
-
-    int i = 0;
-
     con->mapped = true;
 
     /* if this container contains a window, set the coordinates */
@@ -174,18 +372,14 @@ void render_con(Con *con, bool render_fullscreen) {
         if (!render_fullscreen &&
             con->proportional_height != 0 &&
             con->proportional_width != 0) {
-            double new_height = inset->height + 1;
-            int new_width = inset->width;
+            uint32_t new_width = inset->width;
+            uint32_t new_height = inset->height;
+            fit_aspect_ratio(&new_width, &new_height,
+                             con->proportional_width, con->proportional_height);
 
-            while (new_height > inset->height) {
-                new_height = ((double)con->proportional_height / con->proportional_width) * new_width;
-
-                if (new_height > inset->height)
-                    new_width--;
-            }
             /* Center the window */
-            inset->y += ceil(inset->height / 2) - floor(new_height / 2);
-            inset->x += ceil(inset->width / 2) - floor(new_width / 2);
+            inset->y += inset->height / 2 - new_height / 2;
+            inset->x += inset->width / 2 - new_width / 2;
 
             inset->height = new_height;
             inset->width = new_width;
@@ -215,30 +409,6 @@ void render_con(Con *con, bool render_fullscreen) {
     /* find the height for the decorations */
     int deco_height = render_deco_height();
 
-    /* precalculate the sizes to be able to correct rounding errors */
-    int sizes[children];
-    memset(sizes, 0, children*sizeof(int));
-    if ((con->layout == L_SPLITH || con->layout == L_SPLITV) && children > 0) {
-        assert(!TAILQ_EMPTY(&con->nodes_head));
-        Con *child;
-        int i = 0, assigned = 0;
-        int total = con_orientation(con) == HORIZ ? rect.width : rect.height;
-        TAILQ_FOREACH(child, &(con->nodes_head), nodes) {
-            double percentage = child->percent > 0.0 ? child->percent : 1.0 / children;
-            assigned += sizes[i++] = percentage * total;
-        }
-        assert(assigned == total ||
-                (assigned > total && assigned - total <= children * 2) ||
-                (assigned < total && total - assigned <= children * 2));
-        int signal = assigned < total ? 1 : -1;
-        while (assigned != total) {
-            for (i = 0; i < children && assigned != total; ++i) {
-                sizes[i] += signal;
-                assigned += signal;
-            }
-        }
-    }
-
     if (con->layout == L_OUTPUT) {
         /* Skip i3-internal outputs */
         if (con_is_internal(con))
@@ -305,113 +475,32 @@ void render_con(Con *con, bool render_fullscreen) {
 
     } else {
 
-        /* FIXME: refactor this into separate functions: */
-    Con *child;
-    TAILQ_FOREACH(child, &(con->nodes_head), nodes) {
-        assert(children > 0);
-
-        /* default layout */
-        if (con->layout == L_SPLITH || con->layout == L_SPLITV) {
-            if (con->layout == L_SPLITH) {
-                child->rect.x = x;
-                child->rect.y = y;
-                child->rect.width = sizes[i];
-                child->rect.height = rect.height;
-                x += child->rect.width;
-            } else {
-                child->rect.x = x;
-                child->rect.y = y;
-                child->rect.width = rect.width;
-                child->rect.height = sizes[i];
-                y += child->rect.height;
-            }
-
-            /* first we have the decoration, if this is a leaf node */
-            if (con_is_leaf(child)) {
-                if (child->border_style == BS_NORMAL) {
-                    /* TODO: make a function for relative coords? */
-                    child->deco_rect.x = child->rect.x - con->rect.x;
-                    child->deco_rect.y = child->rect.y - con->rect.y;
-
-                    child->rect.y += deco_height;
-                    child->rect.height -= deco_height;
-
-                    child->deco_rect.width = child->rect.width;
-                    child->deco_rect.height = deco_height;
-                } else {
-                    child->deco_rect.x = 0;
-                    child->deco_rect.y = 0;
-                    child->deco_rect.width = 0;
-                    child->deco_rect.height = 0;
-                }
-            }
-        }
-
-        /* stacked layout */
-        else if (con->layout == L_STACKED) {
-            child->rect.x = x;
-            child->rect.y = y;
-            child->rect.width = rect.width;
-            child->rect.height = rect.height;
-
-            child->deco_rect.x = x - con->rect.x;
-            child->deco_rect.y = y - con->rect.y + (i * deco_height);
-            child->deco_rect.width = child->rect.width;
-            child->deco_rect.height = deco_height;
-
-            if (children > 1 || (child->border_style != BS_PIXEL && child->border_style != BS_NONE)) {
-                child->rect.y += (deco_height * children);
-                child->rect.height -= (deco_height * children);
-            }
-        }
-
-        /* tabbed layout */
-        else if (con->layout == L_TABBED) {
-            child->rect.x = x;
-            child->rect.y = y;
-            child->rect.width = rect.width;
-            child->rect.height = rect.height;
-
-            child->deco_rect.width = floor((float)child->rect.width / children);
-            child->deco_rect.x = x - con->rect.x + i * child->deco_rect.width;
-            child->deco_rect.y = y - con->rect.y;
-
-            /* Since the tab width may be something like 31,6 px per tab, we
-             * let the last tab have all the extra space (0,6 * children). */
-            if (i == (children-1)) {
-                child->deco_rect.width += (child->rect.width - (child->deco_rect.x + child->deco_rect.width));
-            }
-
-            if (children > 1 || (child->border_style != BS_PIXEL && child->border_style != BS_NONE)) {
-                child->rect.y += deco_height;
-                child->rect.height -= deco_height;
-                child->deco_rect.height = deco_height;
-            } else {
-                child->deco_rect.height = (child->border_style == BS_PIXEL ? 1 : 0);
-            }
+        /* Gather the children, compute their geometry, then write it back. */
+        struct layout_node *nodes = gather_children(con, &children);
+        if (con->layout == L_SPLITH || con->layout == L_SPLITV)
+            layout_split(con, rect, deco_height, nodes, children);
+        else if (con->layout == L_STACKED)
+            layout_stacked(con, rect, deco_height, nodes, children);
+        else if (con->layout == L_TABBED)
+            layout_tabbed(con, rect, deco_height, nodes, children);
+        else if (con->layout == L_DOCKAREA)
+            layout_dockarea(rect, nodes, children);
+
+        for (int i = 0; i < children; i++) {
+            nodes[i].con->rect = nodes[i].rect;
+            nodes[i].con->deco_rect = nodes[i].deco_rect;
         }
 
-        /* dockarea layout */
-        else if (con->layout == L_DOCKAREA) {
-            child->rect.x = x;
-            child->rect.y = y;
-            child->rect.width = rect.width;
-            child->rect.height = child->geometry.height;
-
-            child->deco_rect.x = 0;
-            child->deco_rect.y = 0;
-            child->deco_rect.width = 0;
-            child->deco_rect.height = 0;
-            y += child->rect.height;
+        /* The array is re-used when rendering the children, so from here on,
+         * we only use the tree itself. */
+        Con *child;
+        TAILQ_FOREACH(child, &(con->nodes_head), nodes) {
+            DLOG("child at (%d, %d) with (%d x %d)\n",
+                    child->rect.x, child->rect.y, child->rect.width, child->rect.height);
+            x_raise_con(child, false);
+            render_con(child, false);
         }
 
-        DLOG("child at (%d, %d) with (%d x %d)\n",
-                child->rect.x, child->rect.y, child->rect.width, child->rect.height);
-        x_raise_con(child, false);
-        render_con(child, false);
-        i++;
-    }
-
     /* in a stacking or tabbed container, we ensure the focused client is raised */
     if (con->layout == L_STACKED || con->layout == L_TABBED) {
         TAILQ_FOREACH_REVERSE(child, &(con->focus_head), focus_head, focused)
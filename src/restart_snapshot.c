@@ -0,0 +1,469 @@
+#undef I3__FILE__
+#define I3__FILE__ "restart_snapshot.c"
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * restart_snapshot.c: A compact binary snapshot of the layout tree, which can
+ *                     be used instead of JSON for in-place restarts.
+ *
+ * The snapshot contains exactly the information dump_node() writes for an
+ * in-place restart, in the same order, but as fixed-size native-endian fields.
+ * Since it is only ever read by the i3 process which replaces the one that
+ * wrote it (on the same machine), it is neither meant to be portable nor
+ * stable across versions: the magic includes a format version, and files with
+ * a different magic are loaded as JSON.
+ *
+ */
+#include "all.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+static const char snapshot_magic[8] = "i3tree1";
+
+/* Flags of a node record */
+#define SNAPSHOT_FOCUSED (1 << 0)
+#define SNAPSHOT_MARK (1 << 1)
+#define SNAPSHOT_DEPTH (1 << 2)
+
+/* Flags of a swallow record */
+#define SNAPSHOT_SWALLOW_DOCK (1 << 0)
+#define SNAPSHOT_SWALLOW_WINDOW (1 << 1)
+
+/*******************************************************************************
+ * Writing
+ ******************************************************************************/
+
+struct snapshot_buffer {
+    unsigned char *data;
+    size_t len;
+    size_t size;
+};
+
+static void put(struct snapshot_buffer *buf, const void *data, size_t len) {
+    if (buf->len + len > buf->size) {
+        while (buf->len + len > buf->size)
+            buf->size = (buf->size == 0 ? 4096 : buf->size * 2);
+        buf->data = srealloc(buf->data, buf->size);
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+static void put_u8(struct snapshot_buffer *buf, uint8_t val) {
+    put(buf, &val, sizeof(val));
+}
+
+static void put_i32(struct snapshot_buffer *buf, int32_t val) {
+    put(buf, &val, sizeof(val));
+}
+
+static void put_u32(struct snapshot_buffer *buf, uint32_t val) {
+    put(buf, &val, sizeof(val));
+}
+
+static void put_i64(struct snapshot_buffer *buf, int64_t val) {
+    put(buf, &val, sizeof(val));
+}
+
+static void put_str(struct snapshot_buffer *buf, const char *str) {
+    const uint32_t len = (str == NULL ? 0 : strlen(str));
+    put_u32(buf, len);
+    if (len > 0)
+        put(buf, str, len);
+}
+
+static void put_rect(struct snapshot_buffer *buf, Rect r) {
+    put_u32(buf, r.x);
+    put_u32(buf, r.y);
+    put_u32(buf, r.width);
+    put_u32(buf, r.height);
+}
+
+static void store_node(struct snapshot_buffer *buf, Con *con) {
+    Con *node;
+    uint32_t count;
+
+    put_i64(buf, (long int)con);
+    put_u8(buf, con->type);
+    put_u8(buf, con->layout);
+    put_u8(buf, con->workspace_layout);
+    /* dump_node() stores the last_split_layout like this, too. */
+    put_u8(buf, (con->layout == L_SPLITV ? L_SPLITV : L_SPLITH));
+    put_u8(buf, con->border_style);
+    put_u8(buf, con->fullscreen_mode);
+    put_u8(buf, con->floating);
+    put_u8(buf, con->scratchpad_state);
+    put_u8(buf, (con == focused ? SNAPSHOT_FOCUSED : 0) |
+                (con->mark != NULL ? SNAPSHOT_MARK : 0) |
+                (con->window != NULL ? SNAPSHOT_DEPTH : 0));
+    put_i32(buf, con->current_border_width);
+    put_i32(buf, con->num);
+    put_i32(buf, con->depth);
+    put(buf, &(con->percent), sizeof(con->percent));
+    put_rect(buf, con->rect);
+    put_rect(buf, con->window_rect);
+    put_rect(buf, con->geometry);
+    if (con->window && con->window->name)
+        put_str(buf, i3string_as_utf8(con->window->name));
+    else put_str(buf, con->name);
+    if (con->mark != NULL)
+        put_str(buf, con->mark);
+
+    Match *match;
+    count = 0;
+    TAILQ_FOREACH(match, &(con->swallow_head), matches)
+        if (match->dock != -1)
+            count++;
+    if (con->window != NULL)
+        count++;
+    put_u32(buf, count);
+    TAILQ_FOREACH(match, &(con->swallow_head), matches) {
+        /* TODO: the other swallow keys (same as in dump_node()) */
+        if (match->dock == -1)
+            continue;
+        put_u8(buf, SNAPSHOT_SWALLOW_DOCK);
+        put_i32(buf, match->dock);
+        put_i32(buf, match->insert_where);
+    }
+    if (con->window != NULL) {
+        put_u8(buf, SNAPSHOT_SWALLOW_WINDOW);
+        put_u32(buf, con->window->id);
+    }
+
+    count = 0;
+    if (con->type != CT_DOCKAREA)
+        TAILQ_FOREACH(node, &(con->nodes_head), nodes)
+            count++;
+    put_u32(buf, count);
+    if (con->type != CT_DOCKAREA)
+        TAILQ_FOREACH(node, &(con->nodes_head), nodes)
+            store_node(buf, node);
+
+    count = 0;
+    TAILQ_FOREACH(node, &(con->floating_head), floating_windows)
+        count++;
+    put_u32(buf, count);
+    TAILQ_FOREACH(node, &(con->floating_head), floating_windows)
+        store_node(buf, node);
+
+    count = 0;
+    TAILQ_FOREACH(node, &(con->focus_head), focused)
+        count++;
+    put_u32(buf, count);
+    TAILQ_FOREACH(node, &(con->focus_head), focused)
+        put_i64(buf, (long int)node);
+}
+
+/*
+ * Writes a binary snapshot of the whole tree (like dump_node() with
+ * inplace_restart == true would) to the given file descriptor.
+ *
+ * Returns false if the snapshot could not be written.
+ *
+ */
+bool restart_snapshot_store(int fd) {
+    struct snapshot_buffer buf = { NULL, 0, 0 };
+
+    put(&buf, snapshot_magic, sizeof(snapshot_magic));
+    store_node(&buf, croot);
+
+    size_t written = 0;
+    while (written < buf.len) {
+        ssize_t n = write(fd, buf.data + written, buf.len - written);
+        if (n == -1) {
+            if (errno == EINTR)
+                continue;
+            ELOG("Could not write the tree snapshot: %s\n", strerror(errno));
+            free(buf.data);
+            return false;
+        }
+        written += n;
+    }
+    DLOG("Wrote a tree snapshot of %zu bytes\n", buf.len);
+    free(buf.data);
+    return true;
+}
+
+/*******************************************************************************
+ * Reading
+ ******************************************************************************/
+
+struct snapshot_reader {
+    const unsigned char *pos;
+    const unsigned char *end;
+    bool truncated;
+};
+
+/*
+ * Returns whether there are at least len more bytes in the snapshot.
+ *
+ */
+static bool available(struct snapshot_reader *r, size_t len) {
+    if (r->truncated || (size_t)(r->end - r->pos) < len) {
+        if (!r->truncated)
+            ELOG("The tree snapshot is truncated, not loading it.\n");
+        r->truncated = true;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Copies the next len bytes to dest. When the snapshot is truncated, dest is
+ * zeroed instead (the partially loaded containers are freed afterwards, see
+ * load_node()).
+ *
+ */
+static void get(struct snapshot_reader *r, void *dest, size_t len) {
+    if (!available(r, len)) {
+        memset(dest, 0, len);
+        return;
+    }
+    memcpy(dest, r->pos, len);
+    r->pos += len;
+}
+
+static uint8_t get_u8(struct snapshot_reader *r) {
+    uint8_t val;
+    get(r, &val, sizeof(val));
+    return val;
+}
+
+static int32_t get_i32(struct snapshot_reader *r) {
+    int32_t val;
+    get(r, &val, sizeof(val));
+    return val;
+}
+
+static uint32_t get_u32(struct snapshot_reader *r) {
+    uint32_t val;
+    get(r, &val, sizeof(val));
+    return val;
+}
+
+static int64_t get_i64(struct snapshot_reader *r) {
+    int64_t val;
+    get(r, &val, sizeof(val));
+    return val;
+}
+
+static char *get_str(struct snapshot_reader *r) {
+    uint32_t len = get_u32(r);
+    if (!available(r, len))
+        len = 0;
+    char *str = smalloc(len + 1);
+    get(r, str, len);
+    str[len] = '\0';
+    return str;
+}
+
+static Rect get_rect(struct snapshot_reader *r) {
+    Rect rect;
+    rect.x = get_u32(r);
+    rect.y = get_u32(r);
+    rect.width = get_u32(r);
+    rect.height = get_u32(r);
+    return rect;
+}
+
+/* Same as in load_layout.c: the container which had the focus. */
+static Con *to_focus;
+
+/*
+ * Frees a container and its children after a truncated snapshot. attached
+ * says whether load_node() already attached the container (and called
+ * x_con_init() for it), which is the case for all completely loaded ones.
+ * Those are detached with con_detach(), so that workspaces are removed from
+ * the workspace index and the aggregates of the ancestors are corrected.
+ * Children are freed first, so that every detach only takes away what is
+ * left of its own subtree.
+ *
+ */
+static void free_node(Con *con, bool attached) {
+    Con *child;
+    while ((child = TAILQ_FIRST(&(con->nodes_head))) != NULL)
+        free_node(child, true);
+    while ((child = TAILQ_FIRST(&(con->floating_head))) != NULL)
+        free_node(child, true);
+
+    Match *swallow;
+    while ((swallow = TAILQ_FIRST(&(con->swallow_head))) != NULL) {
+        TAILQ_REMOVE(&(con->swallow_head), swallow, matches);
+        match_free(swallow);
+        free(swallow);
+    }
+
+    if (attached) {
+        con_detach(con);
+        x_con_kill(con);
+    }
+    if (con->name_key != NULL)
+        release_interned_string(con->name_key);
+    FREE(con->name);
+    FREE(con->mark);
+    TAILQ_REMOVE(&all_cons, con, all_cons);
+    pool_free(&con_pool, con);
+}
+
+/*
+ * Reads one container (and its children) and attaches it to the given parent.
+ * This mirrors what the JSON callbacks in load_layout.c do.
+ *
+ * Returns false if the snapshot is truncated. In that case, nothing is
+ * attached: the container and the children read so far are freed.
+ *
+ */
+static bool load_node(struct snapshot_reader *r, Con *parent, bool is_floating) {
+    Con *con = con_new_skeleton(NULL, NULL);
+    con->parent = (is_floating ? con_get_workspace(parent) : parent);
+
+    con->old_id = get_i64(r);
+    con->type = get_u8(r);
+    con->layout = get_u8(r);
+    con->workspace_layout = get_u8(r);
+    con->last_split_layout = get_u8(r);
+    con->border_style = get_u8(r);
+    con->fullscreen_mode = get_u8(r);
+    con->floating = get_u8(r);
+    con->scratchpad_state = get_u8(r);
+    const uint8_t flags = get_u8(r);
+    con->current_border_width = get_i32(r);
+    const int32_t num = get_i32(r);
+    if (con->type == CT_WORKSPACE)
+        con->num = num;
+    const int32_t depth = get_i32(r);
+    if (flags & SNAPSHOT_DEPTH)
+        con->depth = depth;
+    get(r, &(con->percent), sizeof(con->percent));
+    con->rect = get_rect(r);
+    con->window_rect = get_rect(r);
+    con->geometry = get_rect(r);
+    FREE(con->name);
+    con->name = get_str(r);
+    if (flags & SNAPSHOT_MARK)
+        con->mark = get_str(r);
+    if (flags & SNAPSHOT_FOCUSED)
+        to_focus = con;
+
+    uint32_t count = get_u32(r);
+    for (uint32_t i = 0; i < count && !r->truncated; i++) {
+        Match *swallow = smalloc(sizeof(Match));
+        match_init(swallow);
+        if (get_u8(r) & SNAPSHOT_SWALLOW_DOCK) {
+            swallow->dock = get_i32(r);
+            swallow->insert_where = get_i32(r);
+        } else {
+            swallow->id = get_u32(r);
+            swallow->restart_mode = true;
+        }
+        TAILQ_INSERT_TAIL(&(con->swallow_head), swallow, matches);
+    }
+
+    count = get_u32(r);
+    for (uint32_t i = 0; i < count && !r->truncated; i++)
+        load_node(r, con, false);
+
+    count = get_u32(r);
+    for (uint32_t i = 0; i < count && !r->truncated; i++)
+        load_node(r, con, true);
+
+    /* Restore the focus order: the focus stack is read front to back, so we
+     * move the containers to the top of the focus stack back to front. */
+    count = get_u32(r);
+    if (count > 0 && available(r, count * sizeof(int64_t))) {
+        const unsigned char *ids = r->pos;
+        r->pos += count * sizeof(int64_t);
+        for (uint32_t i = count; i-- > 0;) {
+            int64_t old_id;
+            memcpy(&old_id, ids + i * sizeof(int64_t), sizeof(old_id));
+            Con *child;
+            TAILQ_FOREACH(child, &(con->focus_head), focused) {
+                /* old_id is an int, just like when loading JSON */
+                if (child->old_id != (int)old_id)
+                    continue;
+                TAILQ_REMOVE(&(con->focus_head), child, focused);
+                TAILQ_INSERT_HEAD(&(con->focus_head), child, focused);
+                break;
+            }
+        }
+    }
+
+    if (r->truncated) {
+        free_node(con, false);
+        return false;
+    }
+
+    con_attach(con, con->parent, true);
+    x_con_init(con, con->depth);
+    return true;
+}
+
+/*
+ * Returns true if the given file is a binary tree snapshot (as opposed to a
+ * JSON layout).
+ *
+ */
+bool restart_snapshot_detect(const char *filename) {
+    char magic[sizeof(snapshot_magic)];
+    int fd;
+    if ((fd = open(filename, O_RDONLY)) == -1)
+        return false;
+    const bool result = (read(fd, magic, sizeof(magic)) == sizeof(magic) &&
+                         memcmp(magic, snapshot_magic, sizeof(magic)) == 0);
+    close(fd);
+    return result;
+}
+
+/*
+ * Loads the binary tree snapshot from the given file and appends it to the
+ * focused container, just like tree_append_json() does for JSON layouts.
+ *
+ * Returns false (and appends nothing) if the snapshot could not be read or is
+ * truncated.
+ *
+ */
+bool restart_snapshot_load(const char *filename) {
+    int fd;
+    if ((fd = open(filename, O_RDONLY)) == -1) {
+        LOG("Cannot open file \"%s\"\n", filename);
+        return false;
+    }
+    struct stat stbuf;
+    if (fstat(fd, &stbuf) != 0) {
+        LOG("Cannot fstat() the file\n");
+        close(fd);
+        return false;
+    }
+    const size_t len = stbuf.st_size;
+    if (len < sizeof(snapshot_magic)) {
+        LOG("File \"%s\" is too short to be a tree snapshot\n", filename);
+        close(fd);
+        return false;
+    }
+    unsigned char *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        LOG("File \"%s\" could not be mapped, not loading: %s\n", filename, strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    struct snapshot_reader reader = {
+        .pos = data + sizeof(snapshot_magic),
+        .end = data + len,
+        .truncated = false
+    };
+    to_focus = NULL;
+    const bool loaded = load_node(&reader, focused, false);
+
+    munmap(data, len);
+    close(fd);
+    if (!loaded)
+        return false;
+    if (to_focus)
+        con_focus(to_focus);
+    return true;
+}
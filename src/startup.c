@@ -295,7 +295,7 @@ struct Startup_Sequence *startup_sequence_get(i3Window *cwindow,
 
         cookie = xcb_get_property(conn, false, cwindow->leader,
             A__NET_STARTUP_ID, XCB_GET_PROPERTY_TYPE_ANY, 0, 512);
-        startup_id_reply = xcb_get_property_reply(conn, cookie, NULL);
+        startup_id_reply = X_WAIT(xcb_get_property_reply, conn, cookie, NULL);
 
         if (startup_id_reply == NULL ||
             xcb_get_property_value_length(startup_id_reply) == 0) {
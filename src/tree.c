@@ -11,6 +11,8 @@
  */
 #include "all.h"
 
+#include <sys/time.h>
+
 struct Con *croot;
 struct Con *focused;
 
@@ -84,7 +86,25 @@ bool tree_restore(const char *path, xcb_get_geometry_reply_t *geometry) {
     };
     focused = croot;
 
-    tree_append_json(globbed);
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    const bool snapshot = restart_snapshot_detect(globbed);
+    if (snapshot && !restart_snapshot_load(globbed)) {
+        ELOG("Could not load the tree snapshot %s, not restoring tree\n", globbed);
+        x_con_kill(croot);
+        free(croot->name);
+        TAILQ_REMOVE(&all_cons, croot, all_cons);
+        pool_free(&con_pool, croot);
+        croot = NULL;
+        focused = NULL;
+        free(globbed);
+        return false;
+    }
+    if (!snapshot)
+        tree_append_json(globbed);
+    gettimeofday(&end, NULL);
+    LOG("Loaded the %s layout in %.3f ms\n", (snapshot ? "binary" : "JSON"),
+        ((end.tv_sec - start.tv_sec) * 1000.0) + ((end.tv_usec - start.tv_usec) / 1000.0));
 
     printf("appended tree, using new root\n");
     croot = TAILQ_FIRST(&(croot->nodes_head));
@@ -202,7 +222,7 @@ bool tree_close(Con *con, kill_window_t kill_window, bool dont_kill_parent, bool
 
     /* remove the urgency hint of the workspace (if set) */
     if (con->urgent) {
-        con->urgent = false;
+        con_set_urgent_flag(con, false);
         con_update_parents_urgency(con);
         workspace_update_urgent_flag(con_get_workspace(con));
     }
@@ -252,10 +272,11 @@ bool tree_close(Con *con, kill_window_t kill_window, bool dont_kill_parent, bool
              * X11 Errors are returned when the window was already destroyed */
             add_ignore_event(cookie.sequence, 0);
         }
-        FREE(con->window->class_class);
-        FREE(con->window->class_instance);
+        release_interned_string(con->window->class_class);
+        release_interned_string(con->window->class_instance);
+        release_interned_string(con->window->role);
         i3string_free(con->window->name);
-        free(con->window);
+        pool_free(&window_pool, con->window);
     }
 
     Con *ws = con_get_workspace(con);
@@ -311,9 +332,10 @@ bool tree_close(Con *con, kill_window_t kill_window, bool dont_kill_parent, bool
     }
 
     free(con->name);
-    FREE(con->deco_render_params);
+    release_interned_string(con->name_key);
+    POOL_FREE(&deco_render_params_pool, con->deco_render_params);
     TAILQ_REMOVE(&all_cons, con, all_cons);
-    free(con);
+    pool_free(&con_pool, con);
 
     /* in the case of floating windows, we already focused another container
      * when closing the parent, so we can exit now. */
@@ -393,8 +415,8 @@ void tree_split(Con *con, orientation_t orientation) {
     Con *parent = con->parent;
 
     /* Force re-rendering to make the indicator border visible. */
-    FREE(con->deco_render_params);
-    FREE(parent->deco_render_params);
+    POOL_FREE(&deco_render_params_pool, con->deco_render_params);
+    POOL_FREE(&deco_render_params_pool, parent->deco_render_params);
 
     /* if we are in a container whose parent contains only one
      * child (its split functionality is unused so far), we just change the
@@ -411,9 +433,11 @@ void tree_split(Con *con, orientation_t orientation) {
 
     /* 2: replace it with a new Con */
     Con *new = con_new(NULL, NULL);
+    con_aggregates_detach(con);
     TAILQ_REPLACE(&(parent->nodes_head), con, new, nodes);
     TAILQ_REPLACE(&(parent->focus_head), con, new, focused);
     new->parent = parent;
+    con_aggregates_attach(new);
     new->layout = (orientation == HORIZ) ? L_SPLITH : L_SPLITV;
 
     /* 3: swap 'percent' (resize factor) */
@@ -488,6 +512,26 @@ static void mark_unmapped(Con *con) {
     }
 }
 
+/* See tree_defer_render(). */
+static bool render_deferred = false;
+static bool render_pending = false;
+
+/*
+ * While deferred is true, tree_render() only remembers that the tree needs to
+ * be rendered. Setting it back to false renders the tree once if
+ * tree_render() was called in the meantime. Used by COMMAND_BATCH, so that a
+ * batch is rendered once, including commands which render on their own (like
+ * kill).
+ *
+ */
+void tree_defer_render(bool deferred) {
+    render_deferred = deferred;
+    if (!deferred && render_pending) {
+        render_pending = false;
+        tree_render();
+    }
+}
+
 /*
  * Renders the tree, that is rendering all outputs using render_con() and
  * pushing the changes to X11 using x_push_changes().
@@ -497,15 +541,32 @@ void tree_render(void) {
     if (croot == NULL)
         return;
 
+    if (render_deferred) {
+        render_pending = true;
+        return;
+    }
+
     DLOG("-- BEGIN RENDERING --\n");
+#ifdef DEBUG_AGGREGATES
+    con_verify_aggregates(croot);
+#endif
     /* Reset map state for all nodes in tree */
     /* TODO: a nicer method to walk all nodes would be good, maybe? */
     mark_unmapped(croot);
     croot->mapped = true;
 
+    x_stats_span span;
+    x_stats_begin(&span);
+
+    uint64_t start = latency_now();
     render_con(croot, false);
+    LATENCY_RECORD(LATENCY_RENDER_CON, start);
 
+    start = latency_now();
     x_push_changes(croot);
+    LATENCY_RECORD(LATENCY_X_PUSH_CHANGES, start);
+
+    x_stats_end_render(&span);
     DLOG("-- END RENDERING --\n");
 }
 
@@ -720,6 +781,7 @@ void tree_flatten(Con *con) {
         TAILQ_INSERT_BEFORE(con, current, nodes);
         DLOG("attaching to focus list\n");
         TAILQ_INSERT_TAIL(&(parent->focus_head), current, focused);
+        con_aggregates_attach(current);
         current->percent = con->percent;
     }
     DLOG("re-attached all\n");
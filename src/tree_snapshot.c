@@ -0,0 +1,250 @@
+#undef I3__FILE__
+#define I3__FILE__ "tree_snapshot.c"
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * tree_snapshot.c: Publishes a compact binary snapshot of the tree in a shared
+ *                  memory segment after every x_push_changes(), so that
+ *                  clients which only read the layout (status bars, window
+ *                  switchers) do not need to poll GET_TREE.
+ *
+ * The snapshot is protected by a seqlock (see include/shmtree.h): readers
+ * copy it without any locking or syscalls and retry when i3 was writing in
+ * the meantime.
+ *
+ */
+#include "all.h"
+#include "shmtree.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+
+/* The initial size of the segment. It is doubled whenever a snapshot does
+ * not fit. */
+#define INITIAL_SEGMENT_SIZE (64 * 1024)
+
+/* The name for the SHM (/i3-tree-%pid). Will end up on /dev/shm on most
+ * systems. Empty if the snapshot is not published. */
+char *shmtreename = "";
+
+static int segment_fd = -1;
+static size_t segment_size;
+static i3_shmtree_header *header;
+
+/* The snapshot is generated into these buffers first and then copied into
+ * the segment in one go, to keep the time during which readers have to retry
+ * as short as possible. */
+static i3_shmtree_node *nodes;
+static uint32_t num_nodes;
+static uint32_t nodes_capacity;
+static char *names;
+static size_t names_length;
+static size_t names_capacity;
+static uint32_t focused_index;
+
+/*
+ * Maps the segment with the given size (after truncating the file to that
+ * size). Returns false and leaves the old mapping intact on errors.
+ *
+ */
+static bool map_segment(size_t size) {
+    if (ftruncate(segment_fd, size) == -1) {
+        ELOG("Could not resize the SHM tree segment to %zu bytes: %s\n", size, strerror(errno));
+        return false;
+    }
+
+    void *mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, segment_fd, 0);
+    if (mapping == MAP_FAILED) {
+        ELOG("Could not mmap() the SHM tree segment: %s\n", strerror(errno));
+        return false;
+    }
+
+    if (header != NULL)
+        munmap(header, segment_size);
+    header = mapping;
+    segment_size = size;
+    header->size = size;
+    return true;
+}
+
+/*
+ * Creates the shared memory segment. Called once on startup, before the first
+ * tree_render().
+ *
+ */
+void tree_snapshot_init(void) {
+#if defined(__FreeBSD__)
+    sasprintf(&shmtreename, "/tmp/i3-tree-%d", getpid());
+#else
+    sasprintf(&shmtreename, "/i3-tree-%d", getpid());
+#endif
+    /* After an in-place restart, the segment of the old process (same pid)
+     * still exists. We just continue to use it. */
+    segment_fd = shm_open(shmtreename, O_RDWR | O_CREAT, S_IREAD | S_IWRITE);
+    if (segment_fd == -1) {
+        ELOG("Could not shm_open SHM segment for the tree snapshot: %s\n", strerror(errno));
+        shmtreename = "";
+        return;
+    }
+
+    /* Never shrink the segment of an old process, readers might still have
+     * mapped all of it. */
+    struct stat statbuf;
+    size_t size = INITIAL_SEGMENT_SIZE;
+    if (fstat(segment_fd, &statbuf) == 0 && (size_t)statbuf.st_size > size)
+        size = statbuf.st_size;
+
+    if (!map_segment(size)) {
+        tree_snapshot_unlink();
+        return;
+    }
+
+    /* Readers must never see a half-initialized header as valid snapshot: the
+     * magic is written last. Keeping the sequence counter (instead of
+     * resetting it) makes sure that readers of the old process notice the
+     * new snapshot. */
+    if (header->sequence & 1)
+        header->sequence++;
+    header->version = I3_SHMTREE_VERSION;
+    header->data_size = 0;
+    header->num_nodes = 0;
+    header->focused = I3_SHMTREE_NONE;
+    __sync_synchronize();
+    header->magic = I3_SHMTREE_MAGIC;
+
+    DLOG("Publishing tree snapshots in SHM segment %s\n", shmtreename);
+}
+
+/*
+ * Removes the shared memory segment. Called when i3 exits.
+ *
+ */
+void tree_snapshot_unlink(void) {
+    if (*shmtreename == '\0')
+        return;
+
+    shm_unlink(shmtreename);
+    shmtreename = "";
+}
+
+/*
+ * Appends the given container and (recursively) its children to the node
+ * array. Returns the index of the container.
+ *
+ */
+static uint32_t add_node(Con *con, uint32_t parent) {
+    if (num_nodes == nodes_capacity) {
+        nodes_capacity = (nodes_capacity == 0 ? 64 : nodes_capacity * 2);
+        nodes = srealloc(nodes, nodes_capacity * sizeof(i3_shmtree_node));
+    }
+
+    const uint32_t index = num_nodes++;
+    i3_shmtree_node *node = &nodes[index];
+    memset(node, 0, sizeof(i3_shmtree_node));
+
+    node->id = (uintptr_t)con;
+    node->parent = parent;
+    node->focus_child = I3_SHMTREE_NONE;
+    node->window = (con->window != NULL ? con->window->id : 0);
+    node->type = con->type;
+    node->layout = con->layout;
+    node->num = (con->type == CT_WORKSPACE ? con->num : -1);
+    node->rect = (i3_shmtree_rect){ con->rect.x, con->rect.y, con->rect.width, con->rect.height };
+
+    if (con->urgent)
+        node->flags |= I3_SHMTREE_URGENT;
+    if (con == focused) {
+        node->flags |= I3_SHMTREE_FOCUSED;
+        focused_index = index;
+    }
+    if (con->type == CT_FLOATING_CON)
+        node->flags |= I3_SHMTREE_FLOATING;
+    if (con->fullscreen_mode != CF_NONE)
+        node->flags |= I3_SHMTREE_FULLSCREEN;
+
+    /* The same name as in GET_TREE. */
+    const char *name = (con->window != NULL && con->window->name != NULL ?
+                        i3string_as_utf8(con->window->name) : con->name);
+    const size_t length = (name != NULL ? strlen(name) : 0);
+    if (names_length + length > names_capacity) {
+        while (names_length + length > names_capacity)
+            names_capacity = (names_capacity == 0 ? 4096 : names_capacity * 2);
+        names = srealloc(names, names_capacity);
+    }
+    if (length > 0)
+        memcpy(names + names_length, name, length);
+    node->name_offset = names_length;
+    node->name_length = length;
+    names_length += length;
+
+    /* node must not be used anymore from here on, the array might be
+     * re-allocated while adding the children. */
+    Con *focus_child = TAILQ_FIRST(&(con->focus_head));
+    Con *child;
+    TAILQ_FOREACH(child, &(con->nodes_head), nodes) {
+        const uint32_t child_index = add_node(child, index);
+        if (child == focus_child)
+            nodes[index].focus_child = child_index;
+    }
+    TAILQ_FOREACH(child, &(con->floating_head), floating_windows) {
+        const uint32_t child_index = add_node(child, index);
+        if (child == focus_child)
+            nodes[index].focus_child = child_index;
+    }
+
+    nodes[index].subtree_size = num_nodes - index;
+    return index;
+}
+
+/*
+ * Publishes a snapshot of the current tree (if it changed since the last
+ * one). Called at the end of x_push_changes().
+ *
+ */
+void tree_snapshot_publish(void) {
+    if (header == NULL)
+        return;
+
+    num_nodes = 0;
+    names_length = 0;
+    focused_index = I3_SHMTREE_NONE;
+    add_node(croot, I3_SHMTREE_NONE);
+
+    const size_t nodes_size = num_nodes * sizeof(i3_shmtree_node);
+    const size_t data_size = nodes_size + names_length;
+    char *data = (char*)header + sizeof(i3_shmtree_header);
+
+    /* Most x_push_changes() calls (e.g. for focus changes of the pointer
+     * within the same window) do not change the tree. Readers which wait for
+     * a new sequence number should not wake up for those. */
+    if (header->data_size == data_size &&
+        header->num_nodes == num_nodes &&
+        header->focused == focused_index &&
+        memcmp(data, nodes, nodes_size) == 0 &&
+        memcmp(data + nodes_size, names, names_length) == 0)
+        return;
+
+    if (sizeof(i3_shmtree_header) + data_size > segment_size) {
+        size_t size = segment_size;
+        while (sizeof(i3_shmtree_header) + data_size > size)
+            size *= 2;
+        if (!map_segment(size))
+            return;
+        data = (char*)header + sizeof(i3_shmtree_header);
+    }
+
+    header->sequence++;
+    __sync_synchronize();
+
+    memcpy(data, nodes, nodes_size);
+    memcpy(data + nodes_size, names, names_length);
+    header->data_size = data_size;
+    header->num_nodes = num_nodes;
+    header->focused = focused_index;
+
+    __sync_synchronize();
+    header->sequence++;
+}
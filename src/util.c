@@ -19,7 +19,6 @@
 #endif
 #include <fcntl.h>
 #include <pwd.h>
-#include <yajl/yajl_version.h>
 #include <libgen.h>
 
 #define SN_API_NOT_YET_FROZEN 1
@@ -47,6 +46,23 @@ Rect rect_add(Rect a, Rect b) {
                   a.height + b.height};
 }
 
+/*
+ * Shrinks either *width or *height, so that the result is the largest size
+ * with the aspect ratio ratio_width:ratio_height (rounded down to whole
+ * pixels) which fits into the original *width x *height.
+ *
+ */
+void fit_aspect_ratio(uint32_t *width, uint32_t *height, uint32_t ratio_width, uint32_t ratio_height) {
+    if (ratio_width == 0 || ratio_height == 0)
+        return;
+
+    /* The largest width w with w * ratio_height <= height * ratio_width. */
+    const uint64_t fit_width = ((uint64_t)*height * ratio_width) / ratio_height;
+    if (fit_width < *width)
+        *width = fit_width;
+    *height = ((uint64_t)*width * ratio_height) / ratio_width;
+}
+
 /*
  * Updates *destination with new_value and returns true if it was changed or false
  * if it was the same
@@ -111,7 +127,7 @@ void exec_i3_utility(char *name, char *argv[]) {
  *
  */
 void check_error(xcb_connection_t *conn, xcb_void_cookie_t cookie, char *err_message) {
-    xcb_generic_error_t *error = xcb_request_check(conn, cookie);
+    xcb_generic_error_t *error = X_WAIT(xcb_request_check, conn, cookie);
     if (error != NULL) {
         fprintf(stderr, "ERROR: %s (X error %d)\n", err_message , error->error_code);
         xcb_disconnect(conn);
@@ -183,29 +199,7 @@ static char **append_argument(char **original, char *argument) {
     return result;
 }
 
-#define y(x, ...) yajl_gen_ ## x (gen, ##__VA_ARGS__)
-#define ystr(str) yajl_gen_string(gen, (unsigned char*)str, strlen(str))
-
 char *store_restart_layout(void) {
-    setlocale(LC_NUMERIC, "C");
-#if YAJL_MAJOR >= 2
-    yajl_gen gen = yajl_gen_alloc(NULL);
-#else
-    yajl_gen gen = yajl_gen_alloc(NULL, NULL);
-#endif
-
-    dump_node(gen, croot, true);
-
-    setlocale(LC_NUMERIC, "");
-
-    const unsigned char *payload;
-#if YAJL_MAJOR >= 2
-    size_t length;
-#else
-    unsigned int length;
-#endif
-    y(get_buf, &payload, &length);
-
     /* create a temporary file if one hasn't been specified, or just
      * resolve the tildes in the specified path */
     char *filename;
@@ -224,36 +218,48 @@ char *store_restart_layout(void) {
         return NULL;
     }
 
-    int written = 0;
+    if (config.restart_state_binary) {
+        if (!restart_snapshot_store(fd)) {
+            free(filename);
+            close(fd);
+            return NULL;
+        }
+        close(fd);
+        return filename;
+    }
+
+    json_writer gen = { 0 };
+    dump_node(&gen, croot, true);
+
+    const unsigned char *payload;
+    size_t length;
+    json_writer_get_buf(&gen, &payload, &length);
+
+    size_t written = 0;
     while (written < length) {
-        int n = write(fd, payload + written, length - written);
+        ssize_t n = write(fd, payload + written, length - written);
         /* TODO: correct error-handling */
         if (n == -1) {
             perror("write()");
             free(filename);
             close(fd);
+            json_writer_free(&gen);
             return NULL;
         }
         if (n == 0) {
-            printf("write == 0?\n");
+            ELOG("write() returned 0, not storing the layout\n");
             free(filename);
             close(fd);
+            json_writer_free(&gen);
             return NULL;
         }
         written += n;
-#if YAJL_MAJOR >= 2
-        printf("written: %d of %zd\n", written, length);
-#else
-        printf("written: %d of %d\n", written, length);
-#endif
     }
     close(fd);
 
-    if (length > 0) {
-        printf("layout: %.*s\n", (int)length, payload);
-    }
+    DLOG("Wrote a layout of %zu bytes to %s\n", (size_t)length, filename);
 
-    y(free);
+    json_writer_free(&gen);
 
     return filename;
 }
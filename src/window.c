@@ -25,15 +25,18 @@ void window_update_class(i3Window *win, xcb_get_property_reply_t *prop, bool bef
 
     /* We cannot use asprintf here since this property contains two
      * null-terminated strings (for compatibility reasons). Instead, we
-     * use strdup() on both strings */
+     * intern both strings separately. */
     char *new_class = xcb_get_property_value(prop);
+    const size_t prop_len = xcb_get_property_value_length(prop);
+    const size_t instance_len = strnlen(new_class, prop_len);
 
-    FREE(win->class_instance);
-    FREE(win->class_class);
+    release_interned_string(win->class_instance);
+    release_interned_string(win->class_class);
 
-    win->class_instance = sstrdup(new_class);
-    if ((strlen(new_class) + 1) < xcb_get_property_value_length(prop))
-        win->class_class = sstrdup(new_class + strlen(new_class) + 1);
+    win->class_instance = intern_string_with_length(new_class, instance_len);
+    if ((instance_len + 1) < prop_len)
+        win->class_class = intern_string_with_length(new_class + instance_len + 1,
+                                                     strnlen(new_class + instance_len + 1, prop_len - instance_len - 1));
     else win->class_class = NULL;
     LOG("WM_CLASS changed to %s (instance), %s (class)\n",
         win->class_instance, win->class_class);
@@ -202,16 +205,9 @@ void window_update_role(i3Window *win, xcb_get_property_reply_t *prop, bool befo
         return;
     }
 
-    char *new_role;
-    if (asprintf(&new_role, "%.*s", xcb_get_property_value_length(prop),
-                 (char*)xcb_get_property_value(prop)) == -1) {
-        perror("asprintf()");
-        DLOG("Could not get WM_WINDOW_ROLE\n");
-        free(prop);
-        return;
-    }
-    FREE(win->role);
-    win->role = new_role;
+    release_interned_string(win->role);
+    win->role = intern_string_with_length(xcb_get_property_value(prop),
+                                          xcb_get_property_value_length(prop));
     LOG("WM_WINDOW_ROLE changed to \"%s\"\n", win->role);
 
     if (before_mgmt) {
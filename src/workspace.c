@@ -11,14 +11,30 @@
  *
  */
 #include "all.h"
-#include "yajl_utils.h"
+#include "json_utils.h"
 
-#include <yajl/yajl_gen.h>
 
 /* Stores a copy of the name of the last used workspace for the workspace
  * back-and-forth switching. */
 static char *previous_workspace_name = NULL;
 
+/* Index of all workspaces which are attached to the tree, by name key and by
+ * number, so that looking up a workspace does not need to walk all outputs.
+ * Since name keys are interned, they are hashed by pointer. */
+#define WS_INDEX_BUCKETS 64
+#define WS_NAME_BUCKET(key) ((((uintptr_t)(key)) >> 4) % WS_INDEX_BUCKETS)
+#define WS_NUM_BUCKET(num) ((num) % WS_INDEX_BUCKETS)
+static SLIST_HEAD(ws_index_head, Con) ws_by_name[WS_INDEX_BUCKETS],
+                                      ws_by_num[WS_INDEX_BUCKETS];
+
+/* The workspace names used in "workspace <name>" bindings of the current
+ * binding mode (in the order of the bindings), so that
+ * create_workspace_on_output() does not need to parse all bindings whenever
+ * an output is initialized. */
+static struct bindings_head *binding_names_source = NULL;
+static char **binding_names = NULL;
+static int num_binding_names = 0;
+
 /*
  * Sets ws->layout to splith/splitv if default_orientation was specified in the
  * configfile. Otherwise, it uses splith/splitv depending on whether the output
@@ -38,6 +54,174 @@ static void _workspace_apply_default_orientation(Con *ws) {
     }
 }
 
+/*
+ * Returns the interned, case-folded version of the given workspace name.
+ * Workspace names are compared case-insensitively, so two names refer to the
+ * same workspace if and only if their keys are the same pointer.
+ *
+ * If create is true, a reference is taken which has to be given back with
+ * release_interned_string(). Otherwise, no reference is taken and NULL is
+ * returned if the key was never interned, in which case no workspace can have
+ * that name.
+ *
+ */
+const char *workspace_name_key(const char *name, bool create) {
+    char *folded = sstrdup(name);
+    for (char *walk = folded; *walk != '\0'; walk++)
+        if (*walk >= 'A' && *walk <= 'Z')
+            *walk += ('a' - 'A');
+
+    const char *key = (create ? intern_string(folded) : lookup_interned_string(folded));
+    free(folded);
+    return key;
+}
+
+/*
+ * Adds the given workspace to the index of workspaces by name and by number.
+ * Called by con_attach() for every workspace, after its name_key was set.
+ *
+ */
+void workspace_index_add(Con *ws) {
+    SLIST_INSERT_HEAD(&(ws_by_name[WS_NAME_BUCKET(ws->name_key)]), ws, ws_by_name);
+    if (ws->num >= 0)
+        SLIST_INSERT_HEAD(&(ws_by_num[WS_NUM_BUCKET(ws->num)]), ws, ws_by_num);
+}
+
+/*
+ * Unlinks the workspace from one of the indexes. The bucket is only a hint:
+ * in case the name or number was changed while the workspace was attached,
+ * all buckets are searched.
+ *
+ */
+static void _workspace_index_unlink(struct ws_index_head *index, int bucket, Con *ws, bool by_name) {
+    for (int c = 0; c <= WS_INDEX_BUCKETS; c++) {
+        const int b = (c == 0 ? bucket : c - 1);
+        Con **walk = &SLIST_FIRST(&(index[b]));
+        while (*walk != NULL && *walk != ws)
+            walk = (by_name ? &SLIST_NEXT(*walk, ws_by_name) : &SLIST_NEXT(*walk, ws_by_num));
+        if (*walk == NULL)
+            continue;
+        *walk = (by_name ? SLIST_NEXT(ws, ws_by_name) : SLIST_NEXT(ws, ws_by_num));
+        return;
+    }
+}
+
+/*
+ * Removes the given workspace from the workspace index. Called by
+ * con_detach() for every workspace.
+ *
+ */
+void workspace_index_remove(Con *ws) {
+    _workspace_index_unlink(ws_by_name, WS_NAME_BUCKET(ws->name_key), ws, true);
+    _workspace_index_unlink(ws_by_num, (ws->num >= 0 ? WS_NUM_BUCKET(ws->num) : 0), ws, false);
+}
+
+/*
+ * Returns the existing workspace with the given name (compared
+ * case-insensitively) or NULL if there is no such workspace. Does not walk
+ * the tree.
+ *
+ */
+Con *workspace_by_name(const char *name) {
+    const char *key = workspace_name_key(name, false);
+    if (key == NULL)
+        return NULL;
+
+    Con *ws;
+    SLIST_FOREACH(ws, &(ws_by_name[WS_NAME_BUCKET(key)]), ws_by_name)
+        if (ws->name_key == key)
+            return ws;
+    return NULL;
+}
+
+/*
+ * Returns the existing workspace with the given number or NULL if there is no
+ * such workspace. If several workspaces share the number, the first one in
+ * tree order is returned.
+ *
+ */
+Con *workspace_by_number(int num) {
+    if (num < 0)
+        return NULL;
+
+    Con *ws, *found = NULL;
+    SLIST_FOREACH(ws, &(ws_by_num[WS_NUM_BUCKET(num)]), ws_by_num) {
+        if (ws->num != num)
+            continue;
+        if (found == NULL) {
+            found = ws;
+            continue;
+        }
+
+        /* Ambiguous (like "1: mail" and "1: web"), so we need the tree order
+         * to decide. */
+        Con *output;
+        found = NULL;
+        TAILQ_FOREACH(output, &(croot->nodes_head), nodes)
+            GREP_FIRST(found, output_get_content(output), child->num == num);
+        break;
+    }
+    return found;
+}
+
+/*
+ * Forgets the workspace names which were derived from the "workspace <name>"
+ * key bindings (see create_workspace_on_output()). Needs to be called
+ * whenever the bindings are freed, that is when reloading the configuration.
+ *
+ */
+void workspace_invalidate_binding_names(void) {
+    for (int c = 0; c < num_binding_names; c++)
+        free(binding_names[c]);
+    FREE(binding_names);
+    num_binding_names = 0;
+    binding_names_source = NULL;
+}
+
+/*
+ * Extracts the workspace names from all "workspace <name>" bindings of the
+ * current binding mode, unless that was already done for these bindings.
+ *
+ */
+static void _workspace_update_binding_names(void) {
+    if (binding_names_source == bindings)
+        return;
+
+    workspace_invalidate_binding_names();
+    binding_names_source = bindings;
+
+    Binding *bind;
+    TAILQ_FOREACH(bind, bindings, bindings) {
+        DLOG("binding with command %s\n", bind->command);
+        if (strlen(bind->command) < strlen("workspace ") ||
+            strncasecmp(bind->command, "workspace", strlen("workspace")) != 0)
+            continue;
+        DLOG("relevant command = %s\n", bind->command);
+        char *target = bind->command + strlen("workspace ");
+        /* We check if this is the workspace
+         * next/prev/next_on_output/prev_on_output/back_and_forth/number command.
+         * Beware: The workspace names "next", "prev", "next_on_output",
+         * "prev_on_output", "number", "back_and_forth" and "current" are OK,
+         * so we check before stripping the double quotes */
+        if (strncasecmp(target, "next", strlen("next")) == 0 ||
+            strncasecmp(target, "prev", strlen("prev")) == 0 ||
+            strncasecmp(target, "next_on_output", strlen("next_on_output")) == 0 ||
+            strncasecmp(target, "prev_on_output", strlen("prev_on_output")) == 0 ||
+            strncasecmp(target, "number", strlen("number")) == 0 ||
+            strncasecmp(target, "back_and_forth", strlen("back_and_forth")) == 0 ||
+            strncasecmp(target, "current", strlen("current")) == 0)
+            continue;
+        if (*target == '"')
+            target++;
+        char *name = sstrdup(target);
+        if (name[strlen(name)-1] == '"')
+            name[strlen(name)-1] = '\0';
+
+        binding_names = srealloc(binding_names, sizeof(char*) * (num_binding_names + 1));
+        binding_names[num_binding_names++] = name;
+    }
+}
+
 /*
  * Returns a pointer to the workspace with the given number (starting at 0),
  * creating the workspace if necessary (by allocating the necessary amount of
@@ -45,10 +229,7 @@ static void _workspace_apply_default_orientation(Con *ws) {
  *
  */
 Con *workspace_get(const char *num, bool *created) {
-    Con *output, *workspace = NULL;
-
-    TAILQ_FOREACH(output, &(croot->nodes_head), nodes)
-        GREP_FIRST(workspace, output_get_content(output), !strcasecmp(child->name, num));
+    Con *output, *workspace = workspace_by_name(num);
 
     if (workspace == NULL) {
         LOG("Creating new workspace \"%s\"\n", num);
@@ -113,41 +294,16 @@ Con *workspace_get(const char *num, bool *created) {
  */
 Con *create_workspace_on_output(Output *output, Con *content) {
     /* add a workspace to this output */
-    Con *out, *current;
     char *name;
     bool exists = true;
     Con *ws = con_new(NULL, NULL);
     ws->type = CT_WORKSPACE;
 
     /* try the configured workspace bindings first to find a free name */
-    Binding *bind;
-    TAILQ_FOREACH(bind, bindings, bindings) {
-        DLOG("binding with command %s\n", bind->command);
-        if (strlen(bind->command) < strlen("workspace ") ||
-            strncasecmp(bind->command, "workspace", strlen("workspace")) != 0)
-            continue;
-        DLOG("relevant command = %s\n", bind->command);
-        char *target = bind->command + strlen("workspace ");
-        /* We check if this is the workspace
-         * next/prev/next_on_output/prev_on_output/back_and_forth/number command.
-         * Beware: The workspace names "next", "prev", "next_on_output",
-         * "prev_on_output", "number", "back_and_forth" and "current" are OK,
-         * so we check before stripping the double quotes */
-        if (strncasecmp(target, "next", strlen("next")) == 0 ||
-            strncasecmp(target, "prev", strlen("prev")) == 0 ||
-            strncasecmp(target, "next_on_output", strlen("next_on_output")) == 0 ||
-            strncasecmp(target, "prev_on_output", strlen("prev_on_output")) == 0 ||
-            strncasecmp(target, "number", strlen("number")) == 0 ||
-            strncasecmp(target, "back_and_forth", strlen("back_and_forth")) == 0 ||
-            strncasecmp(target, "current", strlen("current")) == 0)
-            continue;
-        if (*target == '"')
-            target++;
-        FREE(ws->name);
-        ws->name = strdup(target);
-        if (ws->name[strlen(ws->name)-1] == '"')
-            ws->name[strlen(ws->name)-1] = '\0';
-        DLOG("trying name *%s*\n", ws->name);
+    _workspace_update_binding_names();
+    for (int c = 0; c < num_binding_names; c++) {
+        const char *target = binding_names[c];
+        DLOG("trying name *%s*\n", target);
 
         /* Ensure that this workspace is not assigned to a different output —
          * otherwise we would create it, then move it over to its output, then
@@ -155,7 +311,7 @@ Con *create_workspace_on_output(Output *output, Con *content) {
         bool assigned = false;
         struct Workspace_Assignment *assignment;
         TAILQ_FOREACH(assignment, &ws_assignments, ws_assignments) {
-            if (strcmp(assignment->name, ws->name) != 0 ||
+            if (strcmp(assignment->name, target) != 0 ||
                 strcmp(assignment->output, output->name) == 0)
                 continue;
 
@@ -166,12 +322,10 @@ Con *create_workspace_on_output(Output *output, Con *content) {
         if (assigned)
             continue;
 
-        current = NULL;
-        TAILQ_FOREACH(out, &(croot->nodes_head), nodes)
-            GREP_FIRST(current, output_get_content(out), !strcasecmp(child->name, ws->name));
-
-        exists = (current != NULL);
+        exists = (workspace_by_name(target) != NULL);
         if (!exists) {
+            FREE(ws->name);
+            ws->name = sstrdup(target);
             /* Set ->num to the number of the workspace, if the name actually
              * is a number or starts with a number */
             char *endptr = NULL;
@@ -198,10 +352,7 @@ Con *create_workspace_on_output(Output *output, Con *content) {
             FREE(ws->name);
             sasprintf(&(ws->name), "%d", c);
 
-            current = NULL;
-            TAILQ_FOREACH(out, &(croot->nodes_head), nodes)
-                GREP_FIRST(current, output_get_content(out), !strcasecmp(child->name, ws->name));
-            exists = (current != NULL);
+            exists = (workspace_by_name(ws->name) != NULL);
 
             DLOG("result for ws %s / %d: exists = %d\n", ws->name, c, exists);
         }
@@ -301,9 +452,10 @@ static void workspace_reassign_sticky(Con *con) {
         }
 
         x_move_win(src, current);
-        current->window = src->window;
+        i3Window *window = src->window;
+        con_set_window(src, NULL);
+        con_set_window(current, window);
         current->mapped = true;
-        src->window = NULL;
         src->mapped = false;
 
         x_reparent_child(current, src);
@@ -325,7 +477,7 @@ static void workspace_defer_update_urgent_hint_cb(EV_P_ ev_timer *w, int revents
     Con *con = w->data;
 
     DLOG("Resetting urgency flag of con %p by timer\n", con);
-    con->urgent = false;
+    con_set_urgent_flag(con, false);
     con_update_parents_urgency(con);
     workspace_update_urgent_flag(con_get_workspace(con));
     tree_render();
@@ -339,18 +491,22 @@ static void workspace_defer_update_urgent_hint_cb(EV_P_ ev_timer *w, int revents
  * current and previous workspace, in "current" and "old" respectively.
  */
 static void ipc_send_workspace_focus_event(Con *current, Con *old) {
-    setlocale(LC_NUMERIC, "C");
-    yajl_gen gen = ygenalloc();
+    if (!ipc_has_subscribers("workspace"))
+        return;
+
+    static json_writer writer;
+    json_writer *gen = &writer;
+    json_writer_reset(gen);
 
     y(map_open);
 
-    ystr("change");
+    ykey("change");
     ystr("focus");
 
-    ystr("current");
+    ykey("current");
     dump_node(gen, current, false);
 
-    ystr("old");
+    ykey("old");
     if (old == NULL)
         y(null);
     else
@@ -359,12 +515,10 @@ static void ipc_send_workspace_focus_event(Con *current, Con *old) {
     y(map_close);
 
     const unsigned char *payload;
-    ylength length;
+    size_t length;
     y(get_buf, &payload, &length);
 
     ipc_send_event("workspace", I3_IPC_EVENT_WORKSPACE, (const char *)payload);
-    y(free);
-    setlocale(LC_NUMERIC, "");
 }
 
 static void _workspace_show(Con *workspace) {
@@ -422,7 +576,7 @@ static void _workspace_show(Con *workspace) {
         /* … but immediately reset urgency flags; they will be set to false by
          * the timer callback in case the container is focused at the time of
          * its expiration */
-        focused->urgent = true;
+        con_set_urgent_flag(focused, true);
         workspace->urgent = true;
 
         if (focused->urgency_timer == NULL) {
@@ -773,27 +927,14 @@ Con *workspace_back_and_forth_get(void) {
     return workspace;
 }
 
-static bool get_urgency_flag(Con *con) {
-    Con *child;
-    TAILQ_FOREACH(child, &(con->nodes_head), nodes)
-        if (child->urgent || get_urgency_flag(child))
-            return true;
-
-    TAILQ_FOREACH(child, &(con->floating_head), floating_windows)
-        if (child->urgent || get_urgency_flag(child))
-            return true;
-
-    return false;
-}
-
 /*
- * Goes through all clients on the given workspace and updates the workspace’s
- * urgent flag accordingly.
+ * Updates the workspace’s urgent flag according to whether there are urgent
+ * windows on it.
  *
  */
 void workspace_update_urgent_flag(Con *ws) {
     bool old_flag = ws->urgent;
-    ws->urgent = get_urgency_flag(ws);
+    ws->urgent = (ws->urgent_windows > 0);
     DLOG("Workspace urgency flag changed from %d to %d\n", old_flag, ws->urgent);
 
     if (old_flag != ws->urgent)
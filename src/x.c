@@ -64,6 +64,8 @@ CIRCLEQ_HEAD(state_head, con_state) state_head =
 CIRCLEQ_HEAD(old_state_head, con_state) old_state_head =
     CIRCLEQ_HEAD_INITIALIZER(old_state_head);
 
+struct pool con_state_pool = POOL_INITIALIZER("con_state", struct con_state);
+
 /*
  * Returns the container state for the given frame. This function always
  * returns a container state (otherwise, there is a bug in the code and the
@@ -143,7 +145,7 @@ void x_con_init(Con *con, uint16_t depth) {
     if (win_colormap != XCB_NONE)
         xcb_free_colormap(conn, win_colormap);
 
-    struct con_state *state = scalloc(sizeof(struct con_state));
+    struct con_state *state = pool_alloc(&con_state_pool);
     state->id = con->frame;
     state->mapped = false;
     state->initial = true;
@@ -230,7 +232,7 @@ void x_con_kill(Con *con) {
     CIRCLEQ_REMOVE(&state_head, state, state);
     CIRCLEQ_REMOVE(&old_state_head, state, old_state);
     FREE(state->name);
-    free(state);
+    pool_free(&con_state_pool, state);
 
     /* Invalidate focused_id to correctly focus new windows with the same ID */
     focused_id = XCB_NONE;
@@ -246,7 +248,7 @@ bool window_supports_protocol(xcb_window_t window, xcb_atom_t atom) {
     bool result = false;
 
     cookie = xcb_icccm_get_wm_protocols(conn, window, A_WM_PROTOCOLS);
-    if (xcb_icccm_get_wm_protocols_reply(conn, cookie, &protocols, NULL) != 1)
+    if (X_WAIT(xcb_icccm_get_wm_protocols_reply, conn, cookie, &protocols, NULL) != 1)
         return false;
 
     /* Check if the client’s protocols have the requested atom set */
@@ -329,8 +331,12 @@ void x_draw_decoration(Con *con) {
     if (leaf && con->pixmap == XCB_NONE)
         return;
 
-    /* 1: build deco_params and compare with cache */
-    struct deco_render_params *p = scalloc(sizeof(struct deco_render_params));
+    /* 1: build deco_params and compare with cache. The parameters are built
+     * on the stack, they only need to be copied into the cache on a miss. The
+     * memset() is necessary because memcmp() compares the padding, too. */
+    struct deco_render_params params;
+    struct deco_render_params *p = &params;
+    memset(p, 0, sizeof(struct deco_render_params));
 
     /* find out which colors to use */
     if (con->urgent)
@@ -358,17 +364,17 @@ void x_draw_decoration(Con *con) {
         !parent->pixmap_recreated &&
         !con->pixmap_recreated &&
         memcmp(p, con->deco_render_params, sizeof(struct deco_render_params)) == 0) {
-        free(p);
         goto copy_pixmaps;
     }
 
     Con *next = con;
     while ((next = TAILQ_NEXT(next, nodes))) {
-        FREE(next->deco_render_params);
+        POOL_FREE(&deco_render_params_pool, next->deco_render_params);
     }
 
-    FREE(con->deco_render_params);
-    con->deco_render_params = p;
+    if (con->deco_render_params == NULL)
+        con->deco_render_params = pool_alloc(&deco_render_params_pool);
+    memcpy(con->deco_render_params, p, sizeof(struct deco_render_params));
 
     if (con->window != NULL && con->window->name_x_changed)
         con->window->name_x_changed = false;
@@ -916,7 +922,7 @@ void x_push_changes(Con *con) {
     x_push_node(con);
 
     if (warp_to) {
-        xcb_query_pointer_reply_t *pointerreply = xcb_query_pointer_reply(conn, pointercookie, NULL);
+        xcb_query_pointer_reply_t *pointerreply = X_WAIT(xcb_query_pointer_reply, conn, pointercookie, NULL);
         if (!pointerreply) {
             ELOG("Could not query pointer position, not warping pointer\n");
         } else {
@@ -943,7 +949,9 @@ void x_push_changes(Con *con) {
     }
     //DLOG("Done, EnterNotify re-enabled\n");
 
+    const uint64_t deco_start = latency_now();
     x_deco_recurse(con);
+    LATENCY_RECORD(LATENCY_X_DECO_RECURSE, deco_start);
 
     xcb_window_t to_focus = focused->frame;
     if (focused->window != NULL)
@@ -1023,6 +1031,8 @@ void x_push_changes(Con *con) {
     //}
 
     xcb_flush(conn);
+
+    tree_snapshot_publish();
 }
 
 /*
@@ -1077,6 +1087,8 @@ void x_set_i3_atoms(void) {
                         strlen(current_configpath), current_configpath);
     xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, A_I3_SHMLOG_PATH, A_UTF8_STRING, 8,
                         strlen(shmlogname), shmlogname);
+    xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, A_I3_SHMTREE_PATH, A_UTF8_STRING, 8,
+                        strlen(shmtreename), shmtreename);
 }
 
 /*
@@ -0,0 +1,254 @@
+#undef I3__FILE__
+#define I3__FILE__ "x_stats.c"
+/*
+ * vim:ts=4:sw=4:expandtab
+ *
+ * i3 - an improved dynamic tiling window manager
+ * © 2009-2013 Michael Stapelberg and contributors (see also: LICENSE)
+ *
+ * x_stats.c: Accounting of X11 requests and blocking round-trips, per
+ *            tree_render(), per handled event and per call site.
+ *
+ * Requests are counted using the sequence number of the last request which
+ * xcb_take_socket() returns, so nothing needs to be wrapped to count them and
+ * no additional requests are sent. Note that xcb_take_socket() flushes the
+ * output buffer first: requests which are still queued when a span begins or
+ * ends are written right away instead of with the next flush (in the event
+ * loop or in x_push_changes()). This costs at most one extra write() per
+ * span and changes how requests are batched, but not which requests are
+ * sent. When the buffer is empty (e.g. after x_push_changes() at the end of
+ * a render), nothing is written.
+ *
+ * Blocking waits for replies are accounted by the X_WAIT() macro at every
+ * call site, in i3 and in libi3 (fonts, modifier mapping), which calls
+ * x_stats_record_wait() through x_wait_hook.
+ *
+ * Every render (and every event which caused requests or round-trips) is
+ * also logged, so that the numbers end up in the SHM log and can be filtered
+ * with i3-dump-log -m x_stats.c.
+ *
+ */
+#include "all.h"
+#include "json_utils.h"
+
+#include <inttypes.h>
+#include <xcb/xcbext.h>
+
+/* Sum of the requests/round-trips of all spans of one kind. */
+struct x_stats_aggregate {
+    uint64_t count;
+    uint64_t requests;
+    uint64_t round_trips;
+    uint64_t wait_ns;
+    uint64_t max_requests;
+    uint64_t max_round_trips;
+};
+
+/* All waits so far, the spans take the difference. */
+static uint64_t total_round_trips;
+static uint64_t total_wait_ns;
+
+static struct x_stats_aggregate renders;
+/* One aggregate per event type (without the "generated" bit). */
+static struct x_stats_aggregate events[128];
+
+/* All call sites which waited at least once (linked by their next
+ * pointer, x_call_site is defined in libi3). */
+static x_call_site *sites;
+
+/* The sequence number of the last request we know was sent (used when the
+ * connection is broken). */
+static uint64_t last_sent;
+
+/*
+ * Called by xcb when it needs the socket back after xcb_take_socket(). We
+ * never write to the socket ourselves, so there is nothing to do.
+ *
+ */
+static void return_socket(void *closure) {
+}
+
+/*
+ * Returns the sequence number of the last request which was sent (after
+ * flushing the output buffer, see the comment at the top of this file).
+ *
+ */
+static uint64_t requests_sent(void) {
+    uint64_t sent;
+    if (xcb_take_socket(conn, return_socket, NULL, 0, &sent))
+        last_sent = sent;
+    return last_sent;
+}
+
+/*
+ * Accounts a wait which started at start (a return value of latency_now())
+ * to the given call site. Installed as x_wait_hook by main(), so that the
+ * X_WAIT() call sites in i3 and in libi3 are accounted.
+ *
+ */
+void x_stats_record_wait(x_call_site *site, uint64_t start) {
+    const uint64_t ns = latency_now() - start;
+
+    if (!site->registered) {
+        site->next = sites;
+        sites = site;
+        site->registered = true;
+    }
+    site->count++;
+    site->wait_ns += ns;
+    if (ns > site->max_wait_ns)
+        site->max_wait_ns = ns;
+
+    total_round_trips++;
+    total_wait_ns += ns;
+}
+
+/*
+ * Starts a span: the requests and round-trips until x_stats_end_render() or
+ * x_stats_end_event() are accounted to it.
+ *
+ */
+void x_stats_begin(x_stats_span *span) {
+    span->sent = requests_sent();
+    span->round_trips = total_round_trips;
+    span->wait_ns = total_wait_ns;
+}
+
+/*
+ * Turns the span into the numbers of the span itself (instead of the counters
+ * at its start) and adds them to the aggregate.
+ *
+ */
+static void end_span(x_stats_span *span, struct x_stats_aggregate *aggregate) {
+    span->sent = requests_sent() - span->sent;
+    span->round_trips = total_round_trips - span->round_trips;
+    span->wait_ns = total_wait_ns - span->wait_ns;
+
+    aggregate->count++;
+    aggregate->requests += span->sent;
+    aggregate->round_trips += span->round_trips;
+    aggregate->wait_ns += span->wait_ns;
+    if (span->sent > aggregate->max_requests)
+        aggregate->max_requests = span->sent;
+    if (span->round_trips > aggregate->max_round_trips)
+        aggregate->max_round_trips = span->round_trips;
+}
+
+/*
+ * Ends a span which covered a tree_render().
+ *
+ */
+void x_stats_end_render(x_stats_span *span) {
+    end_span(span, &renders);
+    DLOG("render: %" PRIu64 " requests, %" PRIu64 " round-trips (%" PRIu64 " us waiting)\n",
+         span->sent, span->round_trips, span->wait_ns / 1000);
+}
+
+/*
+ * Ends a span which covered handling an event of the given type.
+ *
+ */
+void x_stats_end_event(x_stats_span *span, int type) {
+    end_span(span, &events[type & 0x7F]);
+    if (span->sent == 0 && span->round_trips == 0)
+        return;
+
+    char buffer[32];
+    DLOG("event %s: %" PRIu64 " requests, %" PRIu64 " round-trips (%" PRIu64 " us waiting)\n",
+         event_type_name(type & 0x7F, buffer, sizeof(buffer)),
+         span->sent, span->round_trips, span->wait_ns / 1000);
+}
+
+static void dump_aggregate(json_writer *gen, const struct x_stats_aggregate *aggregate) {
+    ykey("count");
+    y(integer, aggregate->count);
+
+    ykey("requests");
+    y(integer, aggregate->requests);
+
+    ykey("round_trips");
+    y(integer, aggregate->round_trips);
+
+    ykey("wait_us");
+    y(integer, aggregate->wait_ns / 1000);
+
+    ykey("max_requests");
+    y(integer, aggregate->max_requests);
+
+    ykey("max_round_trips");
+    y(integer, aggregate->max_round_trips);
+}
+
+/*
+ * Generates the X11 statistics as a JSON map with the keys "renders",
+ * "events" and "call_sites".
+ *
+ */
+void x_stats_dump(json_writer *gen) {
+    y(map_open);
+
+    ykey("renders");
+    y(map_open);
+    dump_aggregate(gen, &renders);
+    y(map_close);
+
+    ykey("events");
+    y(array_open);
+    for (int type = 0; type < 128; type++) {
+        if (events[type].count == 0)
+            continue;
+        char buffer[32];
+        y(map_open);
+        ykey("name");
+        ystr(event_type_name(type, buffer, sizeof(buffer)));
+        dump_aggregate(gen, &events[type]);
+        y(map_close);
+    }
+    y(array_close);
+
+    ykey("call_sites");
+    y(array_open);
+    for (x_call_site *site = sites; site != NULL; site = site->next) {
+        if (site->count == 0)
+            continue;
+        y(map_open);
+        ykey("file");
+        ystr(site->file);
+
+        ykey("line");
+        y(integer, site->line);
+
+        ykey("function");
+        ystr(site->function);
+
+        ykey("count");
+        y(integer, site->count);
+
+        ykey("wait_us");
+        y(integer, site->wait_ns / 1000);
+
+        ykey("max_wait_us");
+        y(integer, site->max_wait_ns / 1000);
+        y(map_close);
+    }
+    y(array_close);
+
+    y(map_close);
+}
+
+/*
+ * Resets all X11 statistics.
+ *
+ */
+void x_stats_reset(void) {
+    memset(&renders, 0, sizeof(renders));
+    memset(events, 0, sizeof(events));
+
+    /* The sites stay registered (they are static variables at the call
+     * sites), only their numbers are reset. */
+    for (x_call_site *site = sites; site != NULL; site = site->next) {
+        site->count = 0;
+        site->wait_ns = 0;
+        site->max_wait_ns = 0;
+    }
+}
@@ -105,6 +105,8 @@ sub activate_i3 {
 
         if ($args{restart}) {
             $i3cmd .= ' -L ' . abs_path('restart-state.golden');
+        } elsif ($args{restart_state}) {
+            $i3cmd .= ' -L ' . abs_path($args{restart_state});
         }
 
         if ($args{valgrind}) {
@@ -809,6 +809,9 @@ tests which test specific config file directives.
 
   exit_gracefully($pid);
 
+Pass C<< restart_state => $path >> to make i3 restore the layout from the
+given file (like the C<-L> command line option does).
+
 =cut
 sub launch_with_config {
     my ($config, %args) = @_;
@@ -844,6 +847,7 @@ sub launch_with_config {
         strace => $ENV{STRACE},
         xtrace => $ENV{XTRACE},
         restart => $ENV{RESTART},
+        restart_state => $args{restart_state},
         cv => $cv,
         dont_create_temp_dir => $args{dont_create_temp_dir},
     );
@@ -42,5 +42,16 @@ my $rect = $win->rect;
 my $ar = $rect->width / $rect->height;
 diag("Aspect ratio = $ar");
 ok(($ar > 1.90) && ($ar < 2.10), 'Aspect ratio about 2.0');
+cmp_ok(abs($rect->width - 2 * $rect->height), '<=', 1, 'Aspect ratio 2:1 up to one pixel');
+
+################################################################################
+# Floating windows are resized to obey the aspect ratio.
+################################################################################
+
+cmd 'floating enable';
+sync_with_i3;
+
+$rect = $win->rect;
+cmp_ok(abs($rect->width - 2 * $rect->height), '<=', 1, 'floating: Aspect ratio 2:1 up to one pixel');
 
 done_testing;
@@ -163,6 +163,15 @@ cmd 'scratchpad show';
 cmd 'workspace back_and_forth';
 is(focused_ws, '6: baz', 'workspace 6 now focused');
 
+################################################################################
+# Only the exact name of the focused workspace triggers back and forth: the
+# same name with a different case refers to the focused workspace, too, but
+# stays on it.
+################################################################################
+
+cmd 'workspace 6: BAZ';
+is(focused_ws, '6: baz', 'workspace 6 still focused');
+
 exit_gracefully($pid);
 
 done_testing;
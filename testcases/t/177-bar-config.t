@@ -62,6 +62,7 @@ my $bar_id = shift @$bars;
 my $bar_config = $i3->get_bar_config($bar_id)->recv;
 is($bar_config->{status_command}, 'i3status --foo', 'status_command correct');
 ok(!$bar_config->{verbose}, 'verbose off by default');
+is($bar_config->{status_interval}, 0, 'no status interval by default');
 ok($bar_config->{workspace_buttons}, 'workspace buttons enabled per default');
 is($bar_config->{mode}, 'dock', 'dock mode by default');
 is($bar_config->{position}, 'bottom', 'position bottom by default');
@@ -88,6 +89,7 @@ bar {
     # Start a default instance of i3bar which provides workspace buttons.
     # Additionally, i3status will provide a statusline.
     status_command i3status --bar
+    status_interval 250 ms
 
     output HDMI1
     output HDMI2
@@ -123,6 +125,7 @@ $bar_id = shift @$bars;
 
 $bar_config = $i3->get_bar_config($bar_id)->recv;
 is($bar_config->{status_command}, 'i3status --bar', 'status_command correct');
+is($bar_config->{status_interval}, 250, 'status_interval correct');
 ok($bar_config->{verbose}, 'verbose on');
 ok(!$bar_config->{workspace_buttons}, 'workspace buttons disabled');
 is($bar_config->{mode}, 'dock', 'dock mode');
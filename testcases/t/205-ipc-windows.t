@@ -33,16 +33,43 @@ my $new = AnyEvent->condvar;
 $i3->subscribe({
     window => sub {
         my ($event) = @_;
-        $new->send($event->{change} eq 'new');
+        $new->send($event);
     }
 })->recv;
 
-open_window;
+my $window = open_window;
 
 my $t;
-$t = AnyEvent->timer(after => 0.5, cb => sub { $new->send(0); });
+$t = AnyEvent->timer(after => 0.5, cb => sub { $new->send(undef); });
 
-ok($new->recv, 'Window "new" event received');
+my $event = $new->recv;
+ok(defined($event) && $event->{change} eq 'new', 'Window "new" event received');
+
+################################
+# The container is dumped like in
+# GET_TREE, minus its children
+################################
+
+sub find_window_con {
+    my ($con, $id) = @_;
+    return $con if defined($con->{window}) && $con->{window} == $id;
+    for my $child (@{$con->{nodes}}, @{$con->{floating_nodes}}) {
+        my $found = find_window_con($child, $id);
+        return $found if defined($found);
+    }
+    return undef;
+}
+
+# The event is sent after the tree was rendered, so the container has not
+# changed since then.
+sync_with_i3;
+my $tree_con = find_window_con($i3->get_tree->recv, $window->id);
+ok(defined($tree_con), 'window found in the tree');
+
+# dump_event_node() does not dump the children (but still their IDs in
+# "focus").
+my %expected = (%$tree_con, nodes => [], floating_nodes => []);
+is_deeply($event->{container}, \%expected, 'event container matches the GET_TREE node');
 
 }
 
@@ -0,0 +1,63 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Tests the standalone regex binary to verify that literal patterns (which
+# bypass PCRE) and memoized results behave exactly like PCRE itself.
+#
+use i3test i3_autostart => 0;
+use IPC::Run qw(run);
+
+sub regex_matches {
+    my ($pattern, @inputs) = @_;
+
+    my ($stdout, $stderr);
+    run [ '../test.regex', $pattern, @inputs ],
+        '>', \$stdout,
+        '2>', \$stderr;
+
+    is($stderr, '', "no mismatch against PCRE for $pattern");
+    return [ split("\n", $stdout) ];
+}
+
+is_deeply(regex_matches('Firefox', 'Firefox', 'Navigator Firefox', 'firefox'),
+          [ 'match', 'match', 'no match' ],
+          'substring literal ok');
+
+is_deeply(regex_matches('^urxvt', 'urxvt', 'urxvt-256color', 'xurxvt'),
+          [ 'match', 'match', 'no match' ],
+          'prefix literal ok');
+
+is_deeply(regex_matches('term$', 'xterm', "xterm\n", 'terminal'),
+          [ 'match', 'match', 'no match' ],
+          'suffix literal ok');
+
+is_deeply(regex_matches('^Gimp$', 'Gimp', "Gimp\n", 'Gimp-2.8', 'gimp'),
+          [ 'match', 'match', 'no match', 'no match' ],
+          'exact literal ok');
+
+is_deeply(regex_matches('^Gimp\.2$', 'Gimp.2', 'Gimpx2'),
+          [ 'match', 'no match' ],
+          'escaped punctuation literal ok');
+
+is_deeply(regex_matches('^(?i)gimp', 'GIMP', 'gimp', 'xgimp'),
+          [ 'match', 'match', 'no match' ],
+          'non-literal pattern ok');
+
+is_deeply(regex_matches('^foo\d+$', 'foo1', 'foo1', 'foo', 'foo1'),
+          [ 'match', 'match', 'no match', 'match' ],
+          'memoized results ok');
+
+done_testing;
@@ -0,0 +1,160 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that in-place restarts using the binary layout snapshot
+# (restart_state_format binary) restore the same tree as the JSON layout, and
+# compares how long both take with 500 containers. Also verifies that i3
+# starts with a fresh tree when the snapshot is truncated.
+#
+use i3test i3_autostart => 0;
+use Time::HiRes qw(time);
+
+# Returns the tree without container IDs (which change on every restart). The
+# focus stacks are converted to indices into the list of children.
+sub normalize {
+    my ($con) = @_;
+    my @children = (@{$con->{nodes}}, @{$con->{floating_nodes}});
+    my %index = map { ($children[$_]->{id} => $_) } 0 .. $#children;
+    return {
+        (map { ($_ => $con->{$_}) } grep { !/^(id|nodes|floating_nodes|focus)$/ } keys %$con),
+        nodes => [ map { normalize($_) } @{$con->{nodes}} ],
+        floating_nodes => [ map { normalize($_) } @{$con->{floating_nodes}} ],
+        focus => [ map { $index{$_} } @{$con->{focus}} ],
+    };
+}
+
+sub normalized_tree {
+    return normalize(i3(get_socket_path())->get_tree->recv);
+}
+
+sub timed_restart {
+    my $start = time();
+    cmd 'restart';
+    does_i3_live;
+    return time() - $start;
+}
+
+my %duration;
+for my $format (qw(json binary)) {
+    my $config = <<EOT;
+# i3 config file (v4)
+font -misc-fixed-medium-r-normal--13-120-75-75-C-70-iso10646-1
+
+restart_state_format $format
+EOT
+
+    my $pid = launch_with_config($config);
+
+    ############################################################################
+    # A small layout with windows, marks, floating and stacked containers.
+    ############################################################################
+
+    my $tmp = fresh_workspace;
+    open_window(name => 'first');
+    cmd 'mark first';
+    cmd 'split v';
+    open_window(name => 'second');
+    cmd 'layout stacking';
+    open_window(name => 'floating');
+    cmd 'floating enable';
+    cmd 'focus tiling';
+
+    my $other = fresh_workspace;
+    cmd 'open';
+    cmd 'split h';
+    cmd 'open';
+    cmd 'focus left';
+    cmd "workspace $tmp";
+
+    my $before = normalized_tree;
+    timed_restart;
+    is_deeply(normalized_tree, $before, "$format: tree restored");
+
+    ############################################################################
+    # 500 containers, to compare the time it takes to restart.
+    ############################################################################
+
+    for my $ws (1 .. 10) {
+        fresh_workspace;
+        cmd join('; ', ('open') x 50);
+    }
+
+    $before = normalized_tree;
+    $duration{$format} = timed_restart;
+    is_deeply(normalized_tree, $before, "$format: tree with 500 containers restored");
+
+    exit_gracefully($pid);
+}
+
+diag(sprintf('in-place restart with 500 containers: JSON %.3f s, binary %.3f s',
+             $duration{json}, $duration{binary}));
+
+################################################################################
+# A truncated snapshot is not loaded at all. The workspaces which were
+# completely read before the end of the file must not stay in the workspace
+# index after they are freed, so switching to workspaces with the same names
+# in the fresh tree has to work.
+################################################################################
+
+my $state = "/tmp/i3-restart-state-$ENV{DISPLAY}-$$";
+my $kept = "$state.kept";
+unlink($state, $kept);
+
+# i3 unlinks the snapshot after loading it, but it overwrites the existing
+# file, so a second link to it keeps the snapshot around.
+open(my $fh, '>', $state) or die "could not create $state: $!";
+close($fh);
+link($state, $kept) or die "could not link $state to $kept: $!";
+
+my $config = <<EOT;
+# i3 config file (v4)
+font -misc-fixed-medium-r-normal--13-120-75-75-C-70-iso10646-1
+
+restart_state_format binary
+restart_state $state
+EOT
+
+my $pid = launch_with_config($config);
+
+for my $name (qw(trunc-a trunc-b trunc-c)) {
+    cmd "workspace $name";
+    cmd 'open';
+}
+cmd 'restart';
+does_i3_live;
+exit_gracefully($pid);
+
+my $size = -s $kept;
+ok($size > 16, 'snapshot written');
+truncate($kept, $size - 16) or die "could not truncate $kept: $!";
+
+$pid = launch_with_config($config, restart_state => $kept);
+
+ok(!(grep { /^trunc-/ } @{get_workspace_names()}), 'truncated snapshot not loaded');
+
+cmd 'workspace trunc-a';
+cmd 'open';
+cmd 'workspace trunc-b';
+cmd 'workspace trunc-a';
+does_i3_live;
+is(focused_ws, 'trunc-a', 'switched workspaces after the fallback');
+is_deeply([ grep { /^trunc-/ } @{get_workspace_names()} ], [ 'trunc-a' ],
+          'only the new workspace exists');
+
+exit_gracefully($pid);
+unlink($state, $kept);
+
+done_testing;
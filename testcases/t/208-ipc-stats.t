@@ -0,0 +1,127 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that the allocator statistics can be requested via IPC (GET_STATS)
+# and that closed containers are re-used from their pool. Also verifies the
+# latency histograms, the X11 request accounting and resetting them.
+use i3test;
+
+my $i3 = i3(get_socket_path());
+$i3->connect->recv;
+
+sub pools {
+    my $stats = $i3->message(8, "")->recv;
+    return { map { ($_->{name} => $_) } @{$stats->{allocators}} };
+}
+
+my $pools = pools;
+ok(exists($pools->{$_}), "pool $_ is used") for qw(con con_state);
+
+my $tmp = fresh_workspace;
+my @windows = map { open_window } 1 .. 5;
+
+$pools = pools;
+my $con = $pools->{con};
+cmp_ok($con->{in_use}, '<=', $con->{peak_in_use}, 'in_use <= peak_in_use');
+is($con->{in_use} + $con->{free}, $con->{bytes} / $con->{object_size},
+   'in_use + free objects fill the slabs');
+ok(exists($pools->{window}), 'window pool is used');
+is($pools->{window}->{in_use}, scalar @windows, 'one window object per window')
+    or diag(explain($pools->{window}));
+
+my $slabs = $con->{slabs};
+
+# Closing and opening windows again must not need new slabs.
+for (1 .. 3) {
+    $_->destroy for @windows;
+    sync_with_i3;
+    @windows = map { open_window } 1 .. 5;
+}
+
+$pools = pools;
+is($pools->{con}->{slabs}, $slabs, 'no new slabs for re-opened windows');
+is($pools->{window}->{in_use}, scalar @windows, 'closed windows were freed');
+
+################################################################################
+# Latency histograms
+################################################################################
+
+sub latency {
+    my ($payload) = @_;
+    my $latency = $i3->message(8, $payload // "")->recv->{latency};
+    return { map { my $kind = $_; ($kind => { map { ($_->{name} => $_) } @{$latency->{$kind}} }) }
+             qw(stages events ipc) };
+}
+
+my $latency = latency;
+is_deeply([ sort keys %{$latency->{stages}} ],
+          [ sort qw(parse_command render_con x_push_changes x_deco_recurse manage_window) ],
+          'all stages are reported');
+
+my $manage = $latency->{stages}->{manage_window};
+cmp_ok($manage->{count}, '>=', 20, 'every window was measured');
+my $sum = 0;
+$sum += $_ for @{$manage->{buckets}};
+is($sum, $manage->{count}, 'buckets add up to the count');
+cmp_ok($manage->{max_us}, '<=', $manage->{total_us}, 'max_us <= total_us');
+ok(exists($latency->{events}->{MapRequest}), 'MapRequest events are measured');
+ok(exists($latency->{ipc}->{get_stats}), 'IPC messages are measured');
+
+sub x11_sites {
+    my ($x11) = @_;
+    return { map { ("$_->{file}:$_->{function}" => $_) } @{$x11->{call_sites}} };
+}
+
+my $x11 = $i3->message(8, "")->recv->{x11};
+cmp_ok($x11->{renders}->{count}, '>', 0, 'renders are accounted');
+cmp_ok($x11->{renders}->{requests}, '>', 0, 'renders send requests');
+cmp_ok($x11->{renders}->{max_requests}, '<=', $x11->{renders}->{requests},
+       'max_requests <= requests');
+my ($map_request) = grep { $_->{name} eq 'MapRequest' } @{$x11->{events}};
+cmp_ok($map_request->{round_trips}, '>', 0, 'MapRequest events wait for replies');
+my $site = x11_sites($x11)->{'manage.c:xcb_get_geometry_reply'};
+ok(defined($site), 'waits in manage_window are accounted');
+cmp_ok($site->{count}, '>=', 20, 'one wait per window');
+
+cmd 'nop';
+$latency = latency('reset');
+cmp_ok($latency->{stages}->{parse_command}->{count}, '>', 0, 'reset reply has the old numbers');
+
+$latency = latency;
+is($latency->{stages}->{manage_window}->{count}, 0, 'manage_window was reset');
+is($latency->{stages}->{parse_command}->{count}, 0, 'parse_command was reset');
+is($latency->{ipc}->{get_stats}->{count}, 1, 'only the reset request itself was measured');
+ok(!exists($latency->{events}->{MapRequest}), 'event histograms were reset');
+
+$x11 = $i3->message(8, "")->recv->{x11};
+ok(!exists(x11_sites($x11)->{'manage.c:xcb_get_geometry_reply'}), 'call sites were reset');
+ok(!(grep { $_->{name} eq 'MapRequest' } @{$x11->{events}}), 'X11 event statistics were reset');
+
+################################################################################
+# Windows which are adopted on restart are measured, too.
+################################################################################
+
+cmd 'restart';
+does_i3_live;
+
+$i3 = i3(get_socket_path());
+$i3->connect->recv;
+
+$latency = latency;
+cmp_ok($latency->{stages}->{manage_window}->{count}, '>=', scalar @windows,
+       'adopted windows were measured');
+
+done_testing;
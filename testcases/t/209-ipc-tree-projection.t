@@ -0,0 +1,80 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that GET_TREE requests can select the root container, the maximum
+# depth and the fields to dump.
+use i3test;
+use JSON::XS;
+
+my $i3 = i3(get_socket_path());
+$i3->connect->recv;
+
+sub get_tree {
+    my ($request) = @_;
+    return $i3->message(4, encode_json($request))->recv;
+}
+
+my $tmp = fresh_workspace;
+my $first = open_window(name => 'first');
+cmd 'split v';
+my $second = open_window(name => 'second');
+
+my $full = $i3->message(4, "")->recv;
+ok(exists($full->{$_}), "full tree contains $_") for qw(id name rect window_rect geometry swallows);
+
+################################################################################
+# Only the requested fields are dumped.
+################################################################################
+
+my $tree = get_tree({ fields => [ 'id', 'name', 'nodes' ] });
+is_deeply([ sort keys %$tree ], [ qw(id name nodes) ], 'only the requested fields');
+is($tree->{id}, $full->{id}, 'root container by default');
+
+sub names {
+    my ($con) = @_;
+    return ($con->{name}, map { names($_) } @{$con->{nodes}});
+}
+my @names = names($tree);
+ok((grep { $_ eq 'first' } @names) && (grep { $_ eq 'second' } @names),
+   'window names found without floating_nodes and rects');
+
+################################################################################
+# The root and the maximum depth.
+################################################################################
+
+my $ws = get_ws($tmp);
+$tree = get_tree({ root => $ws->{id}, max_depth => 1, fields => [ 'name', 'nodes' ] });
+is($tree->{name}, $tmp, 'workspace is the root');
+is(scalar @{$tree->{nodes}}, 1, 'one split container on the workspace');
+is_deeply($tree->{nodes}->[0]->{nodes}, [], 'children below max_depth are not dumped');
+
+$tree = get_tree({ root => $ws->{id}, max_depth => 0, fields => [ 'name', 'nodes' ] });
+is_deeply($tree->{nodes}, [], 'max_depth 0 dumps only the root');
+
+################################################################################
+# Invalid requests.
+################################################################################
+
+$tree = get_tree({ root => 1 });
+ok(!$tree->{success}, 'unknown root id is rejected');
+
+$tree = get_tree({ fields => [ 'no_such_field' ] });
+ok(!$tree->{success}, 'unknown field is rejected');
+ok(length($tree->{error}) > 0, 'error message is set');
+
+does_i3_live;
+
+done_testing;
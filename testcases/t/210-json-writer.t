@@ -0,0 +1,65 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Tests the standalone JSON writer binary, which generates a tree with both
+# yajl_gen and the libi3 JSON writer and fails if the output differs. Also
+# verifies that the IPC replies are valid JSON when i3 runs with a locale
+# which uses a decimal comma.
+#
+use i3test i3_autostart => 0;
+use IPC::Run qw(run);
+use POSIX qw(setlocale LC_NUMERIC);
+
+my ($stdout, $stderr);
+run [ '../test.json_writer', '1000' ],
+    '>', \$stdout,
+    '2>', \$stderr;
+
+is($?, 0, 'test.json_writer exited successfully');
+is($stderr, '', 'JSON writer output is identical to yajl_gen');
+diag($_) for split("\n", $stdout);
+
+################################################################################
+# The percent values of the tree have to be dumped with a decimal point
+# regardless of LC_NUMERIC.
+################################################################################
+
+my $config = <<EOT;
+# i3 config file (v4)
+font -misc-fixed-medium-r-normal--13-120-75-75-C-70-iso10646-1
+EOT
+
+SKIP: {
+    my $old_locale = setlocale(LC_NUMERIC);
+    my $available = defined(setlocale(LC_NUMERIC, 'de_DE.UTF-8'));
+    setlocale(LC_NUMERIC, $old_locale);
+    skip 'locale de_DE.UTF-8 is not available', 2 unless $available;
+
+    local $ENV{LC_ALL} = 'de_DE.UTF-8';
+    my $pid = launch_with_config($config);
+
+    my $tmp = fresh_workspace;
+    open_window;
+    open_window;
+
+    my $ws = get_ws($tmp);
+    is(scalar @{$ws->{nodes}}, 2, 'two containers, tree parsed as JSON');
+    cmp_ok(abs($ws->{nodes}->[0]->{percent} - 0.5), '<', 0.001, 'percent dumped with a decimal point');
+
+    exit_gracefully($pid);
+}
+
+done_testing;
@@ -0,0 +1,91 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that the tree snapshot in shared memory (i3-msg --snapshot) matches
+# the tree which GET_TREE returns.
+#
+use i3test;
+use IPC::Run qw(run);
+use JSON::XS;
+
+sub snapshot {
+    my ($stdout, $stderr);
+    run [ '../i3-msg/i3-msg', '--snapshot' ],
+        '>', \$stdout,
+        '2>', \$stderr;
+    is($stderr, '', 'i3-msg --snapshot ran without errors');
+    return decode_json($stdout);
+}
+
+# Returns all containers of the GET_TREE reply in pre-order.
+sub flatten {
+    my ($con) = @_;
+    return ($con, map { flatten($_) } (@{$con->{nodes}}, @{$con->{floating_nodes}}));
+}
+
+my $tmp = fresh_workspace;
+my $first = open_window(name => 'first');
+my $second = open_window(name => 'second');
+cmd 'split v';
+open_window(name => 'third');
+cmd 'focus parent';
+cmd 'focus left';
+open_floating_window(name => 'floating');
+sync_with_i3;
+
+my $snapshot = snapshot;
+my @cons = flatten(i3(get_socket_path())->get_tree->recv);
+
+is_deeply([ map { $_->{id} } @{$snapshot->{nodes}} ],
+          [ map { $_->{id} } @cons ],
+          'same containers in the same order');
+
+my %parent;
+for my $con (@cons) {
+    $parent{$_->{id}} = $con->{id} for (@{$con->{nodes}}, @{$con->{floating_nodes}});
+}
+
+my $mismatches = 0;
+for my $i (0 .. $#cons) {
+    my ($con, $node) = ($cons[$i], $snapshot->{nodes}->[$i]);
+    my $expected_focus = (@{$con->{focus}} > 0 ? $con->{focus}->[0] : undef);
+    $mismatches++ unless
+        $node->{name} eq ($con->{name} // '') &&
+        $node->{type} == $con->{type} &&
+        ($node->{parent} // 0) == ($parent{$con->{id}} // 0) &&
+        ($node->{focus} // 0) == ($expected_focus // 0) &&
+        ($node->{urgent} ? 1 : 0) == ($con->{urgent} ? 1 : 0) &&
+        ($node->{window} // 0) == ($con->{window} // 0) &&
+        join(',', @{$node->{rect}}{qw(x y width height)}) eq
+        join(',', @{$con->{rect}}{qw(x y width height)});
+}
+is($mismatches, 0, 'all containers match GET_TREE');
+
+my ($focused) = grep { $_->{focused} } @cons;
+is($snapshot->{focused}, $focused->{id}, 'focused container matches');
+
+################################################################################
+# The snapshot is updated when the tree changes.
+################################################################################
+
+cmd 'kill';
+sync_with_i3;
+my $after = snapshot;
+cmp_ok($after->{sequence}, '>', $snapshot->{sequence}, 'sequence increased');
+is(scalar @{$after->{nodes}}, scalar @{$snapshot->{nodes}} - 2,
+   'killed window (and its floating container) are gone');
+
+done_testing;
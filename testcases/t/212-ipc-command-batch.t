@@ -0,0 +1,152 @@
+#!perl
+# vim:ts=4:sw=4:expandtab
+#
+# Please read the following documents before working on tests:
+# • http://build.i3wm.org/docs/testsuite.html
+#   (or docs/testsuite)
+#
+# • http://build.i3wm.org/docs/lib-i3test.html
+#   (alternatively: perldoc ./testcases/lib/i3test.pm)
+#
+# • http://build.i3wm.org/docs/ipc.html
+#   (or docs/ipc)
+#
+# • http://onyxneon.com/books/modern_perl/modern_perl_a4.pdf
+#   (unless you are already familiar with Perl)
+#
+# Verifies that COMMAND_BATCH executes all commands, replies with the reply of
+# every command, renders the tree once and sends (coalesced) events
+# afterwards.
+use i3test;
+use JSON::XS;
+
+my $i3 = i3(get_socket_path());
+$i3->connect->recv;
+
+sub batch {
+    my ($payload) = @_;
+    return $i3->message(9, ref($payload) ? encode_json($payload) : $payload)->recv;
+}
+
+my $tmp = fresh_workspace;
+
+my $reply = batch([ 'open', 'open', 'split v', 'open', 'layout tabbed', 'nonexistant' ]);
+is(scalar @$reply, 6, 'one reply per command');
+ok((!grep { !$_->[0]->{success} } @$reply[0 .. 4]), 'valid commands succeeded');
+ok(!$reply->[5]->[0]->{success}, 'invalid command failed');
+
+my $ws = get_ws($tmp);
+is(scalar @{$ws->{nodes}}, 2, 'two containers on the workspace');
+is($ws->{nodes}->[1]->{layout}, 'tabbed', 'split container is tabbed');
+is(scalar @{$ws->{nodes}->[1]->{nodes}}, 2, 'two containers in the split container');
+
+################################################################################
+# Invalid batches are rejected without executing anything.
+################################################################################
+
+for my $invalid ('"open"', '["open", 1]', '[["open"]]', '{"open": true}', 'garbage') {
+    $reply = batch($invalid);
+    ok(!$reply->{success}, "batch $invalid rejected");
+    ok(defined($reply->{error}), 'error message included');
+}
+is(scalar @{get_ws($tmp)->{nodes}}, 2, 'no command of an invalid batch executed');
+
+################################################################################
+# Events are sent after the batch, identical events only once.
+################################################################################
+
+my @events;
+my $events_i3 = i3(get_socket_path());
+$events_i3->connect->recv;
+$events_i3->subscribe({
+    workspace => sub {
+        my ($event) = @_;
+        push @events, $event->{change};
+    }
+})->recv;
+
+my $other = get_unused_workspace;
+batch([ "workspace $other", 'open', "workspace $tmp", "workspace $other" ]);
+sync_with_i3;
+# Give the events connection a chance to receive everything.
+my $cv = AnyEvent->condvar;
+my $timer = AnyEvent->timer(after => 0.2, cb => sub { $cv->send });
+$cv->recv;
+
+is(scalar (grep { $_ eq 'init' } @events), 1, 'one init event');
+ok(scalar (grep { $_ eq 'focus' } @events) >= 1, 'focus events received');
+
+################################################################################
+# Only consecutive identical events are coalesced: switching A → B → A → B
+# generates the same focus events twice, but none of them may be dropped,
+# otherwise subscribers would end up with the wrong workspace focused.
+################################################################################
+
+my @focus;
+my $focus_i3 = i3(get_socket_path());
+$focus_i3->connect->recv;
+$focus_i3->subscribe({
+    workspace => sub {
+        my ($event) = @_;
+        push @focus, $event->{current}->{name} if $event->{change} eq 'focus';
+    }
+})->recv;
+
+my $ws_a = fresh_workspace;
+open_window;
+my $ws_b = fresh_workspace;
+open_window;
+cmd "workspace $ws_a";
+sync_with_i3;
+
+$cv = AnyEvent->condvar;
+$timer = AnyEvent->timer(after => 0.2, cb => sub { $cv->send });
+$cv->recv;
+@focus = ();
+
+batch([ "workspace $ws_b", "workspace $ws_a", "workspace $ws_b" ]);
+sync_with_i3;
+$cv = AnyEvent->condvar;
+$timer = AnyEvent->timer(after => 0.2, cb => sub { $cv->send });
+$cv->recv;
+
+is_deeply(\@focus, [ $ws_b, $ws_a, $ws_b ], 'focus events sent in order, none dropped');
+is(focused_ws, $ws_b, 'last focus event matches the focused workspace');
+
+################################################################################
+# Identical consecutive mode events are coalesced: they describe the whole
+# state, so the second one says nothing new.
+################################################################################
+
+my @modes;
+my $mode_i3 = i3(get_socket_path());
+$mode_i3->connect->recv;
+$mode_i3->subscribe({
+    mode => sub {
+        my ($event) = @_;
+        push @modes, $event->{change};
+    }
+})->recv;
+
+batch([ 'mode default', 'mode default', 'nop', 'mode default' ]);
+sync_with_i3;
+$cv = AnyEvent->condvar;
+$timer = AnyEvent->timer(after => 0.2, cb => sub { $cv->send });
+$cv->recv;
+
+is_deeply(\@modes, [ 'default' ], 'identical mode events coalesced');
+
+################################################################################
+# The batch is rendered once, even though kill renders the tree on its own.
+################################################################################
+
+fresh_workspace;
+sync_with_i3;
+$i3->message(8, 'reset')->recv;
+
+batch([ 'open', 'open', 'kill', 'kill' ]);
+
+my $x11 = $i3->message(8, '')->recv->{x11};
+is($x11->{renders}->{count}, 1, 'batch rendered once');
+
+done_testing;